@@ -1,11 +1,16 @@
 #include "Apploader.hpp"
+#include "Heap.hpp"
 #include <AddressMap.h>
 #include <CPUCache.hpp>
 #include <DI.hpp>
 #include <DOL.hpp>
+#include <IOS.hpp>
 #include <Import_RVL_OS.h>
 #include <LoMem.hpp>
 #include <Log.hpp>
+#include <MemorySearch.hpp>
+#include <PatchManager.hpp>
+#include <cstdio>
 #include <cstring>
 #include <magic_enum.hpp>
 #include <optional>
@@ -39,7 +44,17 @@ struct PartitionOffsets {
     FILL(0x10, 0x20); // Alignment
 };
 
-extern "C" void RunDOL(DOL* dol);
+// A memory patch outside the DOL sections, which RunDOL applies at its game
+// address once the DOL is in place
+struct RunPatch {
+    u32 address;
+    const u8* value;
+    u32 length;
+};
+
+static_assert(sizeof(RunPatch) == 0xC);
+
+extern "C" void RunDOL(DOL* dol, const RunPatch* patches, u32 patchCount);
 
 static void ShutdownOS()
 {
@@ -56,8 +71,568 @@ static void ShutdownOS()
     }
 }
 
+/**
+ * Get where a range of game memory is in the DOL as it's loaded, before
+ * RunDOL copies the sections into place.
+ * @returns nullptr if the range isn't all in one section.
+ */
+static u8* GetLoadAddress(const DOL* dol, u32 address, u32 length)
+{
+    for (u32 i = 0; i < DOL::SECTION_COUNT; i++) {
+        const u32 start = dol->sectionAddr[i];
+        const u32 size = dol->sectionSize[i];
+        if (size != 0 && address >= start && length <= size &&
+            address - start <= size - length) {
+            return reinterpret_cast<u8*>(
+                LOAD_DOL_ADDRESS + dol->section[i] + (address - start)
+            );
+        }
+    }
+
+    return nullptr;
+}
+
+/**
+ * Check if any of a range of game memory is in a DOL section.
+ */
+static bool OverlapsDOL(const DOL* dol, u32 address, u32 length)
+{
+    for (u32 i = 0; i < DOL::SECTION_COUNT; i++) {
+        const u32 start = dol->sectionAddr[i];
+        const u32 size = dol->sectionSize[i];
+        if (size != 0 && address < start + size && start < address + length) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Check if a memory patch is applied by RunDOL rather than to the loaded DOL,
+ * as it's in MEM1 but outside the DOL sections, like the low memory globals,
+ * the BSS or the arena.
+ */
+static bool IsRunPatch(const DOL* dol, u32 address, u32 length)
+{
+    return length != 0 &&
+           CheckBounds(0x80000000, 0x01800000, address, length) &&
+           !OverlapsDOL(dol, address, length);
+}
+
+/**
+ * Find the address of every Riivolution memory patch with search set, with
+ * one scan over the loaded DOL.
+ * @param patches Patches in the same order as the memory patches. Ones not
+ * found are left with no address.
+ */
+static void SearchMemoryPatches(const DOL* dol, MemoryPatcher::Patch* patches)
+{
+    const u32 count = PatchManager::s_memoryPatchCount;
+
+    u32 searchCount = 0;
+    for (u32 i = 0; i < count; i++) {
+        if (PatchManager::s_memoryPatches[i].search) {
+            searchCount++;
+        }
+    }
+
+    if (searchCount == 0) {
+        return;
+    }
+
+    auto* patterns = static_cast<MemorySearch::Pattern*>(
+        Heap::AllocMEM2(searchCount * sizeof(MemorySearch::Pattern), 32)
+    );
+    void* work = Heap::AllocMEM2(MemorySearch::GetWorkSize(searchCount), 32);
+    if (patterns == nullptr || work == nullptr) {
+        PRINT(BS2, ERROR, "Failed to allocate memory search");
+        if (patterns != nullptr) {
+            Heap::FreeMEM2(patterns);
+        }
+        if (work != nullptr) {
+            Heap::FreeMEM2(work);
+        }
+        return;
+    }
+
+    for (u32 i = 0, j = 0; i < count; i++) {
+        const PatchManager::MemoryPatch* memoryPatch =
+            &PatchManager::s_memoryPatches[i];
+        if (memoryPatch->search) {
+            patterns[j++] = {
+                .data = memoryPatch->pattern,
+                .length = memoryPatch->patternLength,
+                .align = memoryPatch->align,
+                .match = nullptr,
+            };
+        }
+    }
+
+    // Search each section at its own game address, in address order, so a
+    // match can't span two sections that happen to be contiguous in the
+    // loaded DOL, and the alignment is checked where the game will see it
+    u32 order[DOL::SECTION_COUNT];
+    u32 sectionCount = 0;
+    for (u32 i = 0; i < DOL::SECTION_COUNT; i++) {
+        if (dol->sectionSize[i] == 0) {
+            continue;
+        }
+
+        u32 j = sectionCount++;
+        for (; j > 0 && dol->sectionAddr[order[j - 1]] > dol->sectionAddr[i];
+             j--) {
+            order[j] = order[j - 1];
+        }
+        order[j] = i;
+    }
+
+    // The sections are loaded at their offsets in the DOL file
+    const u8* base = reinterpret_cast<const u8*>(dol);
+
+    MemorySearch search(patterns, searchCount, work);
+    for (u32 i = 0; i < sectionCount; i++) {
+        const u8* start = base + dol->section[order[i]];
+        search.Search(
+            start, start + dol->sectionSize[order[i]],
+            dol->sectionAddr[order[i]]
+        );
+    }
+
+    for (u32 i = 0, j = 0; i < count; i++) {
+        if (!PatchManager::s_memoryPatches[i].search) {
+            continue;
+        }
+
+        const u8* match = patterns[j++].match;
+        if (match == nullptr) {
+            PRINT(BS2, WARN, "Memory patch search not found");
+            continue;
+        }
+
+        // The patch itself must also fit in the section the match is in
+        for (u32 k = 0; k < sectionCount; k++) {
+            const u8* start = base + dol->section[order[k]];
+            const u32 size = dol->sectionSize[order[k]];
+            if (match < start || match >= start + size) {
+                continue;
+            }
+
+            const u32 left = static_cast<u32>(start + size - match);
+            if (patches[i].length <= left) {
+                patches[i].address = const_cast<u8*>(match);
+            }
+            break;
+        }
+
+        if (patches[i].address == nullptr) {
+            PRINT(BS2, WARN, "Memory patch search match runs past its section");
+        }
+    }
+
+    Heap::FreeMEM2(work);
+    Heap::FreeMEM2(patterns);
+}
+
+/**
+ * Apply the Riivolution memory patches to the loaded DOL as one batch.
+ */
+static void ApplyMemoryPatches(const DOL* dol)
+{
+    const u32 count = PatchManager::s_memoryPatchCount;
+    auto* patches = static_cast<MemoryPatcher::Patch*>(
+        Heap::AllocMEM2(count * sizeof(MemoryPatcher::Patch), 32)
+    );
+    if (patches == nullptr) {
+        PRINT(BS2, ERROR, "Failed to allocate memory patches");
+        return;
+    }
+
+    for (u32 i = 0; i < count; i++) {
+        const PatchManager::MemoryPatch* memoryPatch =
+            &PatchManager::s_memoryPatches[i];
+        patches[i] = memoryPatch->patch;
+        if (memoryPatch->search) {
+            continue;
+        }
+
+        // Patches outside the DOL are left for RunDOL, see GetRunPatches
+        const u32 address = reinterpret_cast<u32>(patches[i].address);
+        const u32 length = patches[i].length;
+        patches[i].address = GetLoadAddress(dol, address, length);
+        if (patches[i].address != nullptr || IsRunPatch(dol, address, length)) {
+            continue;
+        }
+
+        if (!CheckBounds(0x80000000, 0x01800000, address, length)) {
+            PRINT(BS2, WARN, "Memory patch at %08X is outside MEM1", address);
+        } else {
+            PRINT(
+                BS2, WARN, "Memory patch at %08X crosses a DOL section", address
+            );
+        }
+    }
+
+    SearchMemoryPatches(dol, patches);
+
+    // Drop the patches with no address, keeping the document order
+    u32 patchCount = 0;
+    for (u32 i = 0; i < count; i++) {
+        if (patches[i].address != nullptr) {
+            patches[patchCount++] = patches[i];
+        }
+    }
+
+    MemoryPatcher::Apply(patches, patchCount);
+    Heap::FreeMEM2(patches);
+}
+
+/**
+ * Get a byte of game memory as it will be when RunDOL applies the next memory
+ * patch, after it has cleared the BSS and applied the patches before it.
+ */
+static u8 GetRunByte(
+    const DOL* dol, u32 address, const RunPatch* patches, u32 count
+)
+{
+    for (u32 i = count; i-- > 0;) {
+        if (address - patches[i].address < patches[i].length) {
+            return patches[i].value[address - patches[i].address];
+        }
+    }
+
+    // The BSS is cleared a whole cache line at a time
+    const u32 bss = AlignDown(dol->bssAddr, 32);
+    if (address - bss < (dol->bssSize & ~31)) {
+        return 0;
+    }
+
+    return *reinterpret_cast<const u8*>(address);
+}
+
+/**
+ * Get the Riivolution memory patches outside the DOL sections, for RunDOL to
+ * apply at their game addresses once the DOL is in place. Their originals are
+ * checked here, in document order, against memory as it will be then, so this
+ * must run after everything else has been written to memory.
+ * @returns A table in MEM2, as copying the DOL can overwrite the patch pool,
+ * or nullptr if there are none.
+ */
+static RunPatch* GetRunPatches(const DOL* dol, u32* count)
+{
+    *count = 0;
+
+    u32 patchCount = 0;
+    u32 dataSize = 0;
+    for (u32 i = 0; i < PatchManager::s_memoryPatchCount; i++) {
+        const PatchManager::MemoryPatch* memoryPatch =
+            &PatchManager::s_memoryPatches[i];
+        const u32 address = reinterpret_cast<u32>(memoryPatch->patch.address);
+        if (!memoryPatch->search &&
+            IsRunPatch(dol, address, memoryPatch->patch.length)) {
+            patchCount++;
+            dataSize += memoryPatch->patch.length;
+        }
+    }
+
+    if (patchCount == 0) {
+        return nullptr;
+    }
+
+    auto* patches = static_cast<RunPatch*>(
+        Heap::AllocMEM2(patchCount * sizeof(RunPatch) + dataSize, 32)
+    );
+    if (patches == nullptr) {
+        PRINT(BS2, ERROR, "Failed to allocate memory patches");
+        return nullptr;
+    }
+
+    u8* data = reinterpret_cast<u8*>(patches + patchCount);
+    for (u32 i = 0; i < PatchManager::s_memoryPatchCount; i++) {
+        const PatchManager::MemoryPatch* memoryPatch =
+            &PatchManager::s_memoryPatches[i];
+        const MemoryPatcher::Patch* patch = &memoryPatch->patch;
+        const u32 address = reinterpret_cast<u32>(patch->address);
+        if (memoryPatch->search || !IsRunPatch(dol, address, patch->length)) {
+            continue;
+        }
+
+        bool matches = true;
+        for (u32 j = 0; patch->original != nullptr && j < patch->length; j++) {
+            if (GetRunByte(dol, address + j, patches, *count) !=
+                patch->original[j]) {
+                matches = false;
+                break;
+            }
+        }
+
+        if (!matches) {
+            PRINT(
+                BS2, WARN, "Memory patch at %08X doesn't match original",
+                address
+            );
+            continue;
+        }
+
+        std::memcpy(data, patch->value, patch->length);
+        patches[(*count)++] = {
+            .address = address,
+            .value = data,
+            .length = patch->length,
+        };
+        data += patch->length;
+    }
+
+    return patches;
+}
+
+/**
+ * Get the size of the external file of each modification in a batch. Files
+ * that aren't found get an empty external path, which drops the modification.
+ */
+static void GetExternalSizes(
+    FSTBuilder::Modification* mods, EmuDITypes::FilePatch* filePatches,
+    const u32* batch, u32 count, const char* const* paths
+)
+{
+    constexpr u32 MaxBatch = ISFS::EX_READ_FILES_MAX_COUNT;
+    void* buffers[MaxBatch] = {};
+    u32 sizes[MaxBatch] = {};
+    s32 results[MaxBatch];
+
+    s32 ret = IOS::ReadFiles(count, paths, buffers, sizes, results);
+    for (u32 i = 0; i < count; i++) {
+        FSTBuilder::Modification* mod = &mods[batch[i]];
+        EmuDITypes::FilePatch* patch = &filePatches[batch[i]];
+
+        const s32 result = ret == ISFS::ISFSError::OK ? results[i] : ret;
+        if (result < 0) {
+            PRINT(
+                BS2, WARN, "Failed to find external file '%s': %d", paths[i],
+                result
+            );
+            patch->externalPath[0] = '\0';
+            continue;
+        }
+
+        // The size is the data used from the file
+        mod->size = static_cast<u32>(result) > patch->file_offset
+                        ? static_cast<u32>(result) - patch->file_offset
+                        : 0;
+        if (patch->length != 0 && mod->size > patch->length) {
+            mod->size = patch->length;
+        }
+    }
+}
+
+/**
+ * Set the FST modifications from the file and shift nodes of the Riivolution
+ * patches the loader loaded.
+ */
+bool Apploader::SetRiivolutionModifications()
+{
+    const u32 nodeCount = PatchManager::s_discNodeCount;
+    auto* mods = static_cast<FSTBuilder::Modification*>(
+        Heap::AllocMEM2(nodeCount * sizeof(FSTBuilder::Modification), 32)
+    );
+    auto* filePatches = static_cast<EmuDITypes::FilePatch*>(
+        Heap::AllocMEM2(nodeCount * sizeof(EmuDITypes::FilePatch), 32)
+    );
+    if (mods == nullptr || filePatches == nullptr) {
+        PRINT(BS2, ERROR, "Failed to allocate FST modifications");
+        if (mods != nullptr) {
+            Heap::FreeMEM2(mods);
+        }
+        if (filePatches != nullptr) {
+            Heap::FreeMEM2(filePatches);
+        }
+        return false;
+    }
+
+    for (u32 i = 0; i < nodeCount; i++) {
+        const PatchManager::DiscNode* discNode = &PatchManager::s_discNodes[i];
+        FSTBuilder::Modification* mod = &mods[i];
+        EmuDITypes::FilePatch* patch = &filePatches[i];
+        *mod = {};
+        *patch = {};
+
+        if (auto* shiftNode = std::get_if<PatchUnitRiivolution::ShiftNode>(
+                &discNode->node
+            )) {
+            mod->op = FSTBuilder::Op::SHIFT;
+            mod->path = shiftNode->destination;
+            mod->source = shiftNode->source;
+            continue;
+        }
+
+        const auto& fileNode =
+            std::get<PatchUnitRiivolution::FileNode>(discNode->node);
+        mod->op = fileNode.create ? FSTBuilder::Op::CREATE
+                                  : FSTBuilder::Op::REPLACE;
+        mod->resize = fileNode.resize;
+        mod->path = fileNode.disc;
+        patch->file_offset = fileNode.fileoffset;
+        patch->length = fileNode.length;
+
+        if (fileNode.offset != 0) {
+            PRINT(
+                BS2, WARN, "Patching part of a disc file is not supported: %s",
+                fileNode.disc
+            );
+            continue;
+        }
+
+        const char* separator = fileNode.external[0] == '/' ? "" : "/";
+        if (std::snprintf(
+                patch->externalPath, sizeof(patch->externalPath), "%u:%s%s",
+                discNode->drive, separator, fileNode.external
+            ) >= static_cast<s32>(sizeof(patch->externalPath))) {
+            PRINT(BS2, WARN, "External path too long: %s", fileNode.external);
+            patch->externalPath[0] = '\0';
+        }
+    }
+
+    // Get the file sizes a batch at a time, on the EmuFS mount of the drive
+    constexpr u32 MaxBatch = ISFS::EX_READ_FILES_MAX_COUNT;
+    constexpr u32 PathLength = sizeof(EmuDITypes::FilePatch::externalPath) + 8;
+    char(*isfsPaths)[PathLength] = static_cast<char(*)[PathLength]>(
+        Heap::AllocMEM2(MaxBatch * PathLength, 32)
+    );
+    if (isfsPaths == nullptr) {
+        PRINT(BS2, ERROR, "Failed to allocate external paths");
+        Heap::FreeMEM2(mods);
+        Heap::FreeMEM2(filePatches);
+        return false;
+    }
+
+    const char* paths[MaxBatch];
+    u32 batch[MaxBatch];
+    u32 batchCount = 0;
+
+    for (u32 i = 0; i < nodeCount; i++) {
+        const char* externalPath = filePatches[i].externalPath;
+        if (mods[i].op != FSTBuilder::Op::SHIFT && externalPath[0] != '\0') {
+            std::snprintf(
+                isfsPaths[batchCount], PathLength, "/mnt/%s%s",
+                PatchManager::GetMountName(externalPath[0] - '0'),
+                externalPath + 2
+            );
+            paths[batchCount] = isfsPaths[batchCount];
+            batch[batchCount++] = i;
+        }
+
+        if (batchCount == MaxBatch ||
+            (batchCount != 0 && i + 1 == nodeCount)) {
+            GetExternalSizes(mods, filePatches, batch, batchCount, paths);
+            batchCount = 0;
+        }
+    }
+
+    Heap::FreeMEM2(isfsPaths);
+
+    // Drop the files that can't be patched
+    u32 modCount = 0;
+    for (u32 i = 0; i < nodeCount; i++) {
+        if (mods[i].op != FSTBuilder::Op::SHIFT &&
+            filePatches[i].externalPath[0] == '\0') {
+            continue;
+        }
+
+        mods[modCount] = mods[i];
+        filePatches[modCount] = filePatches[i];
+        modCount++;
+    }
+
+    SetFSTModifications(mods, filePatches, modCount);
+    return true;
+}
+
+/**
+ * Send the DVD patches of the files the FST builder placed, once it has given
+ * them their offsets.
+ */
+bool Apploader::PatchFiles(DI* di)
+{
+    // Only files with new data have a patch. They're in the order of the
+    // modifications, which is disc offset order.
+    u32 count = 0;
+    for (u32 i = 0; i < m_fstModCount; i++) {
+        const FSTBuilder::Modification* mod = &m_fstMods[i];
+        if (mod->op == FSTBuilder::Op::SHIFT || mod->entry == 0) {
+            continue;
+        }
+
+        EmuDITypes::FilePatch* patch = &m_filePatches[count++];
+        *patch = m_filePatches[i];
+        patch->disc_offset = mod->offset;
+        if (patch->length == 0 || patch->length > mod->length) {
+            patch->length = mod->length;
+        }
+    }
+
+    if (count == 0) {
+        return true;
+    }
+
+    const s32 ret = di->ProxyPatchFiles(m_filePatches, count);
+    if (ret < 0) {
+        PRINT(BS2, ERROR, "Failed to patch files: %d", ret);
+        return false;
+    }
+
+    PRINT(BS2, INFO, "Patched files, %d DVD patches", ret);
+    return true;
+}
+
+/**
+ * Expand the Riivolution folder nodes against the FST in memory. The emulated
+ * drive rewrites the FST and adds a DVD patch for every file replaced.
+ * @param nextOffset Patched word offset to place the first file at.
+ */
+static bool PatchFolders(DI* di, void* fst, u32 fstSize, u32 nextOffset)
+{
+    // The size of the root entry is the entry count
+    const u32 entryCount = static_cast<const u32*>(fst)[2];
+    if (entryCount == 0 || entryCount > fstSize / 0xC) {
+        PRINT(BS2, ERROR, "Invalid FST entry count: %u", entryCount);
+        return false;
+    }
+
+    u32 indexSize = 1;
+    while (indexSize <= entryCount) {
+        indexSize <<= 1;
+    }
+
+    auto* index = static_cast<EmuDITypes::FSTIndexSlot*>(Heap::AllocMEM2(
+        indexSize * sizeof(EmuDITypes::FSTIndexSlot), 32
+    ));
+    if (index == nullptr) {
+        PRINT(BS2, ERROR, "Failed to allocate FST index");
+        return false;
+    }
+
+    const s32 ret = di->ProxyPatchFolders(
+        PatchManager::s_folderPatches, PatchManager::s_folderPatchCount,
+        nextOffset, fst, fstSize, index, indexSize
+    );
+    Heap::FreeMEM2(index);
+
+    if (ret < 0) {
+        PRINT(BS2, ERROR, "Failed to patch folders: %d", ret);
+        return false;
+    }
+
+    PRINT(BS2, INFO, "Patched folders, %d DVD patches", ret);
+    return true;
+}
+
 void Apploader::Load()
 {
+    if (m_fstModCount == 0 && PatchManager::s_discNodeCount != 0 &&
+        !SetRiivolutionModifications()) {
+        return;
+    }
+
     DI di("/dev/di");
 
     DI::DiskID* diskID = reinterpret_cast<DI::DiskID*>(0x80000000);
@@ -204,23 +779,88 @@ void Apploader::Load()
         }
     }
 
+    if (PatchManager::s_memoryPatchCount != 0) {
+        ApplyMemoryPatches(dol);
+    }
+
     // Read the FST
     u32 fstSize = hdrOffsets.fstSize << 2;
+    u8* fst = nullptr;
+    std::optional<FSTBuilder> fstBuilder;
+
+    if (m_fstModCount != 0) {
+        // The FST is rebuilt from a copy, as it may grow
+        fst = static_cast<u8*>(Heap::AllocMEM2(AlignUp(fstSize, 32), 32));
+        if (fst == nullptr) {
+            PRINT(BS2, ERROR, "Failed to allocate FST copy");
+            return;
+        }
+
+        retDi = di.Read(fst, AlignUp(fstSize, 32), hdrOffsets.fstOffset);
+        if (retDi != DI::DIError::OK) {
+            PRINT(
+                BS2, ERROR, "Failed to read FST: 0x%X (%s)", retDi,
+                magic_enum::enum_name(retDi).data()
+            );
+            Heap::FreeMEM2(fst);
+            return;
+        }
+
+        fstBuilder.emplace(fst, fstSize, m_fstMods, m_fstModCount);
+        if (!fstBuilder->IsValid()) {
+            Heap::FreeMEM2(fst);
+            return;
+        }
+
+        fstSize = fstBuilder->GetMaxSize();
+    }
+
     u32 fstDest = AlignDown(0x81800000 - fstSize, 32);
     if (fstDest < 0x81700000) {
         PRINT(BS2, ERROR, "FST size is too large");
+        if (fst != nullptr) {
+            Heap::FreeMEM2(fst);
+        }
         return;
     }
 
     gLoMem.systemInfo.fstStart = reinterpret_cast<void*>(fstDest);
-    retDi = di.Read(
-        gLoMem.systemInfo.fstStart, AlignUp(fstSize, 32), hdrOffsets.fstOffset
-    );
-    if (retDi != DI::DIError::OK) {
-        PRINT(
-            BS2, ERROR, "Failed to read FST: 0x%X (%s)", retDi,
-            magic_enum::enum_name(retDi).data()
+
+    // Files with new data are placed from here, first by the FST builder and
+    // then by the folder patches
+    u32 nextOffset = EmuDITypes::PATCHED_OFFSET;
+
+    if (fstBuilder) {
+        fstSize = fstBuilder->Build(
+            static_cast<u8*>(gLoMem.systemInfo.fstStart), &nextOffset
+        );
+        fstBuilder.reset();
+        Heap::FreeMEM2(fst);
+
+        if (fstSize == 0) {
+            PRINT(BS2, ERROR, "Failed to rebuild FST");
+            return;
+        }
+
+        if (!PatchFiles(&di)) {
+            return;
+        }
+    } else {
+        retDi = di.Read(
+            gLoMem.systemInfo.fstStart, AlignUp(fstSize, 32),
+            hdrOffsets.fstOffset
         );
+        if (retDi != DI::DIError::OK) {
+            PRINT(
+                BS2, ERROR, "Failed to read FST: 0x%X (%s)", retDi,
+                magic_enum::enum_name(retDi).data()
+            );
+            return;
+        }
+    }
+
+    if (PatchManager::s_folderPatchCount != 0 &&
+        !PatchFolders(&di, gLoMem.systemInfo.fstStart, fstSize, nextOffset)) {
         return;
     }
 
@@ -247,6 +887,11 @@ void Apploader::Load()
     gLoMem.osGlobals.mem1ArenaEnd = fstDest;
     gLoMem.osGlobals.mem2UsableStart = 0x90000800;
 
+    const s32 ret = di.ProxyStartGame();
+    if (ret != IOS::IOSError::OK) {
+        PRINT(BS2, ERROR, "Failed to start game on DI: %d", ret);
+    }
+
     ShutdownOS();
 
     gLoMem.threadInfo.debugMonitorAddress = 0x81800000;
@@ -259,7 +904,10 @@ void Apploader::Load()
 
     gLoMem.systemInfo.arenaHigh = 0;
 
-    RunDOL(dol);
+    u32 runPatchCount = 0;
+    const RunPatch* runPatches = GetRunPatches(dol, &runPatchCount);
+
+    RunDOL(dol, runPatches, runPatchCount);
 
     while (true) {
     }
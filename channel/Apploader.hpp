@@ -1,5 +1,9 @@
 #pragma once
 
+#include "FSTBuilder.hpp"
+#include <DI.hpp>
+#include <EmuDITypes.hpp>
+
 class Apploader
 {
 public:
@@ -12,5 +16,30 @@ public:
     Apploader(const Apploader&) = delete;
     Apploader() = default;
 
+    /**
+     * Set the FST modifications to apply to the next game loaded. They are
+     * written back with their patched offsets.
+     * @param filePatches The external file of each REPLACE and CREATE, with
+     * the most data to use from it in length, or 0 for no limit. The patches
+     * are completed and sent to the drive once the FST is built.
+     */
+    void SetFSTModifications(
+        FSTBuilder::Modification* mods, EmuDITypes::FilePatch* filePatches,
+        u32 count
+    )
+    {
+        m_fstMods = mods;
+        m_filePatches = filePatches;
+        m_fstModCount = count;
+    }
+
     void Load();
+
+private:
+    bool SetRiivolutionModifications();
+    bool PatchFiles(DI* di);
+
+    FSTBuilder::Modification* m_fstMods = nullptr;
+    EmuDITypes::FilePatch* m_filePatches = nullptr;
+    u32 m_fstModCount = 0;
 };
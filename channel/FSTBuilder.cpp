@@ -0,0 +1,392 @@
+#include "FSTBuilder.hpp"
+#include <Log.hpp>
+#include <Util.h>
+#include <cctype>
+#include <cstring>
+
+static constexpr u32 FNVBasis = 0x811C9DC5;
+
+/**
+ * Continue the FNV-1a hash of a directory path with the name of one of its
+ * entries. The disc is case insensitive, so the name is hashed in lower case.
+ */
+static u32 HashName(u32 hash, const char* name, u32 length)
+{
+    hash = (hash ^ '/') * 0x01000193;
+    for (u32 i = 0; i < length; i++) {
+        hash = (hash ^ static_cast<u8>(tolower(name[i]))) * 0x01000193;
+    }
+    return hash;
+}
+
+/**
+ * Compare an FST name to a path component, ignoring case.
+ */
+static bool NameEquals(const char* fstName, const char* name, u32 length)
+{
+    for (u32 i = 0; i < length; i++) {
+        if (tolower(fstName[i]) != tolower(name[i])) {
+            return false;
+        }
+    }
+    return fstName[length] == '\0';
+}
+
+/**
+ * Get the last component of a path.
+ */
+static const char*
+GetLastComponent(const char* path, u32 pathLength, u32* length)
+{
+    u32 start = pathLength;
+    while (start > 0 && path[start - 1] != '/') {
+        start--;
+    }
+
+    *length = pathLength - start;
+    return path + start;
+}
+
+/**
+ * Get the length of a path without its trailing slashes.
+ */
+static u32 GetPathLength(const char* path)
+{
+    u32 length = std::strlen(path);
+    while (length > 0 && path[length - 1] == '/') {
+        length--;
+    }
+    return length;
+}
+
+FSTBuilder::FSTBuilder(
+    const u8* fst, u32 fstSize, Modification* mods, u32 modCount
+)
+  : m_fst(reinterpret_cast<const Entry*>(fst))
+  , m_mods(mods)
+  , m_modCount(modCount)
+{
+    if (fstSize < sizeof(Entry) || !m_fst[0].isDir) {
+        PRINT(Riivo, ERROR, "Invalid FST root");
+        return;
+    }
+
+    // The size of the root entry is the entry count
+    m_entryCount = m_fst[0].dir.next;
+    if (m_entryCount == 0 || m_entryCount > fstSize / sizeof(Entry)) {
+        PRINT(Riivo, ERROR, "Invalid FST entry count: %u", m_entryCount);
+        return;
+    }
+
+    m_names =
+        reinterpret_cast<const char*>(fst) + m_entryCount * sizeof(Entry);
+    m_namesSize = fstSize - m_entryCount * sizeof(Entry);
+
+    // Key indices are stored + 1 in a u16
+    if (modCount * 2 >= 0xFFFF) {
+        PRINT(Riivo, ERROR, "Too many FST modifications: %u", modCount);
+        return;
+    }
+
+    u32 slotCount = 16;
+    while (slotCount < modCount * 4) {
+        slotCount <<= 1;
+    }
+
+    m_keys = new Key[modCount * 2];
+    m_slots = new u16[slotCount];
+    m_slotMask = slotCount - 1;
+    m_sources = new Entry[modCount];
+    std::memset(m_slots, 0, slotCount * sizeof(u16));
+
+    m_createCount = 0;
+    m_createNamesSize = 0;
+
+    for (u32 i = 0; i < modCount; i++) {
+        Modification* mod = &mods[i];
+
+        // Paths are relative to the FST root
+        const char* path = mod->path;
+        while (*path == '/') {
+            path++;
+        }
+        const u32 pathLength = GetPathLength(path);
+        if (pathLength == 0) {
+            PRINT(Riivo, ERROR, "Invalid FST modification path");
+            continue;
+        }
+
+        AddKey(path, pathLength, i, Role::TARGET);
+
+        if (mod->op == Op::CREATE) {
+            u32 nameLength;
+            const char* name =
+                GetLastComponent(path, pathLength, &nameLength);
+            u32 parentLength = name - path;
+            while (parentLength > 0 && path[parentLength - 1] == '/') {
+                parentLength--;
+            }
+
+            AddKey(path, parentLength, i, Role::PARENT);
+            m_createCount++;
+            m_createNamesSize += nameLength + 1;
+        } else if (mod->op == Op::SHIFT && mod->source != nullptr) {
+            const char* source = mod->source;
+            while (*source == '/') {
+                source++;
+            }
+            AddKey(source, GetPathLength(source), i, Role::SOURCE);
+        }
+    }
+
+    m_valid = true;
+}
+
+FSTBuilder::~FSTBuilder()
+{
+    delete[] m_keys;
+    delete[] m_slots;
+    delete[] m_sources;
+}
+
+/**
+ * Index a path a modification is interested in.
+ * @param path The path, without the leading and trailing slashes.
+ */
+void FSTBuilder::AddKey(const char* path, u32 pathLength, u16 mod, Role role)
+{
+    u32 hash = FNVBasis;
+    for (u32 start = 0; start < pathLength;) {
+        u32 end = start;
+        while (end < pathLength && path[end] != '/') {
+            end++;
+        }
+
+        if (end != start) {
+            hash = HashName(hash, path + start, end - start);
+        }
+        start = end + 1;
+    }
+
+    Key* key = &m_keys[m_keyCount];
+    key->hash = hash;
+    key->mod = mod;
+    key->role = role;
+    key->name = GetLastComponent(path, pathLength, &key->nameLength);
+
+    u32 slot = hash & m_slotMask;
+    while (m_slots[slot] != 0) {
+        slot = (slot + 1) & m_slotMask;
+    }
+    m_slots[slot] = ++m_keyCount;
+}
+
+/**
+ * Get the name of an FST entry, or nullptr if it's out of bounds.
+ */
+const char* FSTBuilder::GetName(u32 entry) const
+{
+    const u32 offset = m_fst[entry].stringOffset;
+    if (offset >= m_namesSize ||
+        std::memchr(m_names + offset, '\0', m_namesSize - offset) == nullptr) {
+        return nullptr;
+    }
+
+    return m_names + offset;
+}
+
+u32 FSTBuilder::GetMaxSize() const
+{
+    return (m_entryCount + m_createCount) * sizeof(Entry) + m_namesSize +
+           m_createNamesSize;
+}
+
+/**
+ * Add the files created in a directory once all of its entries have been
+ * copied, then link the directory to the entry after it.
+ * @param dirIndex Index of the directory in the output.
+ */
+void FSTBuilder::CloseDir(Entry* out, u32 dirHash, u32 dirIndex)
+{
+    const char* dirName =
+        dirIndex == 0 ? nullptr : m_names + out[dirIndex].stringOffset;
+
+    for (u32 slot = dirHash & m_slotMask; m_slots[slot] != 0;
+         slot = (slot + 1) & m_slotMask) {
+        const Key* key = &m_keys[m_slots[slot] - 1];
+        if (key->hash != dirHash || key->role != Role::PARENT) {
+            continue;
+        }
+
+        // The root has no name
+        if (dirName == nullptr
+                ? key->nameLength != 0
+                : !NameEquals(dirName, key->name, key->nameLength)) {
+            continue;
+        }
+
+        // The file already exists
+        Modification* mod = &m_mods[key->mod];
+        if (mod->entry != 0) {
+            continue;
+        }
+
+        const char* path = mod->path;
+        u32 nameLength;
+        GetLastComponent(path, GetPathLength(path), &nameLength);
+
+        mod->entry = m_outCount++;
+        out[mod->entry] = {
+            .isDir = 0,
+            .stringOffset = m_namesSize + m_newNamesSize,
+            .file = {.startAddr = 0, .length = 0},
+        };
+        m_newNamesSize += nameLength + 1;
+    }
+
+    out[dirIndex].dir.next = m_outCount;
+}
+
+u32 FSTBuilder::Build(u8* out, u32* nextOffset)
+{
+    if (!m_valid) {
+        return 0;
+    }
+
+    for (u32 i = 0; i < m_modCount; i++) {
+        m_mods[i].entry = 0;
+        m_mods[i].offset = 0;
+        m_mods[i].length = 0;
+        // Marks a source that hasn't been found
+        m_sources[i].isDir = true;
+    }
+
+    Entry* outEntries = reinterpret_cast<Entry*>(out);
+    outEntries[0] = m_fst[0];
+    m_outCount = 1;
+    m_newNamesSize = 0;
+
+    // Every open directory, with its end in the original FST and its index in
+    // the output
+    struct {
+        u32 end;
+        u32 hash;
+        u32 outIndex;
+    } dirs[MaxDepth];
+    u32 depth = 0;
+    dirs[0] = {.end = m_entryCount, .hash = FNVBasis, .outIndex = 0};
+
+    for (u32 i = 1; i < m_entryCount; i++) {
+        for (; depth > 0 && i >= dirs[depth].end; depth--) {
+            CloseDir(outEntries, dirs[depth].hash, dirs[depth].outIndex);
+        }
+
+        const char* name = GetName(i);
+        if (name == nullptr) {
+            PRINT(Riivo, ERROR, "Invalid FST name for entry %u", i);
+            return 0;
+        }
+
+        const Entry* entry = &m_fst[i];
+        const u32 hash = HashName(dirs[depth].hash, name, std::strlen(name));
+        const u32 outIndex = m_outCount++;
+        outEntries[outIndex] = *entry;
+
+        if (entry->isDir) {
+            const u32 next = entry->dir.next;
+            if (next <= i || next > dirs[depth].end || depth + 1 == MaxDepth) {
+                PRINT(Riivo, ERROR, "Invalid FST directory entry %u", i);
+                return 0;
+            }
+
+            outEntries[outIndex].dir.parent = dirs[depth].outIndex;
+            depth++;
+            dirs[depth] = {.end = next, .hash = hash, .outIndex = outIndex};
+            continue;
+        }
+
+        for (u32 slot = hash & m_slotMask; m_slots[slot] != 0;
+             slot = (slot + 1) & m_slotMask) {
+            const Key* key = &m_keys[m_slots[slot] - 1];
+            if (key->hash != hash ||
+                !NameEquals(name, key->name, key->nameLength)) {
+                continue;
+            }
+
+            if (key->role == Role::TARGET) {
+                m_mods[key->mod].entry = outIndex;
+            } else if (key->role == Role::SOURCE) {
+                m_sources[key->mod] = *entry;
+            }
+        }
+    }
+
+    for (; depth > 0; depth--) {
+        CloseDir(outEntries, dirs[depth].hash, dirs[depth].outIndex);
+    }
+    CloseDir(outEntries, FNVBasis, 0);
+
+    // Copy the original names through and append the new ones
+    char* names = reinterpret_cast<char*>(out) + m_outCount * sizeof(Entry);
+    std::memcpy(names, m_names, m_namesSize);
+
+    for (u32 i = 0; i < m_modCount; i++) {
+        Modification* mod = &m_mods[i];
+        if (mod->op != Op::CREATE || mod->entry == 0 ||
+            outEntries[mod->entry].stringOffset < m_namesSize) {
+            continue;
+        }
+
+        const char* path = mod->path;
+        u32 nameLength;
+        const char* name =
+            GetLastComponent(path, GetPathLength(path), &nameLength);
+
+        char* outName = names + outEntries[mod->entry].stringOffset;
+        std::memcpy(outName, name, nameLength);
+        outName[nameLength] = '\0';
+    }
+
+    // Give the files with new data increasing offsets in the order of the
+    // modifications, so their DVD patches come out sorted. A SHIFT keeps the
+    // offset of its source instead and has no patch of its own.
+    for (u32 i = 0; i < m_modCount; i++) {
+        Modification* mod = &m_mods[i];
+        if (mod->entry == 0) {
+            PRINT(Riivo, WARN, "FST modification not applied: %s", mod->path);
+            continue;
+        }
+
+        Entry* entry = &outEntries[mod->entry];
+
+        if (mod->op == Op::SHIFT) {
+            if (m_sources[i].isDir) {
+                PRINT(Riivo, WARN, "Shift source not found for %s", mod->path);
+                mod->entry = 0;
+                continue;
+            }
+
+            entry->file = m_sources[i].file;
+            mod->offset = entry->file.startAddr;
+            mod->length = entry->file.length;
+            continue;
+        }
+
+        if (mod->resize || entry->stringOffset >= m_namesSize) {
+            entry->file.length = mod->size;
+        }
+
+        const u32 length = AlignUp(entry->file.length, 32) >> 2;
+        if (*nextOffset + length < *nextOffset) {
+            PRINT(Riivo, ERROR, "Out of patched disc space");
+            return 0;
+        }
+
+        entry->file.startAddr = *nextOffset;
+        mod->offset = *nextOffset;
+        mod->length = entry->file.length;
+        *nextOffset += length;
+    }
+
+    return m_outCount * sizeof(Entry) + m_namesSize + m_newNamesSize;
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <Types.h>
+
+// Rewrites a disc FST for Riivolution file and shift nodes. The original FST
+// is walked once, copying every entry to the output and applying the
+// modifications that match its path on the way. New files are added at the
+// end of their directory, and the directory links are fixed up as they close.
+// Unchanged entries keep their name offsets, so the original string table is
+// copied through as is and new names are appended after it.
+class FSTBuilder
+{
+public:
+    enum class Op : u8 {
+        // Point an existing file at new data
+        REPLACE,
+        // Like REPLACE, but add the file if it doesn't exist
+        CREATE,
+        // Point the file at path at the data of the file at source
+        SHIFT,
+    };
+
+    struct Modification {
+        Op op;
+        // Set the file size to size, otherwise the size on the disc is kept
+        bool resize;
+        // Path on the disc, relative to the FST root
+        const char* path;
+        // Source path for SHIFT
+        const char* source;
+        u32 size;
+
+        // Set by Build. Files with new data are given a patched word offset,
+        // allocated in the order of the modifications. The entry is 0 if the
+        // modification couldn't be applied.
+        u32 entry;
+        u32 offset;
+        u32 length;
+    };
+
+    /**
+     * Index the modifications.
+     * @param fst The original FST. Must stay valid until Build.
+     * @param mods Modifications, written back with the results by Build.
+     */
+    FSTBuilder(const u8* fst, u32 fstSize, Modification* mods, u32 modCount);
+
+    ~FSTBuilder();
+
+    FSTBuilder(const FSTBuilder&) = delete;
+
+    bool IsValid() const
+    {
+        return m_valid;
+    }
+
+    /**
+     * Get the most space the rebuilt FST can take.
+     */
+    u32 GetMaxSize() const;
+
+    /**
+     * Rebuild the FST.
+     * @param out Where to write the FST. Must not overlap the original.
+     * @param nextOffset Patched word offset to place the first new file at,
+     * updated on return.
+     * @returns The size of the rebuilt FST, or 0 on error.
+     */
+    u32 Build(u8* out, u32* nextOffset);
+
+private:
+    static constexpr u32 MaxDepth = 32;
+
+    struct Entry {
+        u8 isDir : 8;
+        u32 stringOffset : 24;
+
+        union {
+            struct {
+                u32 parent;
+                u32 next;
+            } dir;
+
+            struct {
+                u32 startAddr;
+                u32 length;
+            } file;
+        };
+    };
+
+    static_assert(sizeof(Entry) == 0xC);
+
+    // A path a modification is interested in
+    enum class Role : u8 {
+        // The file at the path
+        TARGET,
+        // The source of a SHIFT
+        SOURCE,
+        // The directory a CREATE adds its file to
+        PARENT,
+    };
+
+    struct Key {
+        u32 hash;
+        u16 mod;
+        Role role;
+        // Last component of the path, to rule out a hash collision
+        const char* name;
+        u32 nameLength;
+    };
+
+    const char* GetName(u32 entry) const;
+    void AddKey(const char* path, u32 pathLength, u16 mod, Role role);
+    void CloseDir(Entry* out, u32 dirHash, u32 dirIndex);
+
+    bool m_valid = false;
+    const Entry* m_fst;
+    u32 m_entryCount;
+    const char* m_names;
+    u32 m_namesSize;
+
+    Modification* m_mods;
+    u32 m_modCount;
+    // Source data of each SHIFT, found during the walk
+    Entry* m_sources = nullptr;
+
+    Key* m_keys = nullptr;
+    u32 m_keyCount = 0;
+    // Open addressed by key hash, holding key index + 1
+    u16* m_slots = nullptr;
+    u32 m_slotMask;
+
+    // Output state
+    u32 m_outCount;
+    u32 m_newNamesSize;
+    u32 m_createCount;
+    u32 m_createNamesSize;
+};
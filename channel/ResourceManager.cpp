@@ -105,24 +105,36 @@ void ResourceManager::LoadFont()
     IOS::File file(OpenTMDContent(5));
     ASSERT(file.GetFd() >= 0);
 
-    u8 arcHeader[0x100] alignas(32);
-
-    s32 ret = file.Read(arcHeader, sizeof(arcHeader));
-    ASSERT(u32(ret) == sizeof(arcHeader));
-    ASSERT(ReadU32(arcHeader + 0xC) < 0x100);
+    // Only the tables are loaded, the font is read straight from the file
+    FileArchive archive(&file);
+    const u32 tablesSize = archive.tablesSize();
+    ASSERT(tablesSize != 0);
+
+    u8* tables = static_cast<u8*>(Heap::AllocMEM2(tablesSize, 32));
+    ASSERT(tables != nullptr);
+    const bool loaded = archive.load(tables);
+    ASSERT(loaded);
+
+    // Lookups fall back to walking the tables if there's no space for this
+    const u32 indexSize = archive.indexSize();
+    void* index = Heap::AllocMEM2(indexSize, 32);
+    if (index != nullptr) {
+        archive.buildIndex(index, indexSize);
+    }
 
-    Archive archive(arcHeader, file.GetSize());
     auto entry = archive.get("wbf1.brfna");
     Archive::File* fontFile = std::get_if<Archive::File>(&entry);
     ASSERT(!!fontFile);
 
-    ret = file.Seek(fontFile->offset, SEEK_SET);
-    ASSERT(u32(ret) == fontFile->offset);
-
     void* fontData = Heap::AllocMEM2(AlignUp(fontFile->size, 32), 32);
     ASSERT(fontData != nullptr);
-    ret = file.Read(fontData, AlignUp(fontFile->size, 32));
-    ASSERT(u32(ret) == AlignUp(fontFile->size, 32));
+    s32 ret = archive.read(*fontFile, fontData, 0, fontFile->size);
+    ASSERT(u32(ret) == fontFile->size);
+
+    if (index != nullptr) {
+        Heap::FreeMEM2(index);
+    }
+    Heap::FreeMEM2(tables);
 
     char param[] = {0, 0, 0, 0, 0, 0, 0, 0};
 
@@ -10,7 +10,15 @@
 #define DOL_BSS_SIZE 0xDC
 #define DOL_ENTRY_POINT 0xE0
 
+#define RUN_PATCH_ADDRESS 0x0
+#define RUN_PATCH_VALUE 0x4
+#define RUN_PATCH_LENGTH 0x8
+#define RUN_PATCH_SIZE 0xC
+
 ASM_SYMBOL_START(RunDOL, .text)
+    mr      r8, r4 // Memory patches
+    mr      r9, r5 // Memory patch count
+
     // Clear BSS
     lwz     r4, DOL_BSS_ADDRESS(r3)
     lwz     r5, DOL_BSS_SIZE(r3)
@@ -72,6 +80,45 @@ L_SectionLoopEnd:
     cmpwi   r4, DOL_SECTION_COUNT
     blt+    L_SectionLoop
 
+    // Apply the memory patches outside the DOL sections at their game
+    // addresses, with one store and invalidate per line of each
+    cmpwi   r9, 0
+    beq-    L_PatchLoopEnd
+
+L_PatchLoop:
+    lwz     r5, RUN_PATCH_ADDRESS(r8)
+    lwz     r6, RUN_PATCH_VALUE(r8)
+    lwz     r7, RUN_PATCH_LENGTH(r8)
+
+    mtctr   r7
+    subi    r10, r5, 1 // Copy dest
+    subi    r6, r6, 1 // Copy src
+
+L_PatchCopyLoop:
+    lbzu    r0, 1(r6)
+    stbu    r0, 1(r10)
+    bdnz+   L_PatchCopyLoop
+
+    add     r7, r5, r7 // Patch end
+    clrrwi  r5, r5, 5 // First line
+
+L_PatchLineLoop:
+    dcbst   0, r5
+    sync
+    icbi    0, r5
+    addi    r5, r5, 32
+    cmplw   r5, r7
+    blt+    L_PatchLineLoop
+
+    addi    r8, r8, RUN_PATCH_SIZE
+    subic.  r9, r9, 1
+    bne+    L_PatchLoop
+
+    sync
+    isync
+
+L_PatchLoopEnd:
+
 #if 0
     lis     r12, 0xC01b2894@h
     ori     r12, r12, 0xc01b2894@l
@@ -327,6 +327,63 @@ DI::DIError DI::ReadDiskBca(u8* out)
     return CallIoctl(block, DIIoctl::ReadDiskBca, out, 64);
 }
 
+/**
+ * Starling: Tell the emulated drive the game is starting. DVD patches are
+ * fixed and the extended EmuFS commands are blocked from then on.
+ * @returns IOS error code.
+ */
+s32 DI::ProxyStartGame()
+{
+    return m_di.Ioctl(
+        static_cast<DIIoctl>(EmuDITypes::PROXY_IOCTL_STARTGAME), nullptr, 0,
+        nullptr, 0
+    );
+}
+
+/**
+ * Starling: Add a DVD patch for each file placed in the patched range of the
+ * FST, appended to the patch table. Only accepted before the game starts.
+ * @returns The number of patches in the table, or an IOS error code.
+ */
+s32 DI::ProxyPatchFiles(const EmuDITypes::FilePatch* files, u32 fileCount)
+{
+    return m_di.Ioctl(
+        static_cast<DIIoctl>(EmuDITypes::PROXY_IOCTL_PATCHFILE), files,
+        fileCount * sizeof(EmuDITypes::FilePatch), nullptr, 0
+    );
+}
+
+/**
+ * Starling: Expand Riivolution folder nodes into DVD patches, appended to the
+ * patch table. Only accepted before the game starts.
+ * @returns The number of patches in the table, or an IOS error code.
+ */
+s32 DI::ProxyPatchFolders(
+    const EmuDITypes::FolderPatch* folders, u32 folderCount, u32 nextOffset,
+    void* fst, u32 fstSize, EmuDITypes::FSTIndexSlot* index, u32 indexSize
+)
+{
+    u32 offset ATTRIBUTE_ALIGN(32) = nextOffset;
+
+    IOS::IOVector<2, 2> vec;
+    // input - Folder patches
+    vec.in[0].data = folders;
+    vec.in[0].len = folderCount * sizeof(EmuDITypes::FolderPatch);
+    // input - First patched offset
+    vec.in[1].data = &offset;
+    vec.in[1].len = sizeof(offset);
+    // output - FST
+    vec.out[0].data = fst;
+    vec.out[0].len = fstSize;
+    // output - FST index scratch
+    vec.out[1].data = index;
+    vec.out[1].len = indexSize * sizeof(EmuDITypes::FSTIndexSlot);
+
+    return m_di.Ioctlv(
+        static_cast<DIIoctl>(EmuDITypes::PROXY_IOCTLV_PATCHFOLDER), vec
+    );
+}
+
 DI::DIError DI::CallIoctl(DICommand& block, DIIoctl cmd, void* out, u32 outLen)
 {
     return static_cast<DIError>(
@@ -6,6 +6,7 @@
 #pragma once
 
 #include <ES.hpp>
+#include <EmuDITypes.hpp>
 #include <IOS.hpp>
 #include <Types.h>
 #include <Util.h>
@@ -278,6 +279,37 @@ public:
      */
     DIError ReadDiskBca(u8* out);
 
+    /**
+     * Starling: Tell the emulated drive the game is starting. DVD patches are
+     * fixed and the extended EmuFS commands are blocked from then on.
+     * @returns IOS error code.
+     */
+    s32 ProxyStartGame();
+
+    /**
+     * Starling: Add a DVD patch for each file placed in the patched range of
+     * the FST, appended to the patch table. Only accepted before the game
+     * starts.
+     * @param files Sorted by disc offset, starting past the last patch.
+     * @returns The number of patches in the table, or an IOS error code.
+     */
+    s32 ProxyPatchFiles(const EmuDITypes::FilePatch* files, u32 fileCount);
+
+    /**
+     * Starling: Expand Riivolution folder nodes into DVD patches, appended to
+     * the patch table. Only accepted before the game starts.
+     * @param nextOffset Patched word offset to place the first file at.
+     * @param fst The game's FST, rewritten in place. Must be 32 byte aligned.
+     * @param index Scratch for the FST path index, with a power of two slot
+     * count larger than the FST entry count.
+     * @returns The number of patches in the table, or an IOS error code.
+     */
+    s32 ProxyPatchFolders(
+        const EmuDITypes::FolderPatch* folders, u32 folderCount,
+        u32 nextOffset, void* fst, u32 fstSize,
+        EmuDITypes::FSTIndexSlot* index, u32 indexSize
+    );
+
     s32 GetFd() const
     {
         return m_di.GetFd();
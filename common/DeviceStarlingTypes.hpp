@@ -17,7 +17,7 @@ constexpr const char RM_PATH[] = "/dev/starling";
 
 enum class Command {
     // Sent from the loader to IOS
-    RECEIVE_COMMAND,
+    WAIT_COMMAND,
     START_GAME,
 
     // Sent from IOS to the loader
@@ -32,6 +32,7 @@ enum class Command {
 using Ioctl = Command;
 
 constexpr u32 MAX_DISK_COUNT = 9;
+constexpr u32 MAX_PATH_LENGTH = 248;
 
 struct CommandData {
     static CommandData FromDiskID(DiskID diskId)
@@ -45,7 +46,41 @@ struct CommandData {
         struct {
             u32 diskId;
         } disk;
+
+        struct {
+            u32 diskId;
+            // Path on the disk, without the drive prefix
+            char path[MAX_PATH_LENGTH];
+        } riivolutionXml;
     };
 };
 
+struct alignas(32) CommandEntry {
+    Command command;
+    CommandData data;
+};
+
+static_assert(sizeof(CommandEntry) == 0x100);
+
+// Single producer, single consumer ring of commands from IOS to the loader,
+// placed at COMMAND_DATA_ADDRESS. IOS only writes the entries and writeIndex,
+// and the loader only writes readIndex, so neither side needs a lock. Each
+// index sits on its own cache line, and each side must flush what it writes
+// and invalidate what it reads. The indices are free running and wrap at
+// ENTRY_COUNT when used as an entry index.
+//
+// The loader only blocks in WAIT_COMMAND after finding the ring empty, and IOS
+// replies to it on the next push. Any commands pushed while the loader is
+// still reading are picked up without another IPC request.
+struct CommandRing {
+    static constexpr u32 ENTRY_COUNT = 2048;
+
+    alignas(32) u32 writeIndex;
+    alignas(32) u32 readIndex;
+    CommandEntry entries[ENTRY_COUNT];
+};
+
+static_assert(sizeof(CommandRing) <= COMMAND_DATA_MAXLEN);
+static_assert((CommandRing::ENTRY_COUNT & (CommandRing::ENTRY_COUNT - 1)) == 0);
+
 } // namespace DeviceStarlingTypes
@@ -10,6 +10,18 @@
 namespace EmuDITypes
 {
 
+// Starling commands on /dev/di, only accepted before the game starts
+enum ProxyCommand : u32 {
+    PROXY_IOCTL_PATCHDVD = 0x00,
+    PROXY_IOCTL_STARTGAME = 0x01,
+    PROXY_IOCTLV_PATCHFOLDER = 0x02,
+    PROXY_IOCTL_PATCHFILE = 0x03,
+};
+
+// Word offset of the first patched file. Reads past it are served from the
+// DVD patches.
+constexpr u32 PATCHED_OFFSET = 0x80000000;
+
 struct DVDPatch {
     u32 disc_offset;
     u32 disc_length;
@@ -18,7 +30,53 @@ struct DVDPatch {
     u64 start_cluster;
     u64 cur_cluster;
     u32 file_offset;
-    u32 drv;
+    u16 drv;
+    // exFAT allocation status, 2 if the file is contiguous without a FAT chain
+    u16 stat;
+};
+
+/**
+ * Input of DI_PROXY_IOCTL_PATCHFILE, one per file placed in the patched range
+ * of the FST.
+ */
+struct FilePatch {
+    // Patched word offset of the file
+    u32 disc_offset;
+    // Byte length of the file in the FST
+    u32 length;
+    // Where the data starts in the external file
+    u32 file_offset;
+    // FatFs path of the external file, "N:/..."
+    char externalPath[244];
+};
+
+static_assert(sizeof(FilePatch) == 0x100);
+
+enum FolderPatchFlag : u32 {
+    FOLDER_RECURSIVE = 1 << 0,
+    FOLDER_RESIZE = 1 << 1,
+    FOLDER_CREATE = 1 << 2,
+};
+
+/**
+ * Input of DI_PROXY_IOCTLV_PATCHFOLDER, one per Riivolution folder node.
+ */
+struct FolderPatch {
+    u32 flags;
+    // Folder on the disc, relative to the FST root
+    char discPath[124];
+    // FatFs path of the folder to replace it with, "N:/..."
+    char externalPath[256];
+};
+
+static_assert(sizeof(FolderPatch) == 0x180);
+
+/**
+ * Slot of the FST path index. Entry 0 is the root, so it marks a free slot.
+ */
+struct FSTIndexSlot {
+    u32 hash;
+    u32 entry;
 };
 
 } // namespace EmuDITypes
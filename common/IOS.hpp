@@ -457,4 +457,51 @@ public:
     }
 };
 
+/**
+ * Read a batch of whole files from the emulated filesystem in one request,
+ * instead of an open, stats, read and close for each file.
+ * @param bufferSizes Size of each buffer. 0 only gets the file size.
+ * @param results Receives the size of each file, or an ISFS error code. A
+ * file larger than its buffer is only read up to the buffer size.
+ * @param modified Optional, receives the FAT modified date and time of each
+ * file, or 0 if it isn't on external storage.
+ * @returns ISFS error code of the request.
+ */
+static inline s32 ReadFiles(
+    u32 count, const char* const* paths, void* const* buffers,
+    const u32* bufferSizes, s32* results, u32* modified = nullptr
+)
+{
+    if (count == 0 || count > ISFS::EX_READ_FILES_MAX_COUNT) {
+        return ISFS::ISFSError::INVALID;
+    }
+
+    ResourceCtrl<ISFS::ISFSIoctl> fs("/dev/fs");
+    if (fs.GetFd() < 0) {
+        return fs.GetFd();
+    }
+
+    struct {
+        const void* data;
+        u32 len;
+    } vec[ISFS::EX_READ_FILES_MAX_COUNT * 2 + 2];
+
+    for (u32 i = 0; i < count; i++) {
+        vec[i].data = paths[i];
+        vec[i].len = std::strlen(paths[i]) + 1;
+        vec[count + i].data = buffers[i];
+        vec[count + i].len = bufferSizes[i];
+    }
+    vec[count * 2].data = results;
+    vec[count * 2].len = count * sizeof(s32);
+    vec[count * 2 + 1].data = modified;
+    vec[count * 2 + 1].len = count * sizeof(u32);
+
+    return fs.Ioctlv(
+        ISFS::ISFSIoctl::EX_READ_FILES, count,
+        modified != nullptr ? count + 2 : count + 1,
+        reinterpret_cast<::IOVector*>(vec)
+    );
+}
+
 } // namespace IOS
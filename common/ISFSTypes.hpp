@@ -36,6 +36,11 @@ constexpr u32 MAX_NAME_LENGTH = 12;
 constexpr u32 EMUFS_MAX_PATH_LENGTH = 2048;
 
 constexpr s32 MAX_OPEN_COUNT = 15;
+// Handle pool of the emulated filesystem, which also holds closed files that
+// are kept open for reopening
+constexpr s32 EMUFS_MAX_OPEN_COUNT = 32;
+// Most files read by one EX_READ_FILES request
+constexpr u32 EX_READ_FILES_MAX_COUNT = 16;
 
 enum class ISFSIoctl {
     FORMAT = 1,
@@ -54,6 +59,7 @@ enum class ISFSIoctl {
     EX_OPEN = 1000,
     EX_DIR_OPEN,
     EX_DIR_NEXT,
+    EX_READ_FILES,
 };
 
 struct RenameBlock {
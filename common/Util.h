@@ -161,6 +161,9 @@ constexpr bool InMEM2Effective(T addr)
     return (value >= 0x90000000) && (value < 0x94000000);
 }
 
+// Broadway timebase ticks per millisecond, a quarter of the bus clock
+#define TB_TICKS_PER_MS 60750
+
 static inline bool StrEndsWith(const char* str, const char* with)
 {
     auto strLen = strlen(str);
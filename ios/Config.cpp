@@ -4,20 +4,61 @@
 // SPDX-License-Identifier: GPL-2.0-only
 
 #include "Config.hpp"
-#include <cstring>
+#include <ISFSTypes.hpp>
+#include <Util.h>
+#include <iterator>
 
 Config* Config::s_instance;
 
+// ISFS path prefixes redirected to external storage. A list of paths to be
+// replaced will be provided by the channel in the future.
+static constexpr const char* ISFS_REDIRECTS[] = {
+    "/title/00010000/",
+    "/title/00010004/",
+};
+
+Config::Config()
+{
+    for (const char* prefix : ISFS_REDIRECTS) {
+        [[maybe_unused]] bool ret = m_redirectTrie.Insert(
+            prefix, PathTrie<256>::Match::PREFIX, true
+        );
+        ASSERT(ret);
+    }
+}
+
+/**
+ * Checks if an ISFS path is redirected to external storage. Safe to call from
+ * the IOS_Open hook.
+ */
 bool Config::IsISFSPathReplaced(const char* path)
 {
-    // A list of paths to be replaced will be provided by the channel in the
-    // future.
-    if (strncmp(path, "/title/00010000/", sizeof("/title/00010000/") - 1) == 0)
-        return true;
-    if (strncmp(path, "/title/00010004/", sizeof("/title/00010004/") - 1) == 0)
-        return true;
+    return m_redirectTrie.Find(path, ISFS::MAX_PATH_LENGTH) != 0;
+}
+
+/**
+ * Get the number of redirected ISFS path prefixes.
+ */
+u32 Config::GetISFSRedirectCount()
+{
+    return std::size(ISFS_REDIRECTS);
+}
 
-    return false;
+/**
+ * Get a redirected ISFS path prefix.
+ */
+const char* Config::GetISFSRedirect(u32 index)
+{
+    return ISFS_REDIRECTS[index];
+}
+
+/**
+ * Get the external directory redirected ISFS paths are copied to. An ISFS
+ * path is appended to it as is.
+ */
+const char* Config::GetNANDRedirectRoot()
+{
+    return "0:/starling/nand";
 }
 
 bool Config::IsFileLogEnabled()
@@ -29,3 +70,21 @@ bool Config::BlockIOSReload()
 {
     return false;
 }
+
+/**
+ * Memory in bytes used to cache directory listings from external storage. 0
+ * disables the cache.
+ */
+u32 Config::GetReadDirCacheSize()
+{
+    return 0x4000;
+}
+
+/**
+ * Memory in bytes used to cache small, frequently opened NAND files. 0
+ * disables the cache.
+ */
+u32 Config::GetNANDCacheSize()
+{
+    return 0x8000;
+}
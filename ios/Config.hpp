@@ -5,6 +5,9 @@
 
 #pragma once
 
+#include "PathTrie.hpp"
+#include <Types.h>
+
 // Config is currently hardcoded
 
 class Config
@@ -12,7 +15,17 @@ class Config
 public:
     static Config* s_instance;
 
+    Config();
+
     bool IsISFSPathReplaced(const char* path);
+    u32 GetISFSRedirectCount();
+    const char* GetISFSRedirect(u32 index);
+    const char* GetNANDRedirectRoot();
     bool IsFileLogEnabled();
     bool BlockIOSReload();
+    u32 GetReadDirCacheSize();
+    u32 GetNANDCacheSize();
+
+private:
+    PathTrie<256> m_redirectTrie;
 };
@@ -5,10 +5,12 @@
 
 #include "DeviceEmuDI.hpp"
 #include <DI.hpp>
+#include <DeviceEmuFS.hpp>
 #include <DeviceStarling.hpp>
 #include <DiskManager.hpp>
 #include <ES.hpp>
 #include <EmuDITypes.hpp>
+#include <FolderExpander.hpp>
 #include <Log.hpp>
 #include <Syscalls.h>
 #include <System.hpp>
@@ -31,12 +33,17 @@ static u32 __diMsgData[8];
 static bool DiStarted = false;
 static bool GameStarted = false;
 
-/* 200 for now */
-static EmuDITypes::DVDPatch DiPatches[200];
+// Folder nodes add a patch for every file they replace. The table is
+// allocated from the system heap, with room for the patches it holds.
+static constexpr u32 DI_MAX_PATCHES = 1024;
+static EmuDITypes::DVDPatch* DiPatches = nullptr;
 static u32 DiNumPatches = 0;
+static u32 DiMaxPatches = 0;
 
-#define DI_PROXY_IOCTL_PATCHDVD 0x00
-#define DI_PROXY_IOCTL_STARTGAME 0x01
+#define DI_PROXY_IOCTL_PATCHDVD EmuDITypes::PROXY_IOCTL_PATCHDVD
+#define DI_PROXY_IOCTL_STARTGAME EmuDITypes::PROXY_IOCTL_STARTGAME
+#define DI_PROXY_IOCTLV_PATCHFOLDER EmuDITypes::PROXY_IOCTLV_PATCHFOLDER
+#define DI_PROXY_IOCTL_PATCHFILE EmuDITypes::PROXY_IOCTL_PATCHFILE
 
 #define DI_EOK 0x1
 #define DI_ESECURITY 0x20
@@ -269,8 +276,9 @@ static DI::DIError EmuIoctlv(
  * Open a patch file by its identifier.
  * @param[out] fp FATFS file pointer
  * @param[in] patch DVD patch to open.
+ * @param[in] offset Byte offset into the patched data to seek to.
  */
-static void OpenPatchFile(FIL* fp, EmuDITypes::DVDPatch* patch)
+static FRESULT OpenPatchFile(FIL* fp, EmuDITypes::DVDPatch* patch, u32 offset)
 {
     memset(fp, 0, sizeof(FIL));
 
@@ -281,31 +289,38 @@ static void OpenPatchFile(FIL* fp, EmuDITypes::DVDPatch* patch)
     fp->obj.fs = fatfs;
     fp->obj.id = fatfs->id;
     fp->obj.sclust = patch->start_cluster;
+    // A contiguous exFAT file has no FAT chain to follow, the next cluster
+    // is taken as the one after
+    fp->obj.stat = patch->stat;
     fp->obj.objsize = 0xFFFFFFFF;
     fp->flag = FA_READ;
     fp->fptr = patch->file_offset;
     fp->clust = patch->cur_cluster;
+
+    // Always seek, even to the start of the patch. The sector buffer is
+    // empty, and the seek is what loads it when the offset isn't sector
+    // aligned.
+    return f_lseek(fp, patch->file_offset + offset);
 }
 
+/**
+ * Find the first patch that ends past a word offset. Patches don't cover the
+ * whole patched range, so the offset may be before the start of the patch.
+ * @returns The patch index, or DiNumPatches if every patch ends before it.
+ */
 static inline u32 SearchPatch(u32 offset)
 {
-    for (s32 j = 0, i = DiNumPatches; i != 0; i >>= 1) {
-        s32 k = j + (i >> 1);
-        u32 p_start = DiPatches[k].disc_offset;
-        u32 p_end = p_start + DiPatches[k].disc_length;
-
-        if (p_start == offset)
-            return k;
-        if (offset > p_start) {
-            if (p_end > offset)
-                return k;
-            // Move right
-            j = k + 1;
-            i--;
-        }
-        // offset < p_start
+    u32 low = 0;
+    u32 high = DiNumPatches;
+    while (low < high) {
+        const u32 mid = (low + high) / 2;
+        if (DiPatches[mid].disc_offset + DiPatches[mid].disc_length > offset) {
+            high = mid;
+        } else {
+            low = mid + 1;
+        }
     }
-    return DiNumPatches;
+    return low;
 }
 
 static s32 RealRead(void* outbuf, u32 offset, u32 length)
@@ -347,35 +362,47 @@ static s32 Read(u8* outbuf, u32 offset, u32 length)
 
         outbuf += (0x80000000 - offset) << 2;
         length -= (0x80000000 - offset) << 2;
+        offset = 0x80000000;
     }
 
     for (u32 idx = SearchPatch(offset); length != 0; idx++) {
         PRINT(IOS_EmuDI, INFO, "Read patch %d of %d", idx, DiNumPatches);
         if (idx >= DiNumPatches) {
-            PRINT(IOS_EmuDI, WARN, "Out of bounds DVD read");
             memset(outbuf, 0, length);
-            return DI_EOK; // Just success, I guess?
+            return DI_EOK;
         }
 
-        FIL f;
-        OpenPatchFile(&f, &DiPatches[idx]);
-
-        u32 read_len = DiPatches[idx].disc_length << 2;
-        if (DiPatches[idx].disc_offset != offset) {
-            const FRESULT fret =
-                f_lseek(&f, (offset - DiPatches[idx].disc_offset) << 2);
-            if (fret != FR_OK) {
-                PRINT(IOS_EmuDI, ERROR, "FS_LSeek failed: %d", fret);
-                System::Abort();
+        // Nothing is patched between the files, like the padding to the
+        // next file's alignment
+        if (DiPatches[idx].disc_offset > offset) {
+            const u32 gap = DiPatches[idx].disc_offset - offset;
+            if (gap >= (length + 3) >> 2) {
+                memset(outbuf, 0, length);
+                return DI_EOK;
             }
-            read_len -= (offset - DiPatches[idx].disc_offset) << 2;
+
+            memset(outbuf, 0, gap << 2);
+            outbuf += gap << 2;
+            length -= gap << 2;
+            offset += gap;
         }
 
+        const u32 skip = (offset - DiPatches[idx].disc_offset) << 2;
+
+        FIL f;
+        FRESULT fret = OpenPatchFile(&f, &DiPatches[idx], skip);
+        if (fret != FR_OK) {
+            PRINT(IOS_EmuDI, ERROR, "FS_LSeek failed: %d", fret);
+            System::Abort();
+        }
+
+        u32 read_len = (DiPatches[idx].disc_length << 2) - skip;
+
         if (read_len > length)
             read_len = length;
         UINT read = 0;
 
-        const FRESULT fret = f_read(&f, outbuf, read_len, &read);
+        fret = f_read(&f, outbuf, read_len, &read);
         if (fret != FR_OK) {
             PRINT(IOS_EmuDI, ERROR, "FS_Read failed: %d", fret);
             memset(outbuf + read, 0, read_len - read);
@@ -389,6 +416,142 @@ static s32 Read(u8* outbuf, u32 offset, u32 length)
     return DI_EOK;
 }
 
+/**
+ * Resize the DVD patch table to hold count patches, keeping the patches in it.
+ * The count must not be less than the number of patches.
+ * @returns False if count is over DI_MAX_PATCHES or the heap is full.
+ */
+static bool ResizePatches(u32 count)
+{
+    if (count > DI_MAX_PATCHES) {
+        return false;
+    }
+
+    if (count == DiMaxPatches) {
+        return true;
+    }
+
+    EmuDITypes::DVDPatch* patches = nullptr;
+    if (count != 0) {
+        patches = static_cast<EmuDITypes::DVDPatch*>(IOS_AllocAligned(
+            System::GetHeap(), count * sizeof(EmuDITypes::DVDPatch), 32
+        ));
+        if (patches == nullptr) {
+            return false;
+        }
+
+        if (DiNumPatches != 0) {
+            memcpy(
+                patches, DiPatches, DiNumPatches * sizeof(EmuDITypes::DVDPatch)
+            );
+        }
+    }
+
+    if (DiPatches != nullptr) {
+        IOS_Free(System::GetHeap(), DiPatches);
+    }
+
+    DiPatches = patches;
+    DiMaxPatches = count;
+    return true;
+}
+
+/**
+ * Append a DVD patch for each file in PatchFiles to the patch table, which has
+ * room for DiMaxPatches.
+ * @returns The number of patches in the table, or an IOS error.
+ */
+static s32 AddFilePatches(const EmuDITypes::FilePatch* files, u32 count)
+{
+    for (u32 i = 0; i < count; i++) {
+        const EmuDITypes::FilePatch* file = &files[i];
+        if (file->disc_offset < EmuDITypes::PATCHED_OFFSET ||
+            (DiNumPatches != 0 &&
+             file->disc_offset < DiPatches[DiNumPatches - 1].disc_offset +
+                                     DiPatches[DiNumPatches - 1].disc_length)) {
+            PRINT(
+                IOS_EmuDI, ERROR, "File offset overlaps the patches: 0x%08X",
+                file->disc_offset
+            );
+            return IOS::IOSError::INVALID;
+        }
+
+        const char* path = file->externalPath;
+        if (path[0] < '0' || path[0] > '9' || path[1] != ':' ||
+            std::memchr(path, '\0', sizeof(file->externalPath)) == nullptr) {
+            PRINT(IOS_EmuDI, ERROR, "Invalid external path");
+            return IOS::IOSError::INVALID;
+        }
+
+        FIL f;
+        FRESULT fret = f_open(&f, path, FA_READ);
+        if (fret != FR_OK) {
+            // The file reads as zeroes
+            PRINT(IOS_EmuDI, WARN, "Failed to open %s: %d", path, fret);
+            continue;
+        }
+
+        // Start the patch at the cluster of the data, so the seek on every
+        // read doesn't walk the chain from the start of the file
+        const u32 fileSize = f_size(&f);
+        u32 dataLength = 0;
+        if (file->file_offset < fileSize) {
+            dataLength = fileSize - file->file_offset;
+            fret = f_lseek(&f, file->file_offset);
+        }
+        if (dataLength > file->length) {
+            dataLength = file->length;
+        }
+
+        if (fret == FR_OK && dataLength != 0) {
+            if (DiNumPatches == DiMaxPatches) {
+                f_close(&f);
+                PRINT(IOS_EmuDI, ERROR, "Out of DVD patches");
+                return IOS_ERROR_NO_MEMORY;
+            }
+
+            DiPatches[DiNumPatches++] = {
+                .disc_offset = file->disc_offset,
+                .disc_length = AlignUp(dataLength, 4) >> 2,
+                .start_cluster = f.obj.sclust,
+                .cur_cluster = f.clust,
+                .file_offset = static_cast<u32>(f.fptr),
+                .drv = static_cast<u16>(path[0] - '0'),
+                .stat = f.obj.stat,
+            };
+        }
+
+        f_close(&f);
+    }
+
+    PRINT(
+        IOS_EmuDI, INFO, "Added %u files, %u DVD patches", count, DiNumPatches
+    );
+    return DiNumPatches;
+}
+
+/**
+ * Add a DVD patch for each file the FST builder placed in the patched range,
+ * appended to the patch table. The files must be sorted by disc offset and
+ * start past the last patch.
+ * @returns The number of patches in the table, or an IOS error.
+ */
+static s32 PatchFiles(const EmuDITypes::FilePatch* files, u32 count)
+{
+    // Files that fail to open add no patch, so the table is trimmed after
+    const u32 maxPatches = DiNumPatches + count < DI_MAX_PATCHES
+                               ? DiNumPatches + count
+                               : DI_MAX_PATCHES;
+    if (!ResizePatches(maxPatches)) {
+        PRINT(IOS_EmuDI, ERROR, "Not enough memory for DVD patches");
+        return IOS_ERROR_NO_MEMORY;
+    }
+
+    const s32 ret = AddFilePatches(files, count);
+    ResizePatches(DiNumPatches);
+    return ret;
+}
+
 /**
  * Handle DI IOCTLs for patched games, returning false forwards the command to
  * the actual disc image.
@@ -439,8 +602,10 @@ static bool DI_DoNewIOCTL(IOS::Request* req)
             return true;
         }
 
-        DiNumPatches = req->ioctl.in_len / sizeof(EmuDITypes::DVDPatch);
-        if (req->ioctl.in_len > sizeof(DiPatches)) {
+        // The list replaces the patches
+        const u32 count = req->ioctl.in_len / sizeof(EmuDITypes::DVDPatch);
+        DiNumPatches = 0;
+        if (!ResizePatches(count)) {
             PRINT(
                 IOS_EmuDI, ERROR,
                 "DI_PROXY_IOCTL_PATCHDVD: "
@@ -449,16 +614,33 @@ static bool DI_DoNewIOCTL(IOS::Request* req)
             req->Reply(IOS_ERROR_NO_MEMORY);
             return true;
         }
-        memcpy(DiPatches, req->ioctl.in, req->ioctl.in_len);
+        memcpy(DiPatches, req->ioctl.in, count * sizeof(EmuDITypes::DVDPatch));
+        DiNumPatches = count;
         req->Reply(IOS_ERROR_OK);
         return true;
     }
 
+    case DI_PROXY_IOCTL_PATCHFILE: {
+        if (GameStarted)
+            return false;
+        if (req->ioctl.in_len % sizeof(EmuDITypes::FilePatch) != 0) {
+            req->Reply(IOS::IOSError::INVALID);
+            return true;
+        }
+
+        req->Reply(PatchFiles(
+            reinterpret_cast<const EmuDITypes::FilePatch*>(req->ioctl.in),
+            req->ioctl.in_len / sizeof(EmuDITypes::FilePatch)
+        ));
+        return true;
+    }
+
     case DI_PROXY_IOCTL_STARTGAME: {
         if (GameStarted)
             return false;
         PRINT(IOS_EmuDI, WARN, "DI_PROXY_IOCTL_STARTGAME: Starting game...");
         GameStarted = true;
+        DeviceEmuFS::BlockExtendedInterface();
         req->Reply(IOS_ERROR_OK);
         return true;
     }
@@ -519,9 +701,89 @@ static inline void ReqIoctl(IOS::Request* req)
     req->Reply(ret);
 }
 
+/**
+ * Expand Riivolution folder nodes into DVD patches, appended to the patch
+ * table. The patched offsets must start past the last patch, so the table
+ * stays sorted.
+ * Input vector 0: EmuDITypes::FolderPatch[]
+ * Input vector 1: u32, patched word offset to place the first file at. The
+ * caller shares it with the files it already placed in the FST.
+ * I/O vector 2: The game's FST, rewritten in place.
+ * I/O vector 3: EmuDITypes::FSTIndexSlot[], scratch for the FST path index.
+ * The slot count must be a power of two larger than the FST entry count.
+ * @returns The number of patches in the table, or an IOS error.
+ */
+static s32 PatchFolders(IOS::Request* req)
+{
+    if (req->ioctlv.in_count != 2 || req->ioctlv.out_count != 2) {
+        return IOS::IOSError::INVALID;
+    }
+
+    const IOS::TVector* vec = req->ioctlv.vec;
+    if (vec[0].len % sizeof(EmuDITypes::FolderPatch) != 0 ||
+        vec[1].len != sizeof(u32) ||
+        vec[3].len % sizeof(EmuDITypes::FSTIndexSlot) != 0) {
+        return IOS::IOSError::INVALID;
+    }
+
+    const u32 nextOffset = *reinterpret_cast<const u32*>(vec[1].data);
+    if (nextOffset < EmuDITypes::PATCHED_OFFSET ||
+        (DiNumPatches != 0 &&
+         nextOffset < DiPatches[DiNumPatches - 1].disc_offset +
+                          DiPatches[DiNumPatches - 1].disc_length)) {
+        PRINT(
+            IOS_EmuDI, ERROR, "Folder offset overlaps the patches: 0x%08X",
+            nextOffset
+        );
+        return IOS::IOSError::INVALID;
+    }
+
+    FolderExpander expander(
+        reinterpret_cast<u8*>(vec[2].data), vec[2].len,
+        reinterpret_cast<EmuDITypes::FSTIndexSlot*>(vec[3].data),
+        vec[3].len / sizeof(EmuDITypes::FSTIndexSlot), nextOffset
+    );
+    if (!expander.IsValid()) {
+        return IOS::IOSError::INVALID;
+    }
+
+    const auto* folders =
+        reinterpret_cast<const EmuDITypes::FolderPatch*>(vec[0].data);
+    const u32 folderCount = vec[0].len / sizeof(EmuDITypes::FolderPatch);
+
+    // The number of files isn't known until they're found, so the table is
+    // expanded into at full size and trimmed after
+    if (!ResizePatches(DI_MAX_PATCHES)) {
+        PRINT(IOS_EmuDI, ERROR, "Not enough memory for DVD patches");
+        return IOS_ERROR_NO_MEMORY;
+    }
+
+    for (u32 i = 0; i < folderCount; i++) {
+        const FRESULT fresult = expander.Expand(
+            &folders[i], DiPatches, DiMaxPatches, &DiNumPatches
+        );
+        if (fresult == FR_NOT_ENOUGH_CORE) {
+            ResizePatches(DiNumPatches);
+            return IOS_ERROR_NO_MEMORY;
+        }
+        // Anything else only skips the folder
+    }
+
+    ResizePatches(DiNumPatches);
+
+    PRINT(
+        IOS_EmuDI, INFO, "Expanded %u folders, %u DVD patches", folderCount,
+        DiNumPatches
+    );
+    return DiNumPatches;
+}
+
 static inline void ReqIoctlv(IOS::Request* req)
 {
-    // Probably won't be replacing any IOCTLVs
+    if (req->ioctlv.cmd == DI_PROXY_IOCTLV_PATCHFOLDER && !GameStarted) {
+        req->Reply(PatchFolders(req));
+        return;
+    }
 
     if (useVirtualDisc) {
         // DI emulation
@@ -6,7 +6,9 @@
 #include "DeviceEmuFS.hpp"
 #include <Config.hpp>
 #include <DeviceStarling.hpp>
+#include <DiskManager.hpp>
 #include <FAT.h>
+#include <FATCache.hpp>
 #include <IOS.hpp>
 #include <ISFSTypes.hpp>
 #include <Log.hpp>
@@ -14,6 +16,7 @@
 #include <System.hpp>
 #include <Types.h>
 #include <Util.h>
+#include <algorithm>
 #include <array>
 #include <climits>
 #include <cstdio>
@@ -39,8 +42,49 @@ constexpr const char* MOUNT_POINTS[] = {
     EMUFS_USB4, EMUFS_USB5, EMUFS_USB6, EMUFS_USB7,
 };
 
-static char s_efsPath[ISFS::EMUFS_MAX_PATH_LENGTH];
-static char s_efsPath2[ISFS::EMUFS_MAX_PATH_LENGTH];
+// Requests are handled by a pool of worker threads, each serving one lane.
+// Every file handle is bound to a lane when it's opened, and NAND files get a
+// lane of their own so they never wait on external storage. Manager commands
+// on a path are routed by the path, the rest go to the manager lane. While a
+// file descriptor has requests in flight, new ones follow them to the same
+// lane, so requests on a file descriptor are always handled in order.
+enum RequestLane {
+    LANE_NAND,
+    LANE_MANAGER,
+    LANE_EXTERNAL,
+    // Two lanes for external files
+    LANE_COUNT = LANE_EXTERNAL + 2,
+};
+
+// Scratch path buffers for the request being handled. Each worker thread has
+// its own, so requests handled at the same time don't overwrite each other's
+// paths.
+struct RequestContext {
+    s32 threadId;
+    char efsPath[ISFS::EMUFS_MAX_PATH_LENGTH];
+    char efsPath2[ISFS::EMUFS_MAX_PATH_LENGTH];
+};
+
+static RequestContext s_requestContexts[LANE_COUNT];
+
+/**
+ * Get the scratch buffers of the worker thread handling the current request.
+ */
+static RequestContext* GetRequestContext()
+{
+    const s32 threadId = IOS_GetThreadId();
+    for (RequestContext& context : s_requestContexts) {
+        if (context.threadId == threadId) {
+            return &context;
+        }
+    }
+
+    PRINT(IOS_EmuFS, ERROR, "Request handled outside of a worker thread");
+    System::Abort();
+    return nullptr;
+}
+
+struct NANDCacheEntry;
 
 class EmuFSHandle
 {
@@ -52,9 +96,10 @@ public:
     }
 
     s32 OpenFile(const char* path, u32 mode, u32 uid, u16 gid, bool redirect);
-    s32 Reopen();
+    s32 Reopen(u32 mode, u32 uid, u16 gid);
     s32 Close();
     s32 CloseBackend();
+    void ReleaseManagerResource();
     s32 Read(void* buffer, u32 size);
     s32 Write(const void* buffer, u32 size);
     s32 Seek(s32 offset, s32 origin);
@@ -65,6 +110,12 @@ public:
     );
 
     s32 CopyData(EmuFSHandle* source);
+    s32 ReadFile(u8* data, u32 len);
+    s32 DropReadAhead();
+    void ReleaseReadAhead();
+    s32 WriteFile(const void* data, u32 len);
+    s32 FlushWriteBuffer();
+    s32 LoadNANDCache(const char* path, u32 generation);
 
     s32 CreateDir(
         const char* path, u8 ownerPerm, u8 groupPerm, u8 otherPerm,
@@ -90,6 +141,11 @@ public:
     // File commands
     s32 GetFileStats(u32* size, u32* position);
 
+    s32 ReadFiles(
+        u32 count, IOS::TVector* paths, IOS::TVector* buffers, s32* results,
+        u32* modified
+    );
+
     s32 DirectDirOpen(const char* path);
     s32 DirectDirNext(char* name, u32* attributes);
 
@@ -112,11 +168,13 @@ public:
                 std::holds_alternative<DIR>(m_file));
     }
 
-    static s32 RegisterProxyHandle(const char* path);
-    void FreeProxyHandle();
+    bool SetProxyPath(const char* path);
     static s32 FindProxyHandle(const char* path);
+    static s32 ClaimProxyHandle(const char* path);
     static s32 FindFreeHandle();
+    static void ReleaseHandle(s32 fd);
     static s32 TryCloseProxyHandle(const char* path);
+    static s32 TryCloseProxyHandlesUnder(const char* path);
 
     IOS::ResourceCtrl<ISFS::ISFSIoctl> m_resource{-1};
     s32 m_fd = -1;
@@ -126,9 +184,25 @@ public:
     bool m_inUse = false;
     bool m_backendFileOpened = false;
     char m_proxyPath[64] = {0};
+    u32 m_proxyHash = 0;
+    // External path of an open file, used for usage accounting, or the path
+    // of a NAND file open for writing, used to drop it from the NAND cache on
+    // close. Empty if the path is too long to track.
+    char m_efsPath[ISFS::MAX_PATH_LENGTH + 8] = {0};
+    // Cached contents a read-only NAND file is served from, see OpenFile
+    NANDCacheEntry* m_nandCache = nullptr;
+    // Small writes waiting to be written at the file position, see Write
+    u8* m_writeBuffer = nullptr;
+    u32 m_writeLength = 0;
+    // Data read ahead of the position, ending at the file position, see
+    // ReadFile
+    u8* m_readBuffer = nullptr;
+    u32 m_readPos = 0;
+    u32 m_readLength = 0;
+    u32 m_readWindow = 0;
+    bool m_readSequential = false;
     u32 m_accessMode = 0;
     bool m_redirect = false;
-    bool m_blockExtendedInterface = false;
 
     struct ISFSFileHandle {
         s32 position;
@@ -145,37 +219,184 @@ public:
     std::variant<ISFSFileHandle, ISFSReadDirCacheHandle, FIL, DIR> m_file;
 };
 
-static std::array<EmuFSHandle, ISFS::MAX_OPEN_COUNT> s_handles;
+static std::array<EmuFSHandle, ISFS::EMUFS_MAX_OPEN_COUNT> s_handles;
+
+// Every handle is either free (no backend open), cached (closed by the caller
+// with the backend file left open) or in use. Free handles are kept in a
+// singly linked list and cached handles in a doubly linked list ordered from
+// least to most recently closed, so allocating, evicting and reopening a
+// handle never needs to scan the table.
+enum class HandleState : u8 {
+    FREE,
+    CACHED,
+    IN_USE,
+};
+
+static constexpr s32 HANDLE_NONE = -1;
+
+static HandleState s_handleState[ISFS::EMUFS_MAX_OPEN_COUNT];
+static s8 s_freeNext[ISFS::EMUFS_MAX_OPEN_COUNT];
+static s32 s_freeHead = HANDLE_NONE;
+static s8 s_lruPrev[ISFS::EMUFS_MAX_OPEN_COUNT];
+static s8 s_lruNext[ISFS::EMUFS_MAX_OPEN_COUNT];
+static s32 s_lruHead = HANDLE_NONE;
+static s32 s_lruTail = HANDLE_NONE;
+
+// Open addressed hash from proxy path to handle index, using linear probing
+static constexpr u32 PROXY_HASH_SIZE = 64;
+static_assert(PROXY_HASH_SIZE >= ISFS::EMUFS_MAX_OPEN_COUNT * 2);
+static_assert((PROXY_HASH_SIZE & (PROXY_HASH_SIZE - 1)) == 0);
+static s8 s_proxyIndex[PROXY_HASH_SIZE];
+
+// Guards the handle states, the free and LRU lists and the proxy index. Held
+// only for the bookkeeping, never across I/O.
+static Mutex s_handleMutex;
+
+// Lane of every open handle, read by the dispatcher thread
+static u8 s_handleLane[ISFS::EMUFS_MAX_OPEN_COUNT];
+
+// Lane the requests in flight on each file descriptor were sent to, and how
+// many there are. Guards s_handleLane as well.
+static u8 s_handleRoute[ISFS::EMUFS_MAX_OPEN_COUNT];
+static u16 s_handlePending[ISFS::EMUFS_MAX_OPEN_COUNT];
+static Mutex s_routeMutex;
+
+static u8 GetHandleLane(const EmuFSHandle* handle);
+
+// The UID and GID are process wide, so only one lane can open as another user
+// at a time
+static Mutex s_openAsUidMutex;
+
+// IDs currently set on the process. They're left set between opens, so a run
+// of opens by the same title pays for the switch once, and only a change of
+// title or a root open switches them again. EmuFS is the only thing in this
+// module that opens NAND files, every other open is of a device node (sdio,
+// usb) that doesn't check the IDs.
+static u32 s_processUid = 0;
+static u16 s_processGid = 0;
 
 static s32 IOS_OpenAsUid(const char* path, u32 mode, u32 uid, u16 gid)
 {
-    s32 pid = IOS_GetProcessId();
-    ASSERT(pid >= 0);
+    // Root opens take the lock too, so they can't run while another lane
+    // has the process switched to a title
+    ScopeLock lock(s_openAsUidMutex);
 
-    PRINT(IOS_EmuFS, INFO, "Set PID %d to UID %08X GID %04X", pid, uid, gid);
+    if (uid != s_processUid || gid != s_processGid) {
+        s32 pid = IOS_GetProcessId();
+        ASSERT(pid >= 0);
 
-    // Security note! Interrupts will be disabled at this point
-    // (IOS_Open always does), and the IPC thread can't do anything else
-    // while it's waiting for a response from us, so this should be safe
-    // to do to the root process..?
+        PRINT(
+            IOS_EmuFS, INFO, "Set PID %d to UID %08X GID %04X", pid, uid, gid
+        );
 
-    s32 ret = IOS_SetUid(pid, uid);
-    ASSERT(ret == IOS::IOSError::OK);
-    ret = IOS_SetGid(pid, gid);
-    ASSERT(ret == IOS::IOSError::OK);
+        // Security note! Interrupts will be disabled at this point
+        // (IOS_Open always does), and the IPC thread can't do anything else
+        // while it's waiting for a response from us, so this should be safe
+        // to do to the root process..?
+        [[maybe_unused]] s32 ret;
+        if (uid != s_processUid) {
+            ret = IOS_SetUid(pid, uid);
+            ASSERT(ret == IOS::IOSError::OK);
+            s_processUid = uid;
+        }
+        if (gid != s_processGid) {
+            ret = IOS_SetGid(pid, gid);
+            ASSERT(ret == IOS::IOSError::OK);
+            s_processGid = gid;
+        }
+    }
+
+    return IOS_Open(path, mode);
+}
 
-    s32 fd = IOS_Open(path, mode);
+// Real /dev/fs descriptors, shared by the manager handles of a UID and GID so
+// creating a manager handle doesn't need another open. Descriptors nobody is
+// using stay open until their slot is needed.
+struct ManagerFd {
+    s32 fd;
+    u32 uid;
+    u16 gid;
+    u32 refCount;
+    u32 lastUse;
+};
 
-    ret = IOS_SetUid(pid, 0);
-    ASSERT(ret == IOS::IOSError::OK);
-    ret = IOS_SetGid(pid, 0);
-    ASSERT(ret == IOS::IOSError::OK);
+static constexpr u32 MANAGER_FD_COUNT = 4;
+
+static ManagerFd s_managerFds[MANAGER_FD_COUNT];
+static u32 s_managerFdUseCounter = 0;
+static Mutex s_managerFdMutex;
+
+static void InitManagerFds()
+{
+    for (ManagerFd& entry : s_managerFds) {
+        entry.fd = -1;
+        entry.refCount = 0;
+    }
+}
+
+/**
+ * Get a /dev/fs descriptor opened as a UID and GID. Give it back with
+ * ReleaseManagerFd.
+ * @returns File descriptor, or IOS error code.
+ */
+static s32 AcquireManagerFd(u32 uid, u16 gid)
+{
+    ScopeLock lock(s_managerFdMutex);
+
+    ManagerFd* victim = nullptr;
+    for (ManagerFd& entry : s_managerFds) {
+        if (entry.fd >= 0 && entry.uid == uid && entry.gid == gid) {
+            entry.refCount++;
+            entry.lastUse = ++s_managerFdUseCounter;
+            return entry.fd;
+        }
+
+        if (entry.refCount != 0) {
+            continue;
+        }
+
+        if (victim == nullptr || entry.fd < 0 ||
+            (victim->fd >= 0 && entry.lastUse < victim->lastUse)) {
+            victim = &entry;
+        }
+    }
 
-    PRINT(IOS_EmuFS, INFO, "UID and GID restored", pid);
+    const s32 fd = IOS_OpenAsUid("/dev/fs", 0, uid, gid);
+
+    // Every slot is in use, the caller gets a descriptor of its own
+    if (fd < 0 || victim == nullptr) {
+        return fd;
+    }
+
+    if (victim->fd >= 0) {
+        [[maybe_unused]] s32 ret = IOS_Close(victim->fd);
+        ASSERT(ret == IOS::IOSError::OK);
+    }
 
+    victim->fd = fd;
+    victim->uid = uid;
+    victim->gid = gid;
+    victim->refCount = 1;
+    victim->lastUse = ++s_managerFdUseCounter;
     return fd;
 }
 
+static void ReleaseManagerFd(s32 fd)
+{
+    ScopeLock lock(s_managerFdMutex);
+
+    for (ManagerFd& entry : s_managerFds) {
+        if (entry.fd == fd) {
+            ASSERT(entry.refCount > 0);
+            entry.refCount--;
+            return;
+        }
+    }
+
+    [[maybe_unused]] s32 ret = IOS_Close(fd);
+    ASSERT(ret == IOS::IOSError::OK);
+}
+
 static s32 FResultToISFSError(FRESULT fresult)
 {
     switch (fresult) {
@@ -237,112 +458,320 @@ static u32 ISFSModeToFileMode(u32 mode)
     return out;
 }
 
-s32 EmuFSHandle::RegisterProxyHandle(const char* path)
+static u32 HashProxyPath(const char* path)
 {
-    s32 match = 0;
+    u32 hash = 0x811C9DC5;
+    for (; *path != '\0'; path++) {
+        hash = (hash ^ static_cast<u8>(*path)) * 0x01000193;
+    }
+    return hash;
+}
 
-    for (s32 i = 0; i < ISFS::MAX_OPEN_COUNT; i++) {
-        // If the file was already opened, reuse the descriptor
-        if (path && s_handles[i].m_backendFileOpened &&
-            std::strcmp(s_handles[i].m_proxyPath, path) == 0) {
-            if (s_handles[i].m_inUse) {
-                return ISFS::ISFSError::LOCKED;
-            }
+static void InitHandleTable()
+{
+    s_freeHead = HANDLE_NONE;
+    for (s32 i = ISFS::EMUFS_MAX_OPEN_COUNT - 1; i >= 0; i--) {
+        s_handleState[i] = HandleState::FREE;
+        s_freeNext[i] = s_freeHead;
+        s_freeHead = i;
+    }
 
-            s_handles[i].m_inUse = true;
-            return i;
-        }
+    s_lruHead = s_lruTail = HANDLE_NONE;
 
-        if (!s_handles[i].m_inUse && s_handles[match].m_inUse) {
-            match = i;
-        }
+    for (u32 i = 0; i < PROXY_HASH_SIZE; i++) {
+        s_proxyIndex[i] = HANDLE_NONE;
+    }
+}
 
-        if (!s_handles[i].m_backendFileOpened &&
-            s_handles[match].m_backendFileOpened) {
-            match = i;
-        }
+static void UnlinkLRU(s32 fd)
+{
+    s32 prev = s_lruPrev[fd], next = s_lruNext[fd];
+
+    if (prev != HANDLE_NONE) {
+        s_lruNext[prev] = next;
+    } else {
+        s_lruHead = next;
     }
 
-    if (s_handles[match].m_inUse) {
-        return ISFS::ISFSError::MAX_HANDLES_OPEN;
+    if (next != HANDLE_NONE) {
+        s_lruPrev[next] = prev;
+    } else {
+        s_lruTail = prev;
+    }
+}
+
+static void InsertProxyIndex(s32 fd)
+{
+    u32 slot = s_handles[fd].m_proxyHash & (PROXY_HASH_SIZE - 1);
+    while (s_proxyIndex[slot] != HANDLE_NONE) {
+        slot = (slot + 1) & (PROXY_HASH_SIZE - 1);
     }
 
-    // Close and use the file descriptor
+    s_proxyIndex[slot] = fd;
+}
+
+static void RemoveProxyIndex(s32 fd)
+{
+    constexpr u32 mask = PROXY_HASH_SIZE - 1;
 
-    if (s_handles[match].m_backendFileOpened) {
-        s_handles[match].CloseBackend();
+    u32 hole = s_handles[fd].m_proxyHash & mask;
+    while (s_proxyIndex[hole] != fd) {
+        if (s_proxyIndex[hole] == HANDLE_NONE) {
+            return;
+        }
+        hole = (hole + 1) & mask;
     }
 
-    s_handles[match].m_backendFileOpened = false;
-    s_handles[match].m_inUse = true;
-    std::strncpy(s_handles[match].m_proxyPath, path, 64);
+    // Shift back any following entries that would no longer be reachable
+    for (u32 next = (hole + 1) & mask; s_proxyIndex[next] != HANDLE_NONE;
+         next = (next + 1) & mask) {
+        u32 home = s_handles[s_proxyIndex[next]].m_proxyHash & mask;
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            s_proxyIndex[hole] = s_proxyIndex[next];
+            hole = next;
+        }
+    }
 
-    return match;
+    s_proxyIndex[hole] = HANDLE_NONE;
 }
 
-void EmuFSHandle::FreeProxyHandle()
+/**
+ * Get the index of a handle in the handle table, or HANDLE_NONE if it's a
+ * temporary handle.
+ */
+static s32 GetHandleIndex(const EmuFSHandle* handle)
 {
-    if (!IsValidFile()) {
-        return;
+    if (handle < s_handles.data() ||
+        handle >= s_handles.data() + s_handles.size()) {
+        return HANDLE_NONE;
     }
 
-    m_inUse = false;
+    return handle - s_handles.data();
+}
+
+/**
+ * Mark an open backend file as cacheable under an ISFS path.
+ * @returns False if another handle is already cached under the path.
+ */
+bool EmuFSHandle::SetProxyPath(const char* path)
+{
+    s32 fd = GetHandleIndex(this);
+    ASSERT(fd != HANDLE_NONE);
+    ASSERT(!IsProxy());
+
+    ScopeLock lock(s_handleMutex);
+
+    // Another thread may have opened the same path in the meantime
+    if (FindProxyHandle(path) != ISFS::EMUFS_MAX_OPEN_COUNT) {
+        return false;
+    }
+
+    std::strncpy(m_proxyPath, path, sizeof(m_proxyPath) - 1);
+    m_proxyHash = HashProxyPath(m_proxyPath);
+    InsertProxyIndex(fd);
+    return true;
 }
 
+/**
+ * Find a handle with the backend file for an ISFS path open. Must be called
+ * with s_handleMutex held.
+ * @returns Handle index, or ISFS::EMUFS_MAX_OPEN_COUNT if none was found.
+ */
 s32 EmuFSHandle::FindProxyHandle(const char* path)
 {
-    for (s32 i = 0; i < ISFS::MAX_OPEN_COUNT; i++) {
-        if (s_handles[i].m_backendFileOpened &&
-            std::strcmp(path, s_handles[i].m_proxyPath) == 0) {
-            return i;
+    const u32 hash = HashProxyPath(path);
+
+    for (u32 slot = hash & (PROXY_HASH_SIZE - 1);
+         s_proxyIndex[slot] != HANDLE_NONE;
+         slot = (slot + 1) & (PROXY_HASH_SIZE - 1)) {
+        const EmuFSHandle& handle = s_handles[s_proxyIndex[slot]];
+        if (handle.m_proxyHash == hash &&
+            std::strcmp(path, handle.m_proxyPath) == 0) {
+            return s_proxyIndex[slot];
         }
     }
 
-    return ISFS::MAX_OPEN_COUNT;
+    return ISFS::EMUFS_MAX_OPEN_COUNT;
+}
+
+/**
+ * Take a cached handle out of the LRU list and mark it in use. Must be called
+ * with s_handleMutex held.
+ */
+static void ClaimCachedHandle(s32 fd)
+{
+    ASSERT(s_handleState[fd] == HandleState::CACHED);
+
+    UnlinkLRU(fd);
+    s_handleState[fd] = HandleState::IN_USE;
+}
+
+/**
+ * Reserve the cached handle for an ISFS path so it can be reopened. The
+ * handle is marked in use until it's given back with ReleaseHandle.
+ * @returns Handle index, ISFS::EMUFS_MAX_OPEN_COUNT if no handle is cached
+ * under the path, or LOCKED if the file is open.
+ */
+s32 EmuFSHandle::ClaimProxyHandle(const char* path)
+{
+    ScopeLock lock(s_handleMutex);
+
+    s32 fd = FindProxyHandle(path);
+    if (fd == ISFS::EMUFS_MAX_OPEN_COUNT) {
+        return fd;
+    }
+
+    if (s_handleState[fd] != HandleState::CACHED) {
+        return ISFS::ISFSError::LOCKED;
+    }
+
+    ClaimCachedHandle(fd);
+    return fd;
 }
 
+/**
+ * Reserve a handle with no backend file open, evicting the least recently
+ * used cached handle if there are no free handles left. The handle is marked
+ * in use until it's given back with ReleaseHandle.
+ * @returns Handle index, or ISFS error code.
+ */
 s32 EmuFSHandle::FindFreeHandle()
 {
-    s32 match = 0;
+    s32 fd;
+    {
+        ScopeLock lock(s_handleMutex);
+
+        fd = s_freeHead;
+        if (fd != HANDLE_NONE) {
+            ASSERT(s_handleState[fd] == HandleState::FREE);
 
-    for (int i = 0; i < ISFS::MAX_OPEN_COUNT; i++) {
-        if (!s_handles[i].m_inUse && s_handles[match].m_inUse) {
-            match = i;
+            s_freeHead = s_freeNext[fd];
+            s_handleState[fd] = HandleState::IN_USE;
+            return fd;
         }
 
-        if (!s_handles[i].m_backendFileOpened &&
-            s_handles[match].m_backendFileOpened) {
-            match = i;
+        fd = s_lruHead;
+        if (fd == HANDLE_NONE) {
+            return ISFS::ISFSError::MAX_HANDLES_OPEN;
         }
+
+        // Drop it from the index first so opening the same path doesn't
+        // find it while it's being closed
+        ClaimCachedHandle(fd);
+        RemoveProxyIndex(fd);
+        s_handles[fd].m_proxyPath[0] = '\0';
     }
 
-    if (s_handles[match].m_inUse) {
-        return ISFS::ISFSError::MAX_HANDLES_OPEN;
+    // Close the evicted file outside of the lock
+    s32 ret = s_handles[fd].CloseBackend();
+    if (ret < 0) {
+        ReleaseHandle(fd);
+        return ret;
     }
 
-    if (s_handles[match].m_backendFileOpened) {
-        s32 ret = s_handles[match].CloseBackend();
-        if (ret < 0) {
-            return ret;
+    return fd;
+}
+
+/**
+ * Give back a handle after the caller is done with it. If the backend file is
+ * still open the handle is kept cached for reopening.
+ */
+void EmuFSHandle::ReleaseHandle(s32 fd)
+{
+    ASSERT(fd >= 0 && fd < ISFS::EMUFS_MAX_OPEN_COUNT);
+
+    ScopeLock lock(s_handleMutex);
+
+    ASSERT(s_handleState[fd] == HandleState::IN_USE);
+
+    const EmuFSHandle& handle = s_handles[fd];
+    ASSERT(!handle.m_inUse);
+
+    if (handle.m_backendFileOpened) {
+        s_handleState[fd] = HandleState::CACHED;
+        s_lruPrev[fd] = s_lruTail;
+        s_lruNext[fd] = HANDLE_NONE;
+        if (s_lruTail != HANDLE_NONE) {
+            s_lruNext[s_lruTail] = fd;
+        } else {
+            s_lruHead = fd;
         }
+        s_lruTail = fd;
+        return;
+    }
+
+    s_handleState[fd] = HandleState::FREE;
+    s_freeNext[fd] = s_freeHead;
+    s_freeHead = fd;
+}
+
+/**
+ * Checks if path is dir or anywhere below it.
+ */
+static bool IsPathUnder(const char* path, const char* dir)
+{
+    size_t len = std::strlen(dir);
+    while (len > 0 && dir[len - 1] == '/') {
+        len--;
     }
 
-    return match;
+    return std::strncmp(path, dir, len) == 0 &&
+           (path[len] == '\0' || path[len] == '/');
 }
 
 s32 EmuFSHandle::TryCloseProxyHandle(const char* path)
 {
-    // Close a cached file handle
-    s32 ret = FindProxyHandle(path);
-    if (ret < 0) {
-        return ret;
+    // Close a cached file handle. Returns LOCKED if the file is open.
+    s32 fd = ClaimProxyHandle(path);
+    if (fd < 0 || fd == ISFS::EMUFS_MAX_OPEN_COUNT) {
+        return fd < 0 ? fd : ISFS::ISFSError::OK;
+    }
+
+    s32 ret = s_handles[fd].CloseBackend();
+    ReleaseHandle(fd);
+    return ret;
+}
+
+/**
+ * Close every cached handle at or below an ISFS path. A renamed directory
+ * would otherwise leave the handles of its children keyed by their old paths.
+ * @returns LOCKED if a file below the path is open.
+ */
+s32 EmuFSHandle::TryCloseProxyHandlesUnder(const char* path)
+{
+    s32 closing[ISFS::EMUFS_MAX_OPEN_COUNT];
+    u32 count = 0;
+    {
+        ScopeLock lock(s_handleMutex);
+
+        for (s32 fd = 0; fd < ISFS::EMUFS_MAX_OPEN_COUNT; fd++) {
+            const EmuFSHandle& handle = s_handles[fd];
+            if (s_handleState[fd] == HandleState::IN_USE &&
+                handle.IsProxy() && IsPathUnder(handle.m_proxyPath, path)) {
+                return ISFS::ISFSError::LOCKED;
+            }
+        }
+
+        // Drop them from the index so they can't be reopened while closing
+        for (s32 fd = 0; fd < ISFS::EMUFS_MAX_OPEN_COUNT; fd++) {
+            EmuFSHandle& handle = s_handles[fd];
+            if (s_handleState[fd] == HandleState::CACHED &&
+                handle.IsProxy() && IsPathUnder(handle.m_proxyPath, path)) {
+                ClaimCachedHandle(fd);
+                RemoveProxyIndex(fd);
+                handle.m_proxyPath[0] = '\0';
+                closing[count++] = fd;
+            }
+        }
     }
-    s32 entry = ret;
-    ret = ISFS::ISFSError::OK;
 
-    if (entry != ISFS::MAX_OPEN_COUNT) {
-        // Will return LOCKED if the handle is in use
-        ret = s_handles[entry].CloseBackend();
+    s32 ret = ISFS::ISFSError::OK;
+    for (u32 i = 0; i < count; i++) {
+        const s32 closeRet = s_handles[closing[i]].CloseBackend();
+        if (closeRet != ISFS::ISFSError::OK) {
+            ret = closeRet;
+        }
+        ReleaseHandle(closing[i]);
     }
 
     return ret;
@@ -452,6 +881,20 @@ static bool IsEmuFSPathValid(const char* path)
            ISFS::EMUFS_MAX_PATH_LENGTH;
 }
 
+// Set once the game starts, the extended commands are only for the loader
+static bool s_blockExtendedInterface = false;
+
+/**
+ * Refuse the extended manager commands from now on.
+ */
+void DeviceEmuFS::BlockExtendedInterface()
+{
+    if (!s_blockExtendedInterface) {
+        PRINT(IOS_EmuFS, INFO, "Blocking the extended interface");
+        s_blockExtendedInterface = true;
+    }
+}
+
 /**
  * Checks if a path is redirected somewhere else by the frontend.
  */
@@ -467,97 +910,298 @@ bool DeviceEmuFS::IsPathReplaced(const char* isfsPath)
     return Config::s_instance->IsISFSPathReplaced(isfsPath);
 }
 
+// NAND paths under the redirected prefixes are moved to external storage one
+// unit at a time, where a unit is a prefix plus one path element, like a
+// title directory under /title/00010000/. The first change to a unit only
+// copies the changed path to the redirect root, and the copy thread copies
+// the rest of the unit behind it. While a unit is being copied, paths that
+// are already on external storage are served from there and the rest from
+// NAND, and a marker file named after the unit stays next to it, so an
+// unfinished copy is picked up again on the next mount. Once every file is
+// copied, every path in the unit is served from the redirect root. The units
+// are read from the redirect root once per mount, so paths in other units go
+// straight to NAND without probing the disk.
+struct RedirectUnit {
+    u32 hash;
+    bool copied;
+    char path[ISFS::MAX_PATH_LENGTH];
+};
+
+enum class RedirectState {
+    NAND,
+    COPYING,
+    COPIED,
+};
+
+static constexpr u32 REDIRECT_UNIT_COUNT = 64;
+
+// Sorted by hash
+static RedirectUnit s_redirectUnits[REDIRECT_UNIT_COUNT];
+static u32 s_redirectUnitCount = 0;
+// Volume the units were read from, null if it's not mounted
+static const FATFS* s_redirectVolume = nullptr;
+static WORD s_redirectVolumeId = 0;
+static Mutex s_redirectMutex;
+// Held while a unit is started and while a file is copied
+static Mutex s_redirectCopyMutex;
+// Wakes up the copy thread
+static Queue<u32, 8> s_redirectCopyQueue;
+
+static const FATFS* GetPathVolume(const char* efsPath);
+static s32 RedirectCopyOnWrite(const char* isfsPath);
+static s32 MaterializeRedirect(const char* isfsPath, bool begin);
+
 /**
- * Get the FATFS path from an ISFS path.
- * @returns True if an external path was found, false if ISFS.
+ * Get the redirect unit an ISFS path belongs to.
+ * @param unitOut Buffer of ISFS::MAX_PATH_LENGTH bytes.
+ * @returns False if the path isn't redirected.
  */
-static bool GetFATFSPath(
-    const char* isfsPath, char* efsOut, u32 outLen,
-    [[maybe_unused]] bool redirect = true
-)
+static bool GetRedirectUnit(const char* isfsPath, char* unitOut)
 {
-    if (efsOut == nullptr) {
+    u32 prefixLength = 0;
+    for (u32 i = 0; i < Config::s_instance->GetISFSRedirectCount(); i++) {
+        const char* prefix = Config::s_instance->GetISFSRedirect(i);
+        const u32 length = std::strlen(prefix);
+        if (length > prefixLength &&
+            std::strncmp(isfsPath, prefix, length) == 0) {
+            prefixLength = length;
+        }
+    }
+
+    if (prefixLength == 0) {
         return false;
     }
 
-    efsOut[0] = 0;
+    const char* end =
+        std::strchr(isfsPath + prefixLength, ISFS::SEPARATOR_CHAR);
+    const u32 length =
+        end != nullptr ? end - isfsPath : std::strlen(isfsPath);
+    if (length == prefixLength || length >= ISFS::MAX_PATH_LENGTH) {
+        return false;
+    }
 
-    // Translate ex. /mnt/sd/file.bin to 0:/file.bin
-    if (PathElementCompare(isfsPath + 1, EMUFS_MOUNT_POINT + 1) == 0) {
-        const char* mnt = isfsPath + sizeof(EMUFS_MOUNT_POINT);
-        char drive = 0;
+    std::memcpy(unitOut, isfsPath, length);
+    unitOut[length] = '\0';
+    return true;
+}
 
-        for (size_t i = 0; i < std::size(MOUNT_POINTS); i++) {
-            if (PathElementCompare(
-                    mnt, MOUNT_POINTS[i] + sizeof(EMUFS_MOUNT_POINT)
-                ) == 0) {
-                drive = '0' + i;
-                isfsPath += std::strlen(MOUNT_POINTS[i]);
-                break;
-            }
-        }
+/**
+ * Find a unit on external storage. The redirect mutex must be held.
+ */
+static RedirectUnit* RedirectIndexFind(const char* unit, u32 hash)
+{
+    RedirectUnit* end = s_redirectUnits + s_redirectUnitCount;
+    RedirectUnit* it = std::lower_bound(
+        s_redirectUnits, end, hash,
+        [](const RedirectUnit& entry, u32 value) { return entry.hash < value; }
+    );
 
-        if (drive == 0) {
-            return false;
+    for (; it != end && it->hash == hash; it++) {
+        if (std::strcmp(it->path, unit) == 0) {
+            return it;
         }
+    }
 
-        std::snprintf(efsOut, outLen, "%c:%s", drive, isfsPath);
-        PRINT(
-            IOS_EmuFS, INFO, "Translated path '%s' to '%s'", isfsPath, efsOut
-        );
+    return nullptr;
+}
+
+/**
+ * Record a unit on external storage. The redirect mutex must be held.
+ * @param copied False if the unit is still being copied.
+ * @returns False if the index is full.
+ */
+static bool RedirectIndexInsert(const char* unit, bool copied)
+{
+    const u32 hash = HashProxyPath(unit);
+    RedirectUnit* entry = RedirectIndexFind(unit, hash);
+    if (entry != nullptr) {
+        entry->copied = entry->copied && copied;
         return true;
     }
 
-    // Create and write the replaced path
-    // TODO: Redirect NAND paths
-    if (!IsISFSPathValid(isfsPath)) {
+    if (s_redirectUnitCount == REDIRECT_UNIT_COUNT) {
+        PRINT(
+            IOS_EmuFS, ERROR, "Too many redirected units, skipping '%s'", unit
+        );
         return false;
     }
 
-    std::strncpy(efsOut, isfsPath, outLen);
+    RedirectUnit* end = s_redirectUnits + s_redirectUnitCount;
+    RedirectUnit* it = std::lower_bound(
+        s_redirectUnits, end, hash,
+        [](const RedirectUnit& entry, u32 value) { return entry.hash < value; }
+    );
 
-    return false;
+    std::memmove(it + 1, it, (end - it) * sizeof(RedirectUnit));
+    it->hash = hash;
+    it->copied = copied;
+    std::strcpy(it->path, unit);
+    s_redirectUnitCount++;
+    return true;
 }
 
 /**
- * Copy data from the source file into this file.
+ * Read the units from the redirect root if the volume was mounted since the
+ * last time. The redirect mutex must be held.
  */
-s32 EmuFSHandle::CopyData(EmuFSHandle* source)
+static void RedirectIndexLoad()
 {
-    static u8 s_buffer[0x2000] ATTRIBUTE_ALIGN(32); // 8 KB
-
-    if (!IsValidFile() || !source->IsValidFile()) {
-        return ISFS::ISFSError::INVALID;
+    const char* root = Config::s_instance->GetNANDRedirectRoot();
+    const FATFS* fs = GetPathVolume(root);
+    if (fs == nullptr || fs->fs_type == 0) {
+        s_redirectVolume = nullptr;
+        s_redirectUnitCount = 0;
+        return;
     }
 
-    if (!(m_accessMode & IOS::Mode::WRITE) ||
-        !(source->m_accessMode & IOS::Mode::READ)) {
-        return ISFS::ISFSError::ACCESS_DENIED;
+    if (fs == s_redirectVolume && fs->id == s_redirectVolumeId) {
+        return;
     }
 
-    for (;;) {
-        s32 ret = source->Read(s_buffer, sizeof(s_buffer));
+    s_redirectVolume = fs;
+    s_redirectVolumeId = fs->id;
+    s_redirectUnitCount = 0;
 
-        if (ret < 0) {
-            return ret;
-        }
+    char dirPath[ISFS::MAX_PATH_LENGTH + 64];
+    char unit[ISFS::MAX_PATH_LENGTH];
+    for (u32 i = 0; i < Config::s_instance->GetISFSRedirectCount(); i++) {
+        const char* prefix = Config::s_instance->GetISFSRedirect(i);
 
-        if (ret == 0) {
-            return ISFS::ISFSError::OK;
+        u32 length =
+            std::snprintf(dirPath, sizeof(dirPath), "%s%s", root, prefix);
+        if (length >= sizeof(dirPath)) {
+            continue;
         }
 
-        u32 writeLen = ret;
-        ret = Write(s_buffer, writeLen);
+        while (length > 0 && dirPath[length - 1] == '/') {
+            dirPath[--length] = '\0';
+        }
 
-        if (ret < 0) {
-            return ret;
+        DIR dir;
+        if (f_opendir(&dir, dirPath) != FR_OK) {
+            continue;
         }
 
-        if (static_cast<u32>(ret) != writeLen) {
-            return ISFS::ISFSError::UNKNOWN;
+        FILINFO info;
+        while (f_readdir(&dir, &info) == FR_OK && info.fname[0] != '\0') {
+            // Units being copied have a marker file next to them, everything
+            // else that isn't a unit directory is skipped
+            char* dot = std::strchr(info.fname, '.');
+            bool copied = true;
+            if (!(info.fattrib & AM_DIR) && dot != nullptr &&
+                std::strcmp(dot, ".tmp") == 0) {
+                *dot = '\0';
+                copied = false;
+            } else if (!(info.fattrib & AM_DIR) || dot != nullptr) {
+                continue;
+            }
+
+            if (std::snprintf(unit, sizeof(unit), "%s%s", prefix, info.fname) <
+                static_cast<s32>(sizeof(unit))) {
+                RedirectIndexInsert(unit, copied);
+            }
         }
+
+        f_closedir(&dir);
     }
-}
+
+    PRINT(
+        IOS_EmuFS, INFO, "Found %u redirected units in '%s'",
+        s_redirectUnitCount, root
+    );
+}
+
+/**
+ * Get how far a unit has been moved to external storage.
+ */
+static RedirectState GetRedirectState(const char* unit)
+{
+    const u32 hash = HashProxyPath(unit);
+
+    ScopeLock lock(s_redirectMutex);
+
+    RedirectIndexLoad();
+    const RedirectUnit* entry = RedirectIndexFind(unit, hash);
+    if (entry == nullptr) {
+        return RedirectState::NAND;
+    }
+
+    return entry->copied ? RedirectState::COPIED : RedirectState::COPYING;
+}
+
+/**
+ * Get the FATFS path from an ISFS path.
+ * @param create The path is about to be created, which in a unit that is
+ * being copied always happens on external storage.
+ * @returns True if an external path was found, false if ISFS.
+ */
+static bool GetFATFSPath(
+    const char* isfsPath, char* efsOut, u32 outLen, bool redirect = true,
+    bool create = false
+)
+{
+    if (efsOut == nullptr) {
+        return false;
+    }
+
+    efsOut[0] = 0;
+
+    // Translate ex. /mnt/sd/file.bin to 0:/file.bin
+    if (PathElementCompare(isfsPath + 1, EMUFS_MOUNT_POINT + 1) == 0) {
+        const char* mnt = isfsPath + sizeof(EMUFS_MOUNT_POINT);
+        char drive = 0;
+
+        for (size_t i = 0; i < std::size(MOUNT_POINTS); i++) {
+            if (PathElementCompare(
+                    mnt, MOUNT_POINTS[i] + sizeof(EMUFS_MOUNT_POINT)
+                ) == 0) {
+                drive = '0' + i;
+                isfsPath += std::strlen(MOUNT_POINTS[i]);
+                break;
+            }
+        }
+
+        if (drive == 0) {
+            return false;
+        }
+
+        std::snprintf(efsOut, outLen, "%c:%s", drive, isfsPath);
+        PRINT(
+            IOS_EmuFS, INFO, "Translated path '%s' to '%s'", isfsPath, efsOut
+        );
+        return true;
+    }
+
+    if (!IsISFSPathValid(isfsPath)) {
+        return false;
+    }
+
+    // Paths in units moved to external storage. A unit that is still being
+    // copied only has the paths already copied or changed there.
+    char unit[ISFS::MAX_PATH_LENGTH];
+    const RedirectState state = redirect && GetRedirectUnit(isfsPath, unit)
+                                    ? GetRedirectState(unit)
+                                    : RedirectState::NAND;
+    if (state != RedirectState::NAND) {
+        const s32 len = std::snprintf(
+            efsOut, outLen, "%s%s", Config::s_instance->GetNANDRedirectRoot(),
+            isfsPath
+        );
+        if (len < 0 || static_cast<u32>(len) >= outLen) {
+            efsOut[0] = 0;
+            return false;
+        }
+
+        if (state == RedirectState::COPIED || create ||
+            FATCache::Stat(efsOut, nullptr) == FR_OK) {
+            return true;
+        }
+    }
+
+    std::strncpy(efsOut, isfsPath, outLen);
+
+    return false;
+}
 
 template <typename T>
 bool WriteIfNotNull(T* dest, T value)
@@ -570,13 +1214,310 @@ bool WriteIfNotNull(T* dest, T value)
     return true;
 }
 
+// Contents of small NAND files that are opened over and over, like SYSCONF,
+// setting.txt and save banners. A file is loaded on its second read-only open
+// within a short history, and later read-only opens by the same owner are
+// served from memory without a NAND access. Anything that may change a file
+// through EmuFS drops its entry. Only files that no IOS module writes behind
+// EmuFS's back are cached: KD and the WC24 scheduler write channel data and
+// shared2/wc24 through the real FS, while SYSCONF and setting.txt are only
+// written by the PPC.
+struct NANDCacheEntry {
+    // Null if the slot is free
+    u8* data;
+    u32 size;
+    u32 refCount;
+    u32 lastUse;
+    u32 uid;
+    u16 gid;
+    // False once invalidated. The data is freed when the last handle using
+    // it closes.
+    bool valid;
+    char path[ISFS::MAX_PATH_LENGTH];
+};
+
+static constexpr u32 NAND_CACHE_COUNT = 8;
+static constexpr u32 NAND_CACHE_MAX_FILE_SIZE = 0x4000;
+static constexpr u32 NAND_CACHE_HISTORY_COUNT = 16;
+
+static NANDCacheEntry s_nandCache[NAND_CACHE_COUNT];
+static u32 s_nandCacheUsed = 0;
+static u32 s_nandCacheUseCounter = 0;
+static u32 s_nandCacheGeneration = 1;
+// Hashes of recently opened cacheable paths that missed the cache
+static u32 s_nandCacheHistory[NAND_CACHE_HISTORY_COUNT];
+static u32 s_nandCacheHistoryNext = 0;
+static DeviceEmuFS::NANDCacheStats s_nandCacheStats;
+static Mutex s_nandCacheMutex;
+
+/**
+ * Checks if a NAND file may be cached: SYSCONF, setting.txt and files in the
+ * data directories of disc titles, which only the game itself writes to.
+ */
+static bool IsNANDPathCacheable(const char* path)
+{
+    if (std::strcmp(path, "/shared2/sys/SYSCONF") == 0 ||
+        std::strcmp(path, "/title/00000001/00000002/data/setting.txt") == 0) {
+        return true;
+    }
+
+    // /title/00010000/XXXXXXXX/data/... or /title/00010004/XXXXXXXX/data/...
+    if (std::strncmp(path, "/title/00010000/", 16) != 0 &&
+        std::strncmp(path, "/title/00010004/", 16) != 0) {
+        return false;
+    }
+
+    path += 16;
+    const char* separator = std::strchr(path, ISFS::SEPARATOR_CHAR);
+    if (separator == nullptr || separator - path != 8) {
+        return false;
+    }
+    path = separator + 1;
+
+    return std::strncmp(path, "data/", 5) == 0;
+}
+
+/**
+ * Drop an entry and free its data if no handle is using it. The cache mutex
+ * must be held.
+ */
+static void NANDCacheFree(NANDCacheEntry* entry)
+{
+    entry->valid = false;
+    if (entry->refCount != 0 || entry->data == nullptr) {
+        return;
+    }
+
+    s_nandCacheUsed -= entry->size;
+    IOS_Free(System::GetHeap(), entry->data);
+    entry->data = nullptr;
+}
+
+/**
+ * Find a file loaded by the same owner and keep it until NANDCacheRelease.
+ * @returns The entry, or nullptr if the file is not cached.
+ */
+static NANDCacheEntry* NANDCacheAcquire(const char* path, u32 uid, u16 gid)
+{
+    ScopeLock lock(s_nandCacheMutex);
+
+    for (u32 i = 0; i < NAND_CACHE_COUNT; i++) {
+        NANDCacheEntry* entry = &s_nandCache[i];
+        if (entry->valid && entry->uid == uid && entry->gid == gid &&
+            std::strcmp(entry->path, path) == 0) {
+            entry->refCount++;
+            entry->lastUse = ++s_nandCacheUseCounter;
+            s_nandCacheStats.hits++;
+            return entry;
+        }
+    }
+
+    s_nandCacheStats.misses++;
+    return nullptr;
+}
+
+static void NANDCacheRelease(NANDCacheEntry* entry)
+{
+    ScopeLock lock(s_nandCacheMutex);
+
+    ASSERT(entry->refCount != 0);
+    entry->refCount--;
+    if (!entry->valid) {
+        NANDCacheFree(entry);
+    }
+}
+
+/**
+ * Record an open of a cacheable file that missed the cache.
+ * @param generationOut The generation to insert the file's contents with.
+ * @returns True if the file was opened recently and should be loaded.
+ */
+static bool NANDCacheShouldLoad(const char* path, u32* generationOut)
+{
+    const u32 hash = HashProxyPath(path);
+
+    ScopeLock lock(s_nandCacheMutex);
+
+    *generationOut = s_nandCacheGeneration;
+
+    for (u32 i = 0; i < NAND_CACHE_HISTORY_COUNT; i++) {
+        if (s_nandCacheHistory[i] == hash) {
+            return true;
+        }
+    }
+
+    s_nandCacheHistory[s_nandCacheHistoryNext] = hash;
+    s_nandCacheHistoryNext =
+        (s_nandCacheHistoryNext + 1) % NAND_CACHE_HISTORY_COUNT;
+    return false;
+}
+
+/**
+ * Insert the contents of a file read at the given generation into the cache.
+ * Takes ownership of data.
+ */
+static void NANDCacheInsert(
+    const char* path, u32 uid, u16 gid, u8* data, u32 size, u32 generation
+)
+{
+    const u32 capacity = Config::s_instance->GetNANDCacheSize();
+    if (size > capacity ||
+        std::strlen(path) >= sizeof(NANDCacheEntry::path)) {
+        IOS_Free(System::GetHeap(), data);
+        return;
+    }
+
+    ScopeLock lock(s_nandCacheMutex);
+
+    // The file may have changed while it was being read
+    if (generation != s_nandCacheGeneration) {
+        IOS_Free(System::GetHeap(), data);
+        return;
+    }
+
+    // Evict least recently used entries that aren't in use until there's room
+    for (;;) {
+        NANDCacheEntry* freeSlot = nullptr;
+        NANDCacheEntry* victim = nullptr;
+        for (u32 i = 0; i < NAND_CACHE_COUNT; i++) {
+            NANDCacheEntry* entry = &s_nandCache[i];
+            if (entry->data == nullptr) {
+                freeSlot = entry;
+            } else if (!entry->valid || entry->refCount != 0) {
+                continue;
+            } else if (victim == nullptr || entry->lastUse < victim->lastUse) {
+                victim = entry;
+            }
+        }
+
+        if (freeSlot != nullptr && s_nandCacheUsed + size <= capacity) {
+            freeSlot->data = data;
+            freeSlot->size = size;
+            freeSlot->refCount = 0;
+            freeSlot->lastUse = ++s_nandCacheUseCounter;
+            freeSlot->uid = uid;
+            freeSlot->gid = gid;
+            freeSlot->valid = true;
+            std::strcpy(freeSlot->path, path);
+            s_nandCacheUsed += size;
+            s_nandCacheStats.inserts++;
+            break;
+        }
+
+        if (victim == nullptr) {
+            // Everything left is held by open handles
+            IOS_Free(System::GetHeap(), data);
+            return;
+        }
+
+        NANDCacheFree(victim);
+    }
+
+    PRINT(
+        IOS_EmuFS, INFO, "NAND cache: %u hits, %u misses, %u bytes used",
+        s_nandCacheStats.hits, s_nandCacheStats.misses, s_nandCacheUsed
+    );
+}
+
+/**
+ * Drop cached files at or below a NAND path after it may have changed.
+ */
+static void NANDCacheInvalidate(const char* path)
+{
+    u32 len = std::strlen(path);
+    while (len > 0 && path[len - 1] == ISFS::SEPARATOR_CHAR) {
+        len--;
+    }
+
+    ScopeLock lock(s_nandCacheMutex);
+
+    s_nandCacheGeneration++;
+
+    for (u32 i = 0; i < NAND_CACHE_COUNT; i++) {
+        NANDCacheEntry* entry = &s_nandCache[i];
+        if (entry->valid && std::strncmp(entry->path, path, len) == 0 &&
+            (entry->path[len] == '\0' ||
+             entry->path[len] == ISFS::SEPARATOR_CHAR)) {
+            NANDCacheFree(entry);
+            s_nandCacheStats.invalidations++;
+        }
+    }
+}
+
+DeviceEmuFS::NANDCacheStats DeviceEmuFS::GetNANDCacheStats()
+{
+    ScopeLock lock(s_nandCacheMutex);
+    return s_nandCacheStats;
+}
+
+/**
+ * Read the whole of a NAND file just opened for reading into the cache, and
+ * rewind it.
+ * @returns ISFS error code.
+ */
+s32 EmuFSHandle::LoadNANDCache(const char* path, u32 generation)
+{
+    IOS::File::Stats stats;
+    s32 ret = m_resource.Ioctl(
+        ISFS::ISFSIoctl::GET_FILE_STATS, nullptr, 0, &stats, sizeof(stats)
+    );
+    if (ret != ISFS::ISFSError::OK || stats.size == 0 ||
+        stats.size > NAND_CACHE_MAX_FILE_SIZE) {
+        return ISFS::ISFSError::OK;
+    }
+
+    u8* data =
+        static_cast<u8*>(IOS_AllocAligned(System::GetHeap(), stats.size, 32));
+    if (data == nullptr) {
+        return ISFS::ISFSError::OK;
+    }
+
+    const s32 bytesRead = m_resource.Read(data, stats.size);
+
+    ret = m_resource.Seek(0, IOS_SEEK_SET);
+    if (ret < 0) {
+        IOS_Free(System::GetHeap(), data);
+        return ret;
+    }
+
+    if (bytesRead != static_cast<s32>(stats.size)) {
+        IOS_Free(System::GetHeap(), data);
+        return ISFS::ISFSError::OK;
+    }
+
+    NANDCacheInsert(path, m_uid, m_gid, data, stats.size, generation);
+    return ISFS::ISFSError::OK;
+}
+
 /**
- * Reset a cached file handle.
+ * Reset a cached file handle for a new open request. The handle must have
+ * been claimed with ClaimProxyHandle.
+ * @returns ISFS error code. LOCKED if the backend file can't be used with the
+ * requested mode.
  */
-s32 EmuFSHandle::Reopen()
+s32 EmuFSHandle::Reopen(u32 mode, u32 uid, u16 gid)
 {
+    s32 fd = GetHandleIndex(this);
+    ASSERT(fd != HANDLE_NONE);
+
+    if (m_inUse || !std::holds_alternative<FIL>(m_file)) {
+        return ISFS::ISFSError::LOCKED;
+    }
+
+    const FIL* fil = &std::get<FIL>(m_file);
+    if (ISFSModeToFileMode(mode) & ~fil->flag & (FA_READ | FA_WRITE)) {
+        return ISFS::ISFSError::LOCKED;
+    }
+
+    m_fd = fd;
+    m_uid = uid;
+    m_gid = gid;
+    m_accessMode = mode;
+    m_inUse = true;
+
     s32 ret = Seek(0, IOS_SEEK_SET);
     if (ret != 0) {
+        m_inUse = false;
         return ret;
     }
 
@@ -585,13 +1526,15 @@ s32 EmuFSHandle::Reopen()
 
 /**
  * Handle open file request from the filesystem proxy.
- * Uses s_efsPath.
+ * Uses the request context path buffer.
  * @returns ISFS error code.
  */
 s32 EmuFSHandle::OpenFile(
     const char* path, u32 mode, u32 uid, u16 gid, bool redirect
 )
 {
+    auto& efsPath = GetRequestContext()->efsPath;
+
     PRINT(IOS_EmuFS, INFO, "Open file '%s' mode 0x%X", path, mode);
 
     if (path[0] != ISFS::SEPARATOR_CHAR) {
@@ -601,16 +1544,20 @@ s32 EmuFSHandle::OpenFile(
     // TODO: Add 'no redirect' as an extended flag to mode instead of having its
     // own parameter
     m_redirect = redirect;
+    m_uid = uid;
+    m_gid = gid;
 
     if (std::strcmp(path, "/dev/fs") == 0) {
         m_isManager = true;
         m_inUse = true;
 
-        new (&m_resource
-        ) IOS::ResourceCtrl<ISFS::ISFSIoctl>(IOS_OpenAsUid(path, mode, uid, gid)
-        );
+        new (&m_resource)
+            IOS::ResourceCtrl<ISFS::ISFSIoctl>(AcquireManagerFd(uid, gid));
+        if (m_resource.GetFd() < 0) {
+            return m_resource.GetFd();
+        }
 
-        return m_resource.GetFd();
+        return ISFS::ISFSError::OK;
     }
 
     if (PathElementCompare(path + 1, "dev") == 0) {
@@ -619,22 +1566,69 @@ s32 EmuFSHandle::OpenFile(
         return IOS::IOSError::INVALID;
     }
 
+    // Changes are made to the external copy of a redirected path
+    if (redirect && (mode & IOS::Mode::WRITE)) {
+        const s32 ret = RedirectCopyOnWrite(path);
+        if (ret != ISFS::ISFSError::OK) {
+            return ret;
+        }
+    }
+
     // Get the replaced path
-    if (!GetFATFSPath(path, s_efsPath, sizeof(s_efsPath), redirect)) {
-        if (s_efsPath[0] == '\0') {
+    if (!GetFATFSPath(path, efsPath, sizeof(efsPath), redirect)) {
+        if (efsPath[0] == '\0') {
             PRINT(IOS_EmuFS, ERROR, "Failed to get replaced path");
             return ISFS::ISFSError::INVALID;
         }
 
         // Opening a NAND file through this interface
         m_file = ISFSFileHandle();
+        m_efsPath[0] = '\0';
+
+        bool loadCache = false;
+        u32 cacheGeneration = 0;
+        if (mode == IOS::Mode::READ && IsNANDPathCacheable(efsPath)) {
+            m_nandCache = NANDCacheAcquire(efsPath, uid, gid);
+            if (m_nandCache != nullptr) {
+                m_file = ISFSFileHandle{
+                    .position = 0,
+                    .size = static_cast<s32>(m_nandCache->size),
+                };
+                new (&m_resource) IOS::ResourceCtrl<ISFS::ISFSIoctl>(-1);
+
+                m_isManager = false;
+                m_inUse = true;
+                m_backendFileOpened = true;
+                m_accessMode = mode;
+
+                return ISFS::ISFSError::OK;
+            }
+
+            loadCache = NANDCacheShouldLoad(efsPath, &cacheGeneration);
+        }
+
         new (&m_resource) IOS::ResourceCtrl<ISFS::ISFSIoctl>(
-            IOS_OpenAsUid(s_efsPath, mode, uid, gid)
+            IOS_OpenAsUid(efsPath, mode, uid, gid)
         );
         if (m_resource.GetFd() < 0) {
             return m_resource.GetFd();
         }
 
+        if (mode & IOS::Mode::WRITE) {
+            NANDCacheInvalidate(efsPath);
+            if (std::strlen(efsPath) < sizeof(m_efsPath)) {
+                std::strcpy(m_efsPath, efsPath);
+            }
+        }
+
+        if (loadCache) {
+            const s32 ret = LoadNANDCache(efsPath, cacheGeneration);
+            if (ret != ISFS::ISFSError::OK) {
+                m_resource.Close();
+                return ret;
+            }
+        }
+
         m_isManager = false;
         m_inUse = true;
         m_backendFileOpened = true;
@@ -647,10 +1641,16 @@ s32 EmuFSHandle::OpenFile(
     m_file = FIL();
     FIL* fil = &std::get<FIL>(m_file);
 
-    const FRESULT fresult = f_open(fil, s_efsPath, ISFSModeToFileMode(mode));
+    m_efsPath[0] = '\0';
+    if (std::strlen(efsPath) < sizeof(m_efsPath)) {
+        std::strcpy(m_efsPath, efsPath);
+    }
+
+    const FRESULT fresult =
+        FATCache::Open(fil, efsPath, ISFSModeToFileMode(mode));
     if (fresult != FR_OK) {
         PRINT(
-            IOS_EmuFS, ERROR, "Failed to open file '%s' error: %d", s_efsPath,
+            IOS_EmuFS, ERROR, "Failed to open file '%s' error: %d", efsPath,
             fresult
         );
         return FResultToISFSError(fresult);
@@ -666,291 +1666,1976 @@ s32 EmuFSHandle::OpenFile(
 
 /**
  * Handles direct open directory requests.
- * Uses s_efsPath.
+ * Uses the request context path buffer.
  * @returns File descriptor, or ISFS error code.
  */
 s32 EmuFSHandle::DirectDirOpen(const char* path)
 {
-    if (!GetFATFSPath(path, s_efsPath, sizeof(s_efsPath), m_redirect)) {
-        if (s_efsPath[0] == '\0') {
+    auto& efsPath = GetRequestContext()->efsPath;
+
+    // A unit that is being copied is only listed once all of it is copied
+    if (m_redirect) {
+        const s32 ret = MaterializeRedirect(path, false);
+        if (ret != ISFS::ISFSError::OK) {
+            return ret;
+        }
+    }
+
+    if (!GetFATFSPath(path, efsPath, sizeof(efsPath), m_redirect)) {
+        if (efsPath[0] == '\0') {
             return ISFS::ISFSError::INVALID;
         }
 
-        // NAND paths are not supported yet through this interface
-        return ISFS::ISFSError::NOT_FOUND;
+        // NAND paths are not supported yet through this interface
+        return ISFS::ISFSError::NOT_FOUND;
+    }
+
+    m_file = DIR();
+    DIR* dir = &std::get<DIR>(m_file);
+
+    const FRESULT fresult = f_opendir(dir, efsPath);
+    if (fresult != FR_OK) {
+        PRINT(
+            IOS_EmuFS, ERROR, "Failed to open dir '%s' error: %d", efsPath,
+            fresult
+        );
+        return FResultToISFSError(fresult);
+    }
+
+    m_inUse = true;
+    m_backendFileOpened = true;
+
+    return ISFS::ISFSError::OK;
+}
+
+/**
+ * Give back the shared /dev/fs descriptor of a manager handle.
+ */
+void EmuFSHandle::ReleaseManagerResource()
+{
+    if (m_resource.GetFd() < 0) {
+        return;
+    }
+
+    ReleaseManagerFd(m_resource.GetFd());
+    new (&m_resource) IOS::ResourceCtrl<ISFS::ISFSIoctl>(-1);
+}
+
+/**
+ * Close an open file handle.
+ * @returns IOS::IOSError::OK for success, or IOS/ISFS error code.
+ */
+s32 EmuFSHandle::Close()
+{
+    if (m_isManager) {
+        ReleaseManagerResource();
+    } else if (m_resource.GetFd() >= 0) {
+        [[maybe_unused]] s32 ret = m_resource.Close();
+        ASSERT(ret == IOS::IOSError::OK);
+
+        // Drop anything cached while the file was being written
+        if (std::holds_alternative<ISFSFileHandle>(m_file) &&
+            (m_accessMode & IOS::Mode::WRITE) && m_efsPath[0] != '\0') {
+            NANDCacheInvalidate(m_efsPath);
+        }
+    }
+
+    const bool keepBackend =
+        IsValidFile() && IsProxy() && std::holds_alternative<FIL>(m_file);
+
+    // Like on NAND, everything written must be on the disk once the file is
+    // closed
+    const s32 flushRet = FlushWriteBuffer();
+    ReleaseReadAhead();
+
+    m_inUse = false;
+
+    if (m_isManager) {
+        return ISFS::ISFSError::OK;
+    }
+
+    if (keepBackend) {
+        // Leave the file open for caching purposes if it's a proxy file
+        const FRESULT fresult = f_sync(&std::get<FIL>(m_file));
+        if (fresult != FR_OK) {
+            PRINT(IOS_EmuFS, ERROR, "Failed to sync file, error: %d", fresult);
+            return FResultToISFSError(fresult);
+        }
+
+        return flushRet;
+    }
+
+    const s32 ret = CloseBackend();
+    return flushRet != ISFS::ISFSError::OK ? flushRet : ret;
+}
+
+/**
+ * Close the backend file.
+ * @returns IOS::IOSError::OK for success, or IOS/ISFS error code.
+ */
+s32 EmuFSHandle::CloseBackend()
+{
+    if (!m_backendFileOpened) {
+        return ISFS::ISFSError::OK;
+    }
+
+    if (m_inUse) {
+        return ISFS::ISFSError::LOCKED;
+    }
+
+    if (std::holds_alternative<ISFSFileHandle>(m_file)) {
+        if (m_nandCache != nullptr) {
+            NANDCacheRelease(m_nandCache);
+            m_nandCache = nullptr;
+        }
+
+        if (m_resource.GetFd() < 0) {
+            return ISFS::ISFSError::OK;
+        }
+
+        const s32 ret = m_resource.Close();
+        if (ret < 0) {
+            return ret;
+        }
+    } else if (std::holds_alternative<ISFSReadDirCacheHandle>(m_file)) {
+        delete[] std::get<ISFSReadDirCacheHandle>(m_file).m_buffer;
+    } else if (std::holds_alternative<FIL>(m_file)) {
+        FlushWriteBuffer();
+        ReleaseReadAhead();
+
+        const FRESULT fresult = f_close(&std::get<FIL>(m_file));
+        if (fresult != FR_OK) {
+            PRINT(
+                IOS_EmuFS, ERROR, "Failed to close backend file, error: %d",
+                fresult
+            );
+            return FResultToISFSError(fresult);
+        }
+    } else if (std::holds_alternative<DIR>(m_file)) {
+        const FRESULT fresult = f_closedir(&std::get<DIR>(m_file));
+        if (fresult != FR_OK) {
+            PRINT(
+                IOS_EmuFS, ERROR,
+                "Failed to close backend directory, error: %d", fresult
+            );
+            return FResultToISFSError(fresult);
+        }
+
+    } else {
+        return ISFS::ISFSError::INVALID;
+    }
+
+    s32 fd = GetHandleIndex(this);
+    if (fd != HANDLE_NONE) {
+        ScopeLock lock(s_handleMutex);
+
+        if (IsProxy()) {
+            RemoveProxyIndex(fd);
+        }
+
+        // A cached handle becomes free. Handles in use are given back by
+        // their owner.
+        if (s_handleState[fd] == HandleState::CACHED) {
+            UnlinkLRU(fd);
+            s_handleState[fd] = HandleState::FREE;
+            s_freeNext[fd] = s_freeHead;
+            s_freeHead = fd;
+        }
+    }
+
+    m_file = ISFSFileHandle();
+    m_backendFileOpened = false;
+    m_proxyPath[0] = '\0';
+
+    return ISFS::ISFSError::OK;
+}
+
+static const FATFS* GetPathVolume(const char* efsPath)
+{
+    u32 drv = efsPath[0] - '0';
+    if (drv >= DiskManager::DeviceCount) {
+        return nullptr;
+    }
+
+    return DiskManager::s_instance->GetFilesystem(DiskManager::DRVToDevID(drv)
+    );
+}
+
+// Guards the usage and ReadDir caches below
+static Mutex s_cacheMutex;
+
+// Usage of external directory trees queried through GetUsage. The copied
+// redirect units are walked in the background when their volume is mounted,
+// and any other tree on the first query for it. Trees are then kept up to
+// date by EmuFS writes, creates and deletes, so further queries are answered
+// without any I/O.
+struct UsageEntry {
+    bool valid;
+    WORD fsId;
+    u32 lastUse;
+    u32 clusters;
+    u32 inodes;
+    char path[ISFS::MAX_PATH_LENGTH + 8];
+};
+
+static constexpr u32 USAGE_ENTRY_COUNT = 8;
+static constexpr u32 USAGE_SCAN_DEPTH = 12;
+// Usage is reported in NAND clusters like the real ISFS
+static constexpr u32 ISFS_CLUSTER_SIZE = 0x4000;
+
+static UsageEntry s_usage[USAGE_ENTRY_COUNT];
+static u32 s_usageUseCounter = 0;
+// Bumped on every change, so a scan that raced with a change isn't cached
+static u32 s_usageGeneration = 0;
+
+// Held while a tree is walked, so a query waits for the background scan to
+// finish instead of walking the same tree again
+static Mutex s_usageScanMutex;
+// Drives mounted since the background scan last ran
+static Queue<u32, 8> s_usageScanQueue;
+
+static u32 SizeToClusters(FSIZE_t size)
+{
+    return (size + ISFS_CLUSTER_SIZE - 1) / ISFS_CLUSTER_SIZE;
+}
+
+/**
+ * Apply a change to a file or directory at efsPath to every tracked tree
+ * containing it. An empty path drops every tracked tree instead.
+ */
+static void UsageUpdate(const char* efsPath, s32 clusterDelta, s32 inodeDelta)
+{
+    ScopeLock lock(s_cacheMutex);
+
+    s_usageGeneration++;
+
+    for (u32 i = 0; i < USAGE_ENTRY_COUNT; i++) {
+        UsageEntry* entry = &s_usage[i];
+        if (!entry->valid) {
+            continue;
+        }
+
+        if (efsPath[0] == '\0') {
+            entry->valid = false;
+            continue;
+        }
+
+        if (!IsPathUnder(efsPath, entry->path) ||
+            std::strcmp(efsPath, entry->path) == 0) {
+            continue;
+        }
+
+        entry->clusters = std::max<s32>(entry->clusters + clusterDelta, 0);
+        entry->inodes = std::max<s32>(entry->inodes + inodeDelta, 0);
+    }
+}
+
+/**
+ * Drop every tracked tree containing or inside efsPath. Used when a whole
+ * tree moves.
+ */
+static void UsageInvalidate(const char* efsPath)
+{
+    ScopeLock lock(s_cacheMutex);
+
+    s_usageGeneration++;
+
+    for (u32 i = 0; i < USAGE_ENTRY_COUNT; i++) {
+        UsageEntry* entry = &s_usage[i];
+        if (entry->valid && (IsPathUnder(efsPath, entry->path) ||
+                             IsPathUnder(entry->path, efsPath))) {
+            entry->valid = false;
+        }
+    }
+}
+
+/**
+ * Drop every tracked tree at or inside efsPath, which no longer exists. The
+ * trees containing it are left alone.
+ */
+static void UsageForget(const char* efsPath)
+{
+    ScopeLock lock(s_cacheMutex);
+
+    s_usageGeneration++;
+
+    for (u32 i = 0; i < USAGE_ENTRY_COUNT; i++) {
+        UsageEntry* entry = &s_usage[i];
+        if (entry->valid && IsPathUnder(entry->path, efsPath)) {
+            entry->valid = false;
+        }
+    }
+}
+
+/**
+ * Walk a directory tree and count the clusters and inodes below it.
+ * Overwrites path while walking.
+ */
+static FRESULT
+UsageScan(char* path, u32 pathSize, u32* clustersOut, u32* inodesOut)
+{
+    DIR dirs[USAGE_SCAN_DEPTH];
+    u32 pathLengths[USAGE_SCAN_DEPTH];
+    FILINFO info;
+    u32 clusters = 0, inodes = 0;
+
+    FRESULT fresult = f_opendir(&dirs[0], path);
+    if (fresult != FR_OK) {
+        return fresult;
+    }
+    pathLengths[0] = std::strlen(path);
+
+    s32 depth = 0;
+    while (depth >= 0) {
+        fresult = f_readdir(&dirs[depth], &info);
+        if (fresult != FR_OK) {
+            break;
+        }
+
+        if (info.fname[0] == '\0') {
+            f_closedir(&dirs[depth--]);
+            if (depth >= 0) {
+                path[pathLengths[depth]] = '\0';
+            }
+            continue;
+        }
+
+        inodes++;
+        if (!(info.fattrib & AM_DIR)) {
+            clusters += SizeToClusters(info.fsize);
+            continue;
+        }
+
+        u32 len = pathLengths[depth];
+        int ret = std::snprintf(
+            path + len, pathSize - len, "%s%s",
+            len > 0 && path[len - 1] == '/' ? "" : "/", info.fname
+        );
+        if (depth + 1 >= s32(USAGE_SCAN_DEPTH) || ret < 0 ||
+            u32(ret) >= pathSize - len) {
+            fresult = FR_NOT_ENOUGH_CORE;
+            break;
+        }
+
+        fresult = f_opendir(&dirs[depth + 1], path);
+        if (fresult != FR_OK) {
+            break;
+        }
+        pathLengths[++depth] = len + ret;
+    }
+
+    // Close anything still open after an error
+    for (; depth >= 0; depth--) {
+        f_closedir(&dirs[depth]);
+    }
+
+    if (fresult != FR_OK) {
+        PRINT(IOS_EmuFS, ERROR, "Usage scan failed, error: %d", fresult);
+        return fresult;
+    }
+
+    *clustersOut = clusters;
+    *inodesOut = inodes;
+    return FR_OK;
+}
+
+static u32 GetUsageGeneration()
+{
+    ScopeLock lock(s_cacheMutex);
+    return s_usageGeneration;
+}
+
+static bool UsageFind(const char* efsPath, u32* clustersOut, u32* inodesOut)
+{
+    const FATFS* fs = GetPathVolume(efsPath);
+    if (fs == nullptr) {
+        return false;
+    }
+
+    ScopeLock lock(s_cacheMutex);
+
+    for (u32 i = 0; i < USAGE_ENTRY_COUNT; i++) {
+        UsageEntry* entry = &s_usage[i];
+        if (!entry->valid) {
+            continue;
+        }
+
+        if (entry->fsId != fs->id) {
+            entry->valid = false;
+            continue;
+        }
+
+        if (std::strcmp(entry->path, efsPath) == 0) {
+            entry->lastUse = ++s_usageUseCounter;
+            *clustersOut = entry->clusters;
+            *inodesOut = entry->inodes;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Insert the result of a scan that started at the given usage generation.
+ */
+static void
+UsageInsert(const char* efsPath, u32 clusters, u32 inodes, u32 generation)
+{
+    const FATFS* fs = GetPathVolume(efsPath);
+    if (fs == nullptr ||
+        std::strlen(efsPath) >= sizeof(UsageEntry::path)) {
+        return;
+    }
+
+    ScopeLock lock(s_cacheMutex);
+
+    if (generation != s_usageGeneration) {
+        return;
+    }
+
+    UsageEntry* victim = &s_usage[0];
+    for (u32 i = 0; i < USAGE_ENTRY_COUNT; i++) {
+        if (!s_usage[i].valid) {
+            victim = &s_usage[i];
+            break;
+        }
+
+        if (s_usage[i].lastUse < victim->lastUse) {
+            victim = &s_usage[i];
+        }
+    }
+
+    victim->valid = true;
+    victim->fsId = fs->id;
+    victim->lastUse = ++s_usageUseCounter;
+    victim->clusters = clusters;
+    victim->inodes = inodes;
+    std::strcpy(victim->path, efsPath);
+}
+
+/**
+ * Get the usage of a directory tree from the table, walking it first if it's
+ * not tracked. Overwrites scanPath.
+ */
+static FRESULT UsageGet(
+    const char* efsPath, char* scanPath, u32 scanPathSize, u32* clustersOut,
+    u32* inodesOut
+)
+{
+    if (UsageFind(efsPath, clustersOut, inodesOut)) {
+        return FR_OK;
+    }
+
+    ScopeLock lock(s_usageScanMutex);
+
+    // The background scan may have walked it while this was waiting
+    if (UsageFind(efsPath, clustersOut, inodesOut)) {
+        return FR_OK;
+    }
+
+    const u32 generation = GetUsageGeneration();
+    std::strncpy(scanPath, efsPath, scanPathSize);
+    scanPath[scanPathSize - 1] = '\0';
+
+    const FRESULT fresult =
+        UsageScan(scanPath, scanPathSize, clustersOut, inodesOut);
+    if (fresult == FR_OK) {
+        UsageInsert(efsPath, *clustersOut, *inodesOut, generation);
+    }
+
+    return fresult;
+}
+
+/**
+ * Get the number of ISFS clusters in use on a whole volume. FatFs keeps the
+ * free cluster count, loaded from FSINFO on FAT32 or counted by the
+ * background scan after mount, so this doesn't walk any directory.
+ */
+static FRESULT GetVolumeUsage(const char* efsPath, u32* clustersOut)
+{
+    DWORD freeClusters;
+    FATFS* fs;
+    const FRESULT fresult = f_getfree(efsPath, &freeClusters, &fs);
+    if (fresult != FR_OK) {
+        return fresult;
+    }
+
+    const u64 usedSize =
+        u64(fs->n_fatent - 2 - freeClusters) * fs->csize * FF_MAX_SS;
+    *clustersOut = (usedSize + ISFS_CLUSTER_SIZE - 1) / ISFS_CLUSTER_SIZE;
+    return FR_OK;
+}
+
+/**
+ * Checks if an external path is the root of its volume, like "0:/".
+ */
+static bool IsVolumeRoot(const char* efsPath)
+{
+    return efsPath[2] == '\0' || (efsPath[2] == '/' && efsPath[3] == '\0');
+}
+
+/**
+ * Walk the usage of a newly mounted volume in the background: the free
+ * cluster count, and every copied redirect unit on it, as those are the
+ * trees games query.
+ */
+static s32 UsageScanThreadEntry([[maybe_unused]] void* arg)
+{
+    static char unitPath[ISFS::EMUFS_MAX_PATH_LENGTH];
+    static char scanPath[ISFS::EMUFS_MAX_PATH_LENGTH];
+    static char units[USAGE_ENTRY_COUNT][ISFS::MAX_PATH_LENGTH];
+
+    while (true) {
+        const u32 drv = s_usageScanQueue.Receive();
+
+        // Reads FSINFO, or counts the free clusters if it's not valid
+        char drivePath[] = "0:";
+        drivePath[0] = '0' + drv;
+        u32 clusters = 0, inodes = 0;
+        FRESULT fresult = GetVolumeUsage(drivePath, &clusters);
+        if (fresult != FR_OK) {
+            PRINT(
+                IOS_EmuFS, ERROR, "Failed to get free space on %s, error: %d",
+                drivePath, fresult
+            );
+            continue;
+        }
+
+        const char* root = Config::s_instance->GetNANDRedirectRoot();
+        if (root[0] != drivePath[0]) {
+            continue;
+        }
+
+        // The table only holds a few trees, so only the first units are
+        // walked
+        u32 unitCount;
+        {
+            ScopeLock lock(s_redirectMutex);
+            RedirectIndexLoad();
+            unitCount = std::min(s_redirectUnitCount, USAGE_ENTRY_COUNT);
+            for (u32 i = 0; i < unitCount; i++) {
+                std::strcpy(units[i], s_redirectUnits[i].path);
+            }
+        }
+
+        for (u32 i = 0; i < unitCount; i++) {
+            const s32 len = std::snprintf(
+                unitPath, sizeof(unitPath), "%s%s", root, units[i]
+            );
+            if (len < 0 || u32(len) >= sizeof(unitPath)) {
+                continue;
+            }
+
+            UsageGet(unitPath, scanPath, sizeof(scanPath), &clusters, &inodes);
+        }
+
+        PRINT(
+            IOS_EmuFS, INFO, "Scanned usage of %u redirected units", unitCount
+        );
+    }
+
+    // Can never reach here
+    return 0;
+}
+
+void DeviceEmuFS::NotifyMount(u32 drv)
+{
+    s_usageScanQueue.Send(drv);
+
+    // Pick up copies left unfinished on the volume
+    s_redirectCopyQueue.Send(0);
+}
+
+// Fixed size buffers lent to handles while they need them. Each buffer is
+// allocated from the system heap the first time it's needed and then kept, so
+// the pool takes no memory until the buffering is used.
+template <u32 TSize, u32 TCount>
+class HandleBufferPool
+{
+    static_assert(TCount <= 32);
+
+public:
+    static constexpr u32 BufferSize = TSize;
+
+    /**
+     * Take a free buffer.
+     * @returns The buffer, or nullptr if all are in use or the heap is full.
+     */
+    u8* Acquire()
+    {
+        ScopeLock lock(m_mutex);
+
+        for (u32 i = 0; i < TCount; i++) {
+            if (m_used & (1 << i)) {
+                continue;
+            }
+
+            if (m_buffers[i] == nullptr) {
+                m_buffers[i] = static_cast<u8*>(
+                    IOS_AllocAligned(System::GetHeap(), TSize, 32)
+                );
+                if (m_buffers[i] == nullptr) {
+                    return nullptr;
+                }
+            }
+
+            m_used |= 1 << i;
+            return m_buffers[i];
+        }
+
+        return nullptr;
+    }
+
+    void Release(u8* buffer)
+    {
+        ScopeLock lock(m_mutex);
+
+        u32 index = 0;
+        while (index < TCount && m_buffers[index] != buffer) {
+            index++;
+        }
+        ASSERT(index < TCount);
+        m_used &= ~(1 << index);
+    }
+
+private:
+    u8* m_buffers[TCount] = {};
+    u32 m_used = 0;
+    Mutex m_mutex;
+};
+
+// Buffers for gathering small writes to external files, see Write
+static HandleBufferPool<0x1000, 4> s_writeBufferPool;
+
+// Buffers for reading ahead of small sequential reads, see ReadFile
+static HandleBufferPool<0x1000, 4> s_readBufferPool;
+
+// Reads up to this size can be served from read-ahead
+static constexpr u32 READ_AHEAD_MAX_READ = s_readBufferPool.BufferSize / 2;
+// Size of the first read-ahead, doubled on every refill
+static constexpr u32 READ_AHEAD_MIN_WINDOW = FF_MAX_SS;
+
+/**
+ * Give back the read-ahead buffer without restoring the file position. Only
+ * for when the position doesn't matter anymore.
+ */
+void EmuFSHandle::ReleaseReadAhead()
+{
+    if (m_readBuffer != nullptr) {
+        s_readBufferPool.Release(m_readBuffer);
+        m_readBuffer = nullptr;
+    }
+
+    m_readPos = 0;
+    m_readLength = 0;
+    m_readWindow = 0;
+    m_readSequential = false;
+}
+
+/**
+ * Drop the read-ahead and move the file position back to where the caller
+ * is. Anything that uses the file position other than ReadFile must call
+ * this first.
+ * @returns ISFS error code.
+ */
+s32 EmuFSHandle::DropReadAhead()
+{
+    const u32 unread = m_readLength - m_readPos;
+    ReleaseReadAhead();
+
+    if (unread == 0) {
+        return ISFS::ISFSError::OK;
+    }
+
+    FIL* fil = &std::get<FIL>(m_file);
+    const FRESULT fresult = f_lseek(fil, f_tell(fil) - unread);
+    if (fresult != FR_OK) {
+        PRINT(
+            IOS_EmuFS, ERROR, "Failed to seek back handle %d, error: %d", m_fd,
+            fresult
+        );
+        return FResultToISFSError(fresult);
+    }
+
+    return ISFS::ISFSError::OK;
+}
+
+/**
+ * Read data from the external file. Once small reads are seen back to back,
+ * they're served from a read-ahead buffer that is refilled with a larger
+ * window each time, up to the buffer size. A seek elsewhere or a write drops
+ * it.
+ * @returns Amount read, or ISFS error code.
+ */
+s32 EmuFSHandle::ReadFile(u8* data, u32 len)
+{
+    FIL* fil = &std::get<FIL>(m_file);
+
+    // Serve what's left in the read-ahead first
+    u32 done = std::min(len, m_readLength - m_readPos);
+    if (done != 0) {
+        std::memcpy(data, m_readBuffer + m_readPos, done);
+        m_readPos += done;
+        if (done == len) {
+            return len;
+        }
+    }
+
+    // The rest of the read starts at the file position
+    const u32 remaining = len - done;
+
+    if (remaining <= READ_AHEAD_MAX_READ && m_readSequential) {
+        if (m_readBuffer == nullptr) {
+            m_readBuffer = s_readBufferPool.Acquire();
+        }
+
+        if (m_readBuffer != nullptr) {
+            m_readWindow = std::clamp<u32>(
+                m_readWindow * 2, READ_AHEAD_MIN_WINDOW,
+                s_readBufferPool.BufferSize
+            );
+
+            // End on a sector boundary, so the next refill is aligned and
+            // FatFS can read whole sectors straight into the buffer
+            u32 fill = std::max(m_readWindow, remaining);
+            const u32 overhang = (f_tell(fil) + fill) % FF_MAX_SS;
+            if (fill - overhang >= remaining) {
+                fill -= overhang;
+            }
+
+            u32 bytesRead;
+            const FRESULT fresult = f_read(fil, m_readBuffer, fill, &bytesRead);
+            if (fresult != FR_OK) {
+                PRINT(
+                    IOS_EmuFS, ERROR,
+                    "Failed to read %u bytes from handle %d, error: %d", fill,
+                    m_fd, fresult
+                );
+                m_readPos = m_readLength = 0;
+                return FResultToISFSError(fresult);
+            }
+
+            const u32 count = std::min(remaining, bytesRead);
+            std::memcpy(data + done, m_readBuffer, count);
+            m_readPos = count;
+            m_readLength = bytesRead;
+            return done + count;
+        }
+    }
+
+    // Large reads go straight to the file, and start the detection over
+    if (remaining > READ_AHEAD_MAX_READ) {
+        ReleaseReadAhead();
+    } else {
+        m_readSequential = true;
+    }
+
+    u32 bytesRead;
+    const FRESULT fresult = f_read(fil, data + done, remaining, &bytesRead);
+    if (fresult != FR_OK) {
+        PRINT(
+            IOS_EmuFS, ERROR, "Failed to read %u bytes from handle %d, error: %d",
+            remaining, m_fd, fresult
+        );
+        return FResultToISFSError(fresult);
+    }
+
+    return done + bytesRead;
+}
+
+/**
+ * Read data from an open file handle.
+ * @returns Amount read, or ISFS error code.
+ */
+s32 EmuFSHandle::Read(void* data, u32 len)
+{
+    if (!IsValidFile()) {
+        return ISFS::ISFSError::INVALID;
+    }
+
+    if (!(m_accessMode & IOS::Mode::READ)) {
+        return ISFS::ISFSError::ACCESS_DENIED;
+    }
+
+    if (len == 0) {
+        return ISFS::ISFSError::OK;
+    }
+
+    u32 bytesRead;
+    if (std::holds_alternative<FIL>(m_file)) {
+        s32 ret = FlushWriteBuffer();
+        if (ret != ISFS::ISFSError::OK) {
+            return ret;
+        }
+
+        ret = ReadFile(static_cast<u8*>(data), len);
+        if (ret < 0) {
+            return ret;
+        }
+        bytesRead = ret;
+    } else if (m_nandCache != nullptr) {
+        ISFSFileHandle* file = &std::get<ISFSFileHandle>(m_file);
+        bytesRead = std::min<u32>(len, file->size - file->position);
+        std::memcpy(data, m_nandCache->data + file->position, bytesRead);
+        file->position += bytesRead;
+    } else if (std::holds_alternative<ISFSFileHandle>(m_file)) {
+        const s32 ret = m_resource.Read(data, len);
+        if (ret < 0) {
+            return ret;
+        }
+        bytesRead = ret;
+    } else {
+        return ISFS::ISFSError::INVALID;
+    }
+
+    return bytesRead;
+}
+
+/**
+ * Write data to the external file at the file position.
+ * @returns Amount wrote, or ISFS error code.
+ */
+s32 EmuFSHandle::WriteFile(const void* data, u32 len)
+{
+    FIL* fil = &std::get<FIL>(m_file);
+    const FSIZE_t oldSize = f_size(fil);
+
+    u32 bytesWrote;
+    const FRESULT fresult = f_write(fil, data, len, &bytesWrote);
+
+    if (f_size(fil) != oldSize) {
+        UsageUpdate(
+            m_efsPath, SizeToClusters(f_size(fil)) - SizeToClusters(oldSize),
+            0
+        );
+    }
+
+    if (fresult != FR_OK) {
+        PRINT(
+            IOS_EmuFS, ERROR, "Failed to write %u bytes to handle %d, error: %d",
+            len, m_fd, fresult
+        );
+        return FResultToISFSError(fresult);
+    }
+
+    return bytesWrote;
+}
+
+/**
+ * Write out the small writes gathered in the write buffer. Anything that looks
+ * at the file position or contents must call this first.
+ * @returns ISFS error code.
+ */
+s32 EmuFSHandle::FlushWriteBuffer()
+{
+    if (m_writeLength == 0) {
+        return ISFS::ISFSError::OK;
+    }
+
+    const u32 len = m_writeLength;
+    const s32 ret = WriteFile(m_writeBuffer, len);
+
+    s_writeBufferPool.Release(m_writeBuffer);
+    m_writeBuffer = nullptr;
+    m_writeLength = 0;
+
+    if (ret < 0) {
+        return ret;
+    }
+
+    // Out of space
+    if (static_cast<u32>(ret) != len) {
+        return ISFS::ISFSError::UNKNOWN;
+    }
+
+    return ISFS::ISFSError::OK;
+}
+
+/**
+ * Write data to an open file handle. Small writes to external files are
+ * gathered in a write buffer, so a save written in many small pieces doesn't
+ * cost a sector read and write for each one. The buffer is written out when
+ * it fills up, before any other operation on the handle and on close, so a
+ * write error may be reported by a later call.
+ * @returns Amount wrote, or ISFS error code.
+ */
+s32 EmuFSHandle::Write(const void* data, u32 len)
+{
+    if (!IsValidFile()) {
+        return ISFS::ISFSError::INVALID;
+    }
+
+    if (!(m_accessMode & IOS::Mode::WRITE)) {
+        return ISFS::ISFSError::ACCESS_DENIED;
+    }
+
+    if (len == 0) {
+        return ISFS::ISFSError::OK;
+    }
+
+    u32 bytesWrote;
+    if (std::holds_alternative<FIL>(m_file)) {
+        s32 ret = DropReadAhead();
+        if (ret != ISFS::ISFSError::OK) {
+            return ret;
+        }
+
+        if (m_writeLength + len > s_writeBufferPool.BufferSize) {
+            ret = FlushWriteBuffer();
+            if (ret != ISFS::ISFSError::OK) {
+                return ret;
+            }
+        }
+
+        if (len < s_writeBufferPool.BufferSize && m_writeBuffer == nullptr) {
+            m_writeBuffer = s_writeBufferPool.Acquire();
+        }
+
+        if (len < s_writeBufferPool.BufferSize && m_writeBuffer != nullptr) {
+            std::memcpy(m_writeBuffer + m_writeLength, data, len);
+            m_writeLength += len;
+            return len;
+        }
+
+        ret = WriteFile(data, len);
+        if (ret < 0) {
+            return ret;
+        }
+        bytesWrote = ret;
+    } else if (std::holds_alternative<ISFSFileHandle>(m_file)) {
+        const s32 ret = m_resource.Write(data, len);
+        if (ret < 0) {
+            return ret;
+        }
+        bytesWrote = ret;
+    } else {
+        return ISFS::ISFSError::INVALID;
+    }
+
+    return bytesWrote;
+}
+
+/**
+ * Write out what other handles have buffered for an external file, so it can
+ * be read through a FIL of its own. Only idle handles are flushed, a request
+ * in flight on a handle isn't ordered against the current one anyway.
+ * Requests that arrive on a handle while it's flushed are sent to this lane,
+ * so they wait for the flush.
+ * @returns ISFS error code.
+ */
+static s32 FlushPathWriteBuffers(const char* efsPath)
+{
+    const u8 lane = GetRequestContext() - s_requestContexts;
+
+    for (s32 fd = 0; fd < ISFS::EMUFS_MAX_OPEN_COUNT; fd++) {
+        EmuFSHandle* handle = &s_handles[fd];
+
+        {
+            ScopeLock lock(s_routeMutex);
+            if (s_handlePending[fd] != 0 || handle->m_writeLength == 0 ||
+                strcasecmp(handle->m_efsPath, efsPath) != 0) {
+                continue;
+            }
+
+            s_handlePending[fd]++;
+            s_handleRoute[fd] = lane;
+        }
+
+        const s32 ret = handle->FlushWriteBuffer();
+
+        {
+            ScopeLock lock(s_routeMutex);
+            s_handlePending[fd]--;
+        }
+
+        if (ret != ISFS::ISFSError::OK) {
+            return ret;
+        }
+    }
+
+    return ISFS::ISFSError::OK;
+}
+
+static constexpr u32 COPY_CHUNK_SIZE_MAX = 0x10000; // 64 KB
+static constexpr u32 COPY_CHUNK_SIZE_MIN = 0x2000; // 8 KB
+
+/**
+ * Copy the rest of the source file into this file, replacing anything after
+ * the current position.
+ * @returns ISFS error code.
+ */
+s32 EmuFSHandle::CopyData(EmuFSHandle* source)
+{
+    if (!IsValidFile() || !source->IsValidFile()) {
+        return ISFS::ISFSError::INVALID;
+    }
+
+    if (!(m_accessMode & IOS::Mode::WRITE) ||
+        !(source->m_accessMode & IOS::Mode::READ)) {
+        return ISFS::ISFSError::ACCESS_DENIED;
+    }
+
+    s32 ret = FlushWriteBuffer();
+    if (ret == ISFS::ISFSError::OK) {
+        ret = source->FlushWriteBuffer();
+    }
+    if (ret == ISFS::ISFSError::OK) {
+        ret = source->DropReadAhead();
+    }
+    if (ret != ISFS::ISFSError::OK) {
+        return ret;
+    }
+
+    // Large chunks let FatFS transfer whole runs of sectors straight between
+    // the disk and the buffer. Fall back to smaller ones if the heap is
+    // fragmented.
+    u8* buffer = nullptr;
+    u32 chunkSize = COPY_CHUNK_SIZE_MAX;
+    for (; chunkSize >= COPY_CHUNK_SIZE_MIN; chunkSize /= 2) {
+        buffer = static_cast<u8*>(
+            IOS_AllocAligned(System::GetHeap(), chunkSize, 32)
+        );
+        if (buffer != nullptr) {
+            break;
+        }
+    }
+
+    if (buffer == nullptr) {
+        PRINT(IOS_EmuFS, ERROR, "CopyData: Failed to allocate copy buffer");
+        return ISFS::ISFSError::UNKNOWN;
+    }
+
+    FIL* dst = std::get_if<FIL>(&m_file);
+    FIL* src = std::get_if<FIL>(&source->m_file);
+
+    // Allocate an empty destination as one contiguous block, so the copy
+    // doesn't extend the cluster chain on every chunk. Not finding a large
+    // enough free block is fine, the writes will allocate as usual.
+    if (dst != nullptr && src != nullptr && f_size(dst) == 0 &&
+        f_tell(src) < f_size(src)) {
+        const FSIZE_t copySize = f_size(src) - f_tell(src);
+        if (f_expand(dst, copySize, 1) == FR_OK) {
+            UsageUpdate(m_efsPath, SizeToClusters(copySize), 0);
+        }
+    }
+
+    for (;;) {
+        ret = source->Read(buffer, chunkSize);
+        if (ret <= 0) {
+            break;
+        }
+
+        u32 writeLen = ret;
+        ret = Write(buffer, writeLen);
+        if (ret < 0) {
+            break;
+        }
+
+        if (static_cast<u32>(ret) != writeLen) {
+            ret = ISFS::ISFSError::UNKNOWN;
+            break;
+        }
+    }
+
+    IOS_Free(System::GetHeap(), buffer);
+
+    if (ret >= 0) {
+        ret = FlushWriteBuffer();
+    }
+
+    if (ret < 0) {
+        return ret;
+    }
+
+    // Drop old data or unused preallocated space past the copy
+    if (dst != nullptr && f_tell(dst) < f_size(dst)) {
+        const FSIZE_t oldSize = f_size(dst);
+        const FRESULT fresult = f_truncate(dst);
+        if (fresult != FR_OK) {
+            return FResultToISFSError(fresult);
+        }
+
+        UsageUpdate(
+            m_efsPath, SizeToClusters(f_size(dst)) - SizeToClusters(oldSize), 0
+        );
+    }
+
+    return ISFS::ISFSError::OK;
+}
+
+/**
+ * Moves the file read/write position of an open file descriptor.
+ * @returns New offset, or an ISFS error code.
+ */
+s32 EmuFSHandle::Seek(s32 where, s32 whence)
+{
+    if (!IsValidFile()) {
+        return ISFS::ISFSError::INVALID;
+    }
+
+    if (whence < IOS_SEEK_SET || whence > IOS_SEEK_END) {
+        return ISFS::ISFSError::INVALID;
+    }
+
+    if (std::holds_alternative<FIL>(m_file)) {
+        FIL* fil = &std::get<FIL>(m_file);
+        // Include any buffered writes and read-ahead
+        const FSIZE_t position =
+            f_tell(fil) + m_writeLength - (m_readLength - m_readPos);
+        FSIZE_t offset = position;
+        FSIZE_t endPosition = std::max(f_size(fil), position);
+
+        switch (whence) {
+        case IOS_SEEK_SET: {
+            offset = 0;
+            break;
+        }
+        case IOS_SEEK_CUR: {
+            break;
+        }
+        case IOS_SEEK_END: {
+            offset = endPosition;
+            break;
+        }
+        }
+
+        offset += where;
+        if (offset > endPosition) {
+            return ISFS::ISFSError::INVALID;
+        }
+
+        // Buffered writes can keep going if the position doesn't change
+        if (offset == position) {
+            PRINT(IOS_EmuFS, INFO, "Skipping seek");
+            return offset;
+        }
+
+        // Seeking within the read-ahead
+        if (m_readLength != 0 && offset <= f_tell(fil) &&
+            offset >= f_tell(fil) - m_readLength) {
+            m_readPos = offset - (f_tell(fil) - m_readLength);
+            return offset;
+        }
+
+        s32 ret = FlushWriteBuffer();
+        if (ret == ISFS::ISFSError::OK) {
+            ret = DropReadAhead();
+        }
+        if (ret != ISFS::ISFSError::OK) {
+            return ret;
+        }
+
+        if (offset == f_tell(fil)) {
+            PRINT(IOS_EmuFS, INFO, "Skipping seek");
+            return offset;
+        }
+
+        const FRESULT fresult = f_lseek(fil, offset);
+        if (fresult != FR_OK) {
+            PRINT(
+                IOS_EmuFS, ERROR,
+                "Failed to seek to position 0x%08X in handle %d", offset, m_fd
+            );
+            return FResultToISFSError(fresult);
+        }
+
+        return offset;
+    } else if (m_nandCache != nullptr) {
+        ISFSFileHandle* file = &std::get<ISFSFileHandle>(m_file);
+        s32 offset = where;
+        if (whence == IOS_SEEK_CUR) {
+            offset += file->position;
+        } else if (whence == IOS_SEEK_END) {
+            offset += file->size;
+        }
+
+        if (offset < 0 || offset > file->size) {
+            return ISFS::ISFSError::INVALID;
+        }
+
+        file->position = offset;
+        return offset;
+    } else if (std::holds_alternative<ISFSFileHandle>(m_file)) {
+        return m_resource.Seek(where, whence);
+    } else {
+        return ISFS::ISFSError::INVALID;
+    }
+}
+
+// Rendered ISFS name tables of recently listed external directories, so the
+// count and names calls of a listing only read the directory once. Any
+// create, delete or rename through EmuFS bumps the generation, which drops
+// every cached table. A count-only listing is cached without a table, and
+// is replaced by the full table once the names are read.
+struct ReadDirCacheEntry {
+    char* names;
+    u32 count;
+    u32 size;
+    u32 generation;
+    u32 lastUse;
+    WORD fsId;
+    char path[ISFS::MAX_PATH_LENGTH + 8];
+};
+
+static constexpr u32 READDIR_NAME_LENGTH = 13;
+static constexpr u32 READDIR_CACHE_COUNT = 8;
+
+static ReadDirCacheEntry s_readDirCache[READDIR_CACHE_COUNT];
+static u32 s_readDirCacheUsed = 0;
+static u32 s_readDirUseCounter = 0;
+static u32 s_dirGeneration = 1;
+
+static void ReadDirCacheFree(ReadDirCacheEntry* entry)
+{
+    if (entry->generation == 0) {
+        return;
+    }
+
+    s_readDirCacheUsed -= entry->size;
+    delete[] entry->names;
+    entry->names = nullptr;
+    entry->generation = 0;
+}
+
+/**
+ * Invalidate cached directory listings after a change to external storage.
+ */
+static void InvalidateReadDirCache()
+{
+    ScopeLock lock(s_cacheMutex);
+    s_dirGeneration++;
+}
+
+static u32 GetDirGeneration()
+{
+    ScopeLock lock(s_cacheMutex);
+    return s_dirGeneration;
+}
+
+/**
+ * Copy up to maxCount names of a cached listing to outNames.
+ * @returns True if the listing is cached.
+ */
+static bool ReadDirCacheFind(
+    const char* efsPath, char* outNames, u32 maxCount, u32* countOut
+)
+{
+    const FATFS* fs = GetPathVolume(efsPath);
+    if (fs == nullptr) {
+        return false;
+    }
+
+    ScopeLock lock(s_cacheMutex);
+
+    for (u32 i = 0; i < READDIR_CACHE_COUNT; i++) {
+        ReadDirCacheEntry* entry = &s_readDirCache[i];
+        if (entry->generation == 0) {
+            continue;
+        }
+
+        if (entry->generation != s_dirGeneration || entry->fsId != fs->id) {
+            ReadDirCacheFree(entry);
+            continue;
+        }
+
+        if (std::strcmp(entry->path, efsPath) == 0) {
+            if (outNames != nullptr && entry->names == nullptr &&
+                entry->count != 0) {
+                return false;
+            }
+
+            entry->lastUse = ++s_readDirUseCounter;
+            if (outNames != nullptr) {
+                std::memcpy(
+                    outNames, entry->names,
+                    std::min(maxCount, entry->count) * READDIR_NAME_LENGTH
+                );
+            }
+            *countOut = entry->count;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Insert a name table read at the given directory generation into the cache.
+ * Takes ownership of names, which is null for a count-only listing.
+ */
+static void ReadDirCacheInsert(
+    const char* efsPath, char* names, u32 count, u32 generation
+)
+{
+    const u32 size = names != nullptr ? count * READDIR_NAME_LENGTH : 0;
+    const u32 capacity = Config::s_instance->GetReadDirCacheSize();
+    const FATFS* fs = GetPathVolume(efsPath);
+
+    if (fs == nullptr || capacity == 0 || size > capacity ||
+        std::strlen(efsPath) >= sizeof(ReadDirCacheEntry::path)) {
+        delete[] names;
+        return;
+    }
+
+    ScopeLock lock(s_cacheMutex);
+
+    // Something changed while the directory was being read
+    if (generation != s_dirGeneration) {
+        delete[] names;
+        return;
+    }
+
+    // Replace a count-only listing of the same directory
+    for (u32 i = 0; i < READDIR_CACHE_COUNT; i++) {
+        ReadDirCacheEntry* entry = &s_readDirCache[i];
+        if (entry->generation != 0 && std::strcmp(entry->path, efsPath) == 0) {
+            ReadDirCacheFree(entry);
+        }
+    }
+
+    // Evict least recently used tables until there's room
+    for (;;) {
+        ReadDirCacheEntry* victim = nullptr;
+        u32 freeSlots = 0;
+        for (u32 i = 0; i < READDIR_CACHE_COUNT; i++) {
+            ReadDirCacheEntry* entry = &s_readDirCache[i];
+            if (entry->generation == 0) {
+                freeSlots++;
+            } else if (victim == nullptr || entry->lastUse < victim->lastUse) {
+                victim = entry;
+            }
+        }
+
+        if (freeSlots != 0 && s_readDirCacheUsed + size <= capacity) {
+            break;
+        }
+
+        ASSERT(victim != nullptr);
+        ReadDirCacheFree(victim);
+    }
+
+    for (u32 i = 0; i < READDIR_CACHE_COUNT; i++) {
+        ReadDirCacheEntry* entry = &s_readDirCache[i];
+        if (entry->generation != 0) {
+            continue;
+        }
+
+        entry->names = names;
+        entry->count = count;
+        entry->size = size;
+        entry->generation = generation;
+        entry->lastUse = ++s_readDirUseCounter;
+        entry->fsId = fs->id;
+        std::strcpy(entry->path, efsPath);
+        s_readDirCacheUsed += size;
+        return;
+    }
+}
+
+static constexpr u32 REDIRECT_COPY_CHUNK_SIZE = 0x2000; // 8 KB
+
+struct RedirectCopy {
+    s32 managerFd;
+    u8* buffer;
+    char isfsPath[ISFS::MAX_PATH_LENGTH];
+    char efsPath[ISFS::MAX_PATH_LENGTH + 64];
+    // Files are copied here first and then moved into place, so a partial
+    // copy is never served
+    char partPath[ISFS::MAX_PATH_LENGTH + 64];
+};
+
+/**
+ * Set up a copy of a unit.
+ * @returns ISFS error code.
+ */
+static s32 RedirectCopyInit(RedirectCopy* copy, const char* unit)
+{
+    std::strcpy(copy->isfsPath, unit);
+
+    const s32 len = std::snprintf(
+        copy->efsPath, sizeof(copy->efsPath), "%s%s",
+        Config::s_instance->GetNANDRedirectRoot(), unit
+    );
+    if (len < 0 || static_cast<u32>(len) + 5 >= sizeof(copy->efsPath)) {
+        return ISFS::ISFSError::INVALID;
+    }
+
+    std::snprintf(
+        copy->partPath, sizeof(copy->partPath), "%s.part", copy->efsPath
+    );
+
+    copy->buffer = static_cast<u8*>(
+        IOS_AllocAligned(System::GetHeap(), REDIRECT_COPY_CHUNK_SIZE, 32)
+    );
+    if (copy->buffer == nullptr) {
+        PRINT(IOS_EmuFS, ERROR, "RedirectCopyInit: Out of memory");
+        return ISFS::ISFSError::UNKNOWN;
+    }
+
+    copy->managerFd = AcquireManagerFd(0, 0);
+    if (copy->managerFd < 0) {
+        IOS_Free(System::GetHeap(), copy->buffer);
+        return copy->managerFd;
+    }
+
+    return ISFS::ISFSError::OK;
+}
+
+/**
+ * Release what a copy was set up with.
+ */
+static void RedirectCopyFree(RedirectCopy* copy)
+{
+    ReleaseManagerFd(copy->managerFd);
+    IOS_Free(System::GetHeap(), copy->buffer);
+}
+
+/**
+ * List a NAND directory as root.
+ * @param outNames Null to only get the count.
+ * @returns ISFS error code.
+ */
+static s32 RedirectReadDir(
+    const RedirectCopy* copy, char* outNames, u32* count
+)
+{
+    if (outNames == nullptr) {
+        IOS::IOVector<1, 1> vec;
+        vec.in[0].data = copy->isfsPath;
+        vec.in[0].len = ISFS::MAX_PATH_LENGTH;
+        vec.out[0].data = count;
+        vec.out[0].len = sizeof(u32);
+        return IOS_Ioctlv(
+            copy->managerFd, static_cast<u32>(ISFS::ISFSIoctl::READ_DIR), 1, 1,
+            vec.GetData()
+        );
+    }
+
+    u32 maxCount = *count;
+    IOS::IOVector<2, 2> vec;
+    vec.in[0].data = copy->isfsPath;
+    vec.in[0].len = ISFS::MAX_PATH_LENGTH;
+    vec.in[1].data = &maxCount;
+    vec.in[1].len = sizeof(u32);
+    vec.out[0].data = outNames;
+    vec.out[0].len = maxCount * READDIR_NAME_LENGTH;
+    vec.out[1].data = count;
+    vec.out[1].len = sizeof(u32);
+    return IOS_Ioctlv(
+        copy->managerFd, static_cast<u32>(ISFS::ISFSIoctl::READ_DIR), 2, 2,
+        vec.GetData()
+    );
+}
+
+
+/**
+ * Copy a NAND file to external storage. The copy mutex must be held.
+ * @param fd The file opened for reading, closed on return.
+ * @returns ISFS error code.
+ */
+static s32 RedirectCopyFile(RedirectCopy* copy, s32 fd)
+{
+    FIL fil;
+    FRESULT fresult =
+        FATCache::Open(&fil, copy->partPath, FA_CREATE_ALWAYS | FA_WRITE);
+    if (fresult != FR_OK) {
+        IOS_Close(fd);
+        return FResultToISFSError(fresult);
+    }
+
+    s32 ret;
+    while ((ret = IOS_Read(fd, copy->buffer, REDIRECT_COPY_CHUNK_SIZE)) > 0) {
+        UINT bytesWrote;
+        fresult = f_write(&fil, copy->buffer, ret, &bytesWrote);
+        if (fresult != FR_OK) {
+            ret = FResultToISFSError(fresult);
+            break;
+        }
+
+        if (bytesWrote != static_cast<UINT>(ret)) {
+            ret = ISFS::ISFSError::UNKNOWN;
+            break;
+        }
+    }
+
+    IOS_Close(fd);
+
+    fresult = f_close(&fil);
+    if (ret == ISFS::ISFSError::OK && fresult != FR_OK) {
+        ret = FResultToISFSError(fresult);
+    }
+
+    if (ret == ISFS::ISFSError::OK) {
+        ret = FResultToISFSError(
+            FATCache::Rename(copy->partPath, copy->efsPath)
+        );
+    }
+
+    if (ret != ISFS::ISFSError::OK) {
+        FATCache::Unlink(copy->partPath);
+    }
+
+    return ret;
+}
+
+/**
+ * Copy a path in a unit that is being copied, and the directories leading to
+ * it, unless they're already on external storage. Directories are created
+ * empty, and only the parts of the path that exist on NAND are copied, so a
+ * path that is about to be created gets its parent. The copy mutex must be
+ * held.
+ * @returns ISFS error code.
+ */
+static s32 RedirectCopyPath(RedirectCopy* copy, const char* isfsPath)
+{
+    const u32 isfsLength = std::strlen(copy->isfsPath);
+    const u32 efsLength = std::strlen(copy->efsPath);
+
+    s32 ret = ISFS::ISFSError::OK;
+    const char* element = isfsPath + isfsLength;
+    while (*element == ISFS::SEPARATOR_CHAR) {
+        const char* next = std::strchr(element + 1, ISFS::SEPARATOR_CHAR);
+        const u32 length =
+            next != nullptr ? next - isfsPath : std::strlen(isfsPath);
+        if (length >= sizeof(copy->isfsPath) ||
+            efsLength + length - isfsLength >= sizeof(copy->efsPath)) {
+            ret = ISFS::ISFSError::INVALID;
+            break;
+        }
+
+        std::memcpy(copy->isfsPath, isfsPath, length);
+        copy->isfsPath[length] = '\0';
+        std::memcpy(
+            copy->efsPath + efsLength, isfsPath + isfsLength,
+            length - isfsLength
+        );
+        copy->efsPath[efsLength + length - isfsLength] = '\0';
+        element = isfsPath + length;
+
+        if (FATCache::Stat(copy->efsPath, nullptr) == FR_OK) {
+            continue;
+        }
+
+        // NAND doesn't tell files and directories apart without listing the
+        // parent, so the path is opened as a file, and is a directory if that
+        // fails with anything but not found
+        const s32 fd = IOS_OpenAsUid(copy->isfsPath, IOS::Mode::READ, 0, 0);
+        if (fd >= 0) {
+            ret = RedirectCopyFile(copy, fd);
+        } else if (fd == ISFS::ISFSError::NOT_FOUND) {
+            break;
+        } else {
+            const FRESULT fresult = FATCache::Mkdir(copy->efsPath);
+            if (fresult != FR_OK && fresult != FR_EXIST) {
+                ret = FResultToISFSError(fresult);
+            }
+        }
+
+        if (ret != ISFS::ISFSError::OK) {
+            break;
+        }
+    }
+
+    copy->isfsPath[isfsLength] = '\0';
+    copy->efsPath[efsLength] = '\0';
+    return ret;
+}
+
+/**
+ * Copy the rest of a NAND directory tree to external storage. Files that are
+ * already there were changed since the copy started, or were copied by
+ * another lane, and are kept. Takes the copy mutex for each file, so changes
+ * to the unit go on in between.
+ * @returns ISFS error code.
+ */
+static s32 RedirectCopyDir(RedirectCopy* copy, u32 depth)
+{
+    u32 count = 0;
+    s32 ret = RedirectReadDir(copy, nullptr, &count);
+    if (ret != ISFS::ISFSError::OK) {
+        return ret;
+    }
+
+    FRESULT fresult = FATCache::Mkdir(copy->efsPath);
+    if (fresult != FR_OK && fresult != FR_EXIST) {
+        return FResultToISFSError(fresult);
+    }
+
+    if (count == 0) {
+        return ISFS::ISFSError::OK;
+    }
+
+    char* names = new char[count * READDIR_NAME_LENGTH];
+    ret = RedirectReadDir(copy, names, &count);
+
+    const u32 isfsLength = std::strlen(copy->isfsPath);
+    const u32 efsLength = std::strlen(copy->efsPath);
+    for (u32 i = 0; i < count && ret == ISFS::ISFSError::OK; i++) {
+        const char* name = names + i * READDIR_NAME_LENGTH;
+        if (std::snprintf(
+                copy->isfsPath + isfsLength,
+                sizeof(copy->isfsPath) - isfsLength, "/%s", name
+            ) >= static_cast<s32>(sizeof(copy->isfsPath) - isfsLength) ||
+            std::snprintf(
+                copy->efsPath + efsLength, sizeof(copy->efsPath) - efsLength,
+                "/%s", name
+            ) >= static_cast<s32>(sizeof(copy->efsPath) - efsLength)) {
+            ret = ISFS::ISFSError::INVALID;
+            break;
+        }
+
+        // NAND listings don't tell files and directories apart. Most entries
+        // are files, so each is opened as one, and only listed as a directory
+        // if that fails.
+        const s32 fd = IOS_OpenAsUid(copy->isfsPath, IOS::Mode::READ, 0, 0);
+        if (fd >= 0) {
+            ScopeLock lock(s_redirectCopyMutex);
+
+            if (FATCache::Stat(copy->efsPath, nullptr) == FR_OK) {
+                IOS_Close(fd);
+            } else {
+                ret = RedirectCopyFile(copy, fd);
+            }
+        } else if (fd != ISFS::ISFSError::NOT_FOUND &&
+                   depth < ISFS::MAX_PATH_DEPTH) {
+            ret = RedirectCopyDir(copy, depth + 1);
+        } else {
+            ret = fd;
+        }
+
+        copy->isfsPath[isfsLength] = '\0';
+        copy->efsPath[efsLength] = '\0';
+    }
+
+    delete[] names;
+    return ret;
+}
+
+/**
+ * Start moving a unit to external storage by creating its directory and the
+ * marker next to it. The unit isn't recorded yet. The copy mutex must be
+ * held.
+ * @param begunOut Set to false if the unit stays on NAND, because it doesn't
+ * exist there, no external storage is mounted or the index is full.
+ * @returns ISFS error code.
+ */
+static s32 RedirectBegin(RedirectCopy* copy, bool* begunOut)
+{
+    *begunOut = false;
+
+    {
+        ScopeLock lock(s_redirectMutex);
+
+        RedirectIndexLoad();
+        if (s_redirectVolume == nullptr) {
+            return ISFS::ISFSError::OK;
+        }
+
+        if (s_redirectUnitCount == REDIRECT_UNIT_COUNT) {
+            PRINT(
+                IOS_EmuFS, ERROR,
+                "Too many redirected units, '%s' stays on NAND", copy->isfsPath
+            );
+            return ISFS::ISFSError::OK;
+        }
+    }
+
+    // Nothing to copy if the unit isn't a directory on NAND, changes to it go
+    // to NAND
+    u32 count = 0;
+    const s32 ret = RedirectReadDir(copy, nullptr, &count);
+    if (ret == ISFS::ISFSError::NOT_FOUND || ret == ISFS::ISFSError::INVALID) {
+        return ISFS::ISFSError::OK;
+    }
+
+    if (ret != ISFS::ISFSError::OK) {
+        return ret;
+    }
+
+    // Create the parent directories of the unit
+    FRESULT fresult = FR_OK;
+    for (char* c = copy->efsPath + 3; (c = std::strchr(c, '/')) != nullptr;
+         c++) {
+        *c = '\0';
+        fresult = FATCache::Mkdir(copy->efsPath);
+        *c = '/';
+        if (fresult != FR_OK && fresult != FR_EXIST) {
+            return FResultToISFSError(fresult);
+        }
+    }
+
+    char markerPath[sizeof(copy->efsPath)];
+    std::snprintf(markerPath, sizeof(markerPath), "%s.tmp", copy->efsPath);
+
+    FIL fil;
+    fresult = FATCache::Open(&fil, markerPath, FA_CREATE_ALWAYS | FA_WRITE);
+    if (fresult == FR_OK) {
+        fresult = f_close(&fil);
     }
 
-    m_file = DIR();
-    DIR* dir = &std::get<DIR>(m_file);
+    if (fresult == FR_OK) {
+        fresult = FATCache::Mkdir(copy->efsPath);
+    }
 
-    const FRESULT fresult = f_opendir(dir, s_efsPath);
     if (fresult != FR_OK) {
-        PRINT(
-            IOS_EmuFS, ERROR, "Failed to open dir '%s' error: %d", s_efsPath,
-            fresult
-        );
+        FATCache::Unlink(markerPath);
         return FResultToISFSError(fresult);
     }
 
-    m_inUse = true;
-    m_backendFileOpened = true;
-
+    *begunOut = true;
     return ISFS::ISFSError::OK;
 }
 
 /**
- * Close an open file handle.
- * @returns IOS::IOSError::OK for success, or IOS/ISFS error code.
+ * Remove what was created for a path in a unit that was just started, the
+ * unit directory and its marker included. Only the path's directories are
+ * in the unit at that point, so they're removed from the bottom up.
  */
-s32 EmuFSHandle::Close()
+static void RedirectRemovePath(RedirectCopy* copy, const char* isfsPath)
 {
-    if (m_resource.GetFd() >= 0) {
-        [[maybe_unused]] s32 ret = m_resource.Close();
-        ASSERT(ret == IOS::IOSError::OK);
-    }
+    const u32 efsLength = std::strlen(copy->efsPath);
+    const u32 isfsLength = std::strlen(copy->isfsPath);
 
-    m_inUse = false;
-
-    if (m_isManager) {
-        return ISFS::ISFSError::OK;
-    }
-
-    if (IsValidFile() && IsProxy()) {
-        FIL* fil = &std::get<FIL>(m_file);
-        if (fil == nullptr) {
-            return CloseBackend();
-        }
+    char path[sizeof(copy->efsPath)];
+    std::snprintf(
+        path, sizeof(path), "%s%s", copy->efsPath, isfsPath + isfsLength
+    );
 
-        // Leave the file open for caching purposes if it's a proxy file
-        const FRESULT fresult = f_sync(fil);
-        if (fresult != FR_OK) {
-            PRINT(IOS_EmuFS, ERROR, "Failed to sync file, error: %d", fresult);
-            return FResultToISFSError(fresult);
+    for (u32 length = std::strlen(path); length >= efsLength; length--) {
+        if (path[length] == '\0' || path[length] == '/') {
+            path[length] = '\0';
+            FATCache::Unlink(path);
         }
-
-        return ISFS::ISFSError::OK;
     }
 
-    return CloseBackend();
+    std::snprintf(path, sizeof(path), "%s.tmp", copy->efsPath);
+    FATCache::Unlink(path);
 }
 
 /**
- * Close the backend file.
- * @returns IOS::IOSError::OK for success, or IOS/ISFS error code.
+ * Copy a redirected path to external storage ahead of a change to it, so the
+ * change doesn't reach NAND. Only the path itself is copied, the first change
+ * to a unit hands the rest of it to the copy thread. Does nothing if the path
+ * isn't redirected, its unit doesn't exist on NAND, or no external storage is
+ * mounted.
+ * @returns ISFS error code.
  */
-s32 EmuFSHandle::CloseBackend()
+static s32 RedirectCopyOnWrite(const char* isfsPath)
 {
-    if (!m_backendFileOpened) {
+    char unit[ISFS::MAX_PATH_LENGTH];
+    if (!IsISFSPathValid(isfsPath) || !GetRedirectUnit(isfsPath, unit)) {
         return ISFS::ISFSError::OK;
     }
 
-    if (m_inUse) {
-        return ISFS::ISFSError::LOCKED;
-    }
+    bool begun = false;
+    s32 ret;
+    {
+        // Paths are copied one at a time, so two lanes never copy the same
+        // path or start the same unit
+        ScopeLock copyLock(s_redirectCopyMutex);
 
-    if (std::holds_alternative<ISFSFileHandle>(m_file)) {
-        if (m_resource.GetFd() < 0) {
+        const RedirectState state = GetRedirectState(unit);
+        if (state == RedirectState::COPIED) {
             return ISFS::ISFSError::OK;
         }
 
-        const s32 ret = m_resource.Close();
-        if (ret < 0) {
+        RedirectCopy copy;
+        ret = RedirectCopyInit(&copy, unit);
+        if (ret != ISFS::ISFSError::OK) {
             return ret;
         }
-    } else if (std::holds_alternative<ISFSReadDirCacheHandle>(m_file)) {
-        delete[] std::get<ISFSReadDirCacheHandle>(m_file).m_buffer;
-    } else if (std::holds_alternative<FIL>(m_file)) {
-        const FRESULT fresult = f_close(&std::get<FIL>(m_file));
-        if (fresult != FR_OK) {
-            PRINT(
-                IOS_EmuFS, ERROR, "Failed to close backend file, error: %d",
-                fresult
-            );
-            return FResultToISFSError(fresult);
+
+        if (state == RedirectState::NAND) {
+            ret = RedirectBegin(&copy, &begun);
         }
-    } else if (std::holds_alternative<DIR>(m_file)) {
-        const FRESULT fresult = f_closedir(&std::get<DIR>(m_file));
-        if (fresult != FR_OK) {
-            PRINT(
-                IOS_EmuFS, ERROR,
-                "Failed to close backend directory, error: %d", fresult
-            );
-            return FResultToISFSError(fresult);
+
+        if (ret == ISFS::ISFSError::OK &&
+            (state == RedirectState::COPYING || begun)) {
+            ret = RedirectCopyPath(&copy, isfsPath);
         }
 
-    } else {
-        return ISFS::ISFSError::INVALID;
+        // A unit is only recorded once the changed path is copied, nothing
+        // else uses it before then
+        if (begun && ret == ISFS::ISFSError::OK) {
+            ScopeLock lock(s_redirectMutex);
+            if (!RedirectIndexInsert(unit, false)) {
+                ret = ISFS::ISFSError::UNKNOWN;
+            }
+        }
+
+        if (begun && ret != ISFS::ISFSError::OK) {
+            RedirectRemovePath(&copy, isfsPath);
+            begun = false;
+        }
+
+        RedirectCopyFree(&copy);
     }
 
-    m_file = ISFSFileHandle();
-    m_backendFileOpened = false;
-    m_proxyPath[0] = '\0';
+    if (ret != ISFS::ISFSError::OK) {
+        PRINT(
+            IOS_EmuFS, ERROR, "Failed to copy '%s' to external storage: %d",
+            isfsPath, ret
+        );
+        return ret;
+    }
+
+    if (begun) {
+        PRINT(IOS_EmuFS, INFO, "Redirecting '%s'", unit);
+        s_redirectCopyQueue.Send(0);
+    }
 
     return ISFS::ISFSError::OK;
 }
 
 /**
- * Read data from an open file handle.
- * @returns Amount read, or ISFS error code.
+ * Copy what's left of a unit that is being moved to external storage, and
+ * record it as copied.
+ * @returns ISFS error code.
  */
-s32 EmuFSHandle::Read(void* data, u32 len)
+static s32 RedirectFinish(const char* unit)
 {
-    if (!IsValidFile()) {
-        return ISFS::ISFSError::INVALID;
+    RedirectCopy copy;
+    s32 ret = RedirectCopyInit(&copy, unit);
+    if (ret != ISFS::ISFSError::OK) {
+        return ret;
     }
 
-    if (!(m_accessMode & IOS::Mode::READ)) {
-        return ISFS::ISFSError::ACCESS_DENIED;
+    u32 depth = 0;
+    for (const char* c = unit; *c != '\0'; c++) {
+        depth += *c == ISFS::SEPARATOR_CHAR;
     }
 
-    if (len == 0) {
-        return ISFS::ISFSError::OK;
-    }
+    ret = RedirectCopyDir(&copy, depth);
+    RedirectCopyFree(&copy);
 
-    u32 bytesRead;
-    if (std::holds_alternative<FIL>(m_file)) {
-        const FRESULT fresult =
-            f_read(&std::get<FIL>(m_file), data, len, &bytesRead);
-        if (fresult != FR_OK) {
-            PRINT(
-                IOS_EmuFS, ERROR,
-                "Failed to read %u bytes from handle %d, error: %d", len, m_fd,
-                fresult
+    if (ret == ISFS::ISFSError::OK) {
+        ScopeLock lock(s_redirectMutex);
+
+        RedirectUnit* entry = RedirectIndexFind(unit, HashProxyPath(unit));
+        if (entry != nullptr && !entry->copied) {
+            // A marker left behind only makes the next mount check the unit
+            // again
+            char markerPath[sizeof(copy.efsPath)];
+            std::snprintf(
+                markerPath, sizeof(markerPath), "%s.tmp", copy.efsPath
             );
-            return FResultToISFSError(fresult);
-        }
-    } else if (std::holds_alternative<ISFSFileHandle>(m_file)) {
-        const s32 ret = m_resource.Read(data, len);
-        if (ret < 0) {
-            return ret;
+            FATCache::Unlink(markerPath);
+            entry->copied = true;
         }
-        bytesRead = ret;
-    } else {
-        return ISFS::ISFSError::INVALID;
     }
 
-    return bytesRead;
+    InvalidateReadDirCache();
+    UsageInvalidate(copy.efsPath);
+
+    if (ret != ISFS::ISFSError::OK) {
+        PRINT(
+            IOS_EmuFS, ERROR, "Failed to copy '%s' to '%s': %d", unit,
+            copy.efsPath, ret
+        );
+        return ret;
+    }
+
+    PRINT(IOS_EmuFS, INFO, "Redirected '%s' to '%s'", unit, copy.efsPath);
+    return ISFS::ISFSError::OK;
 }
 
 /**
- * Write data to an open file handle.
- * @returns Amount wrote, or ISFS error code.
+ * Move all of the unit of a path to external storage, for changes that can't
+ * be made one path at a time and for listings, which must see all of it.
+ * Copies what the copy thread hasn't got to yet.
+ * @param begin Start moving the unit if it's still on NAND, otherwise only
+ * finish a move that's already started.
+ * @returns ISFS error code.
  */
-s32 EmuFSHandle::Write(const void* data, u32 len)
+static s32 MaterializeRedirect(const char* isfsPath, bool begin)
 {
-    if (!IsValidFile()) {
-        return ISFS::ISFSError::INVALID;
-    }
-
-    if (!(m_accessMode & IOS::Mode::WRITE)) {
-        return ISFS::ISFSError::ACCESS_DENIED;
-    }
-
-    if (len == 0) {
+    char unit[ISFS::MAX_PATH_LENGTH];
+    if (!GetRedirectUnit(isfsPath, unit)) {
         return ISFS::ISFSError::OK;
     }
 
-    u32 bytesWrote;
-    if (std::holds_alternative<FIL>(m_file)) {
-        const FRESULT fresult =
-            f_write(&std::get<FIL>(m_file), data, len, &bytesWrote);
-        if (fresult != FR_OK) {
-            PRINT(
-                IOS_EmuFS, ERROR,
-                "Failed to write %u bytes to handle %d, error: %d", len, m_fd,
-                fresult
-            );
-            return FResultToISFSError(fresult);
-        }
-    } else if (std::holds_alternative<ISFSFileHandle>(m_file)) {
-        const s32 ret = m_resource.Write(data, len);
-        if (ret < 0) {
+    RedirectState state = GetRedirectState(unit);
+    if (state == RedirectState::NAND && begin) {
+        const s32 ret = RedirectCopyOnWrite(unit);
+        if (ret != ISFS::ISFSError::OK) {
             return ret;
         }
-        bytesWrote = ret;
-    } else {
-        return ISFS::ISFSError::INVALID;
+
+        state = GetRedirectState(unit);
     }
 
-    return bytesWrote;
+    if (state != RedirectState::COPYING) {
+        return ISFS::ISFSError::OK;
+    }
+
+    return RedirectFinish(unit);
 }
 
 /**
- * Moves the file read/write position of an open file descriptor.
- * @returns New offset, or an ISFS error code.
+ * Copy the units that are being moved to external storage in the
+ * background, after the first change to a unit and after a mount, which may
+ * find unfinished copies. A unit that fails is tried again the next time.
  */
-s32 EmuFSHandle::Seek(s32 where, s32 whence)
+static s32 RedirectCopyThreadEntry([[maybe_unused]] void* arg)
 {
-    if (!IsValidFile()) {
-        return ISFS::ISFSError::INVALID;
-    }
+    char unit[ISFS::MAX_PATH_LENGTH];
 
-    if (whence < IOS_SEEK_SET || whence > IOS_SEEK_END) {
-        return ISFS::ISFSError::INVALID;
-    }
+    while (true) {
+        s_redirectCopyQueue.Receive();
 
-    if (std::holds_alternative<FIL>(m_file)) {
-        FIL* fil = &std::get<FIL>(m_file);
-        FSIZE_t offset = f_tell(fil);
-        FSIZE_t endPosition = f_size(fil);
+        // Units started in the meantime can move in the index, those also
+        // send a message, so anything missed is copied on the next pass
+        for (u32 i = 0;; i++) {
+            {
+                ScopeLock lock(s_redirectMutex);
 
-        switch (whence) {
-        case IOS_SEEK_SET: {
-            offset = 0;
-            break;
-        }
-        case IOS_SEEK_CUR: {
-            break;
-        }
-        case IOS_SEEK_END: {
-            offset = endPosition;
-            break;
-        }
-        }
+                RedirectIndexLoad();
+                while (i < s_redirectUnitCount && s_redirectUnits[i].copied) {
+                    i++;
+                }
 
-        offset += where;
-        if (offset > endPosition) {
-            return ISFS::ISFSError::INVALID;
-        }
+                if (i >= s_redirectUnitCount) {
+                    break;
+                }
 
-        if (offset == f_tell(fil)) {
-            PRINT(IOS_EmuFS, INFO, "Skipping seek");
-            return offset;
-        }
+                std::strcpy(unit, s_redirectUnits[i].path);
+            }
 
-        const FRESULT fresult = f_lseek(fil, offset);
-        if (fresult != FR_OK) {
-            PRINT(
-                IOS_EmuFS, ERROR,
-                "Failed to seek to position 0x%08X in handle %d", offset, m_fd
-            );
-            return FResultToISFSError(fresult);
+            RedirectFinish(unit);
         }
-
-        return offset;
-    } else if (std::holds_alternative<ISFSFileHandle>(m_file)) {
-        return m_resource.Seek(where, whence);
-    } else {
-        return ISFS::ISFSError::INVALID;
     }
+
+    // Can never reach here
+    return 0;
 }
 
 /**
  * Create a new directory.
- * Uses s_efsPath.
+ * Uses the request context path buffer.
  * @returns ISFS error code.
  */
 s32 EmuFSHandle::CreateDir(
     const char* path, u8 ownerPerm, u8 groupPerm, u8 otherPerm, u8 attributes
 )
 {
+    auto& efsPath = GetRequestContext()->efsPath;
+
     if (!m_isManager) {
         return ISFS::ISFSError::INVALID;
     }
 
+    // Changes are made to the external copy of a redirected path
+    if (m_redirect) {
+        const s32 ret = RedirectCopyOnWrite(path);
+        if (ret != ISFS::ISFSError::OK) {
+            return ret;
+        }
+    }
+
     // Get the replaced path
-    if (!GetFATFSPath(path, s_efsPath, sizeof(s_efsPath), m_redirect)) {
-        if (s_efsPath[0] == 0) {
+    if (!GetFATFSPath(path, efsPath, sizeof(efsPath), m_redirect, true)) {
+        if (efsPath[0] == 0) {
             return ISFS::ISFSError::NOT_FOUND;
         }
 
@@ -964,29 +3649,34 @@ s32 EmuFSHandle::CreateDir(
         );
     }
 
-    const FRESULT fresult = f_mkdir(path);
+    const FRESULT fresult = FATCache::Mkdir(efsPath);
+    InvalidateReadDirCache();
     if (fresult != FR_OK) {
         PRINT(
             IOS_EmuFS, ERROR, "CreateDir: Failed to create directory '%s'",
-            s_efsPath
+            efsPath
         );
         return FResultToISFSError(fresult);
     }
 
-    PRINT(IOS_EmuFS, INFO, "CreateDir: Created directory '%s'", s_efsPath);
+    UsageUpdate(efsPath, 0, 1);
+
+    PRINT(IOS_EmuFS, INFO, "CreateDir: Created directory '%s'", efsPath);
 
     return ISFS::ISFSError::OK;
 }
 
 /**
  * Read the contents of a directory using the ISFS interface.
- * Uses s_efsPath.
+ * Uses the request context path buffer.
  * @returns ISFS error code.
  */
 s32 EmuFSHandle::ReadDir(
     const char* path, char* outNames, u32 outNamesSize, u32* count
 )
 {
+    auto& efsPath = GetRequestContext()->efsPath;
+
     if (!m_isManager) {
         return ISFS::ISFSError::INVALID;
     }
@@ -999,9 +3689,17 @@ s32 EmuFSHandle::ReadDir(
         return ISFS::ISFSError::INVALID;
     }
 
+    // A unit that is being copied is only listed once all of it is copied
+    if (m_redirect) {
+        const s32 ret = MaterializeRedirect(path, false);
+        if (ret != ISFS::ISFSError::OK) {
+            return ret;
+        }
+    }
+
     // Get the replaced path
-    if (!GetFATFSPath(path, s_efsPath, sizeof(s_efsPath), m_redirect)) {
-        if (s_efsPath[0] == 0) {
+    if (!GetFATFSPath(path, efsPath, sizeof(efsPath), m_redirect)) {
+        if (efsPath[0] == 0) {
             return ISFS::ISFSError::NOT_FOUND;
         }
 
@@ -1010,7 +3708,7 @@ s32 EmuFSHandle::ReadDir(
             u32 tempCount = 0;
 
             IOS::IOVector<1, 1> vec;
-            vec.in[0].data = s_efsPath;
+            vec.in[0].data = efsPath;
             vec.in[0].len = ISFS::MAX_PATH_LENGTH;
             vec.out[0].data = &tempCount;
             vec.out[0].len = sizeof(u32);
@@ -1026,7 +3724,7 @@ s32 EmuFSHandle::ReadDir(
             u32 tempCount = 0;
 
             IOS::IOVector<2, 2> vec;
-            vec.in[0].data = s_efsPath;
+            vec.in[0].data = efsPath;
             vec.in[0].len = ISFS::MAX_PATH_LENGTH;
             vec.in[1].data = &maxCount;
             vec.in[1].len = sizeof(u32);
@@ -1046,8 +3744,16 @@ s32 EmuFSHandle::ReadDir(
         return ISFS::ISFSError::OK;
     }
 
+    u32 maxCount = outNames != nullptr ? *count : 0;
+
+    if (ReadDirCacheFind(efsPath, outNames, maxCount, count)) {
+        return ISFS::ISFSError::OK;
+    }
+
+    const u32 generation = GetDirGeneration();
+
     DIR dir = {};
-    FRESULT fresult = f_opendir(&dir, s_efsPath);
+    FRESULT fresult = f_opendir(&dir, efsPath);
     if (fresult != FR_OK) {
         PRINT(IOS_EmuFS, ERROR, "Failed to open directory, error: %d", fresult);
         return FResultToISFSError(fresult);
@@ -1055,8 +3761,7 @@ s32 EmuFSHandle::ReadDir(
 
     FILINFO info = {};
     u32 entry = 0;
-    u32 maxCount = *count;
-    for (; (fresult = f_readdir(&dir, &info)) == FR_OK; entry++) {
+    while ((fresult = f_readdir(&dir, &info)) == FR_OK) {
         ASSERT(entry < INT_MAX);
 
         const char* name = info.fname;
@@ -1074,11 +3779,17 @@ s32 EmuFSHandle::ReadDir(
             name = info.altname;
         }
 
+        char nameData[READDIR_NAME_LENGTH] = {};
+        std::strncpy(nameData, name, sizeof(nameData));
+
         if (entry < maxCount) {
-            char nameData[13] = {};
-            std::strncpy(nameData, name, sizeof(nameData));
-            std::memcpy(outNames + entry * 13, nameData, sizeof(nameData));
+            std::memcpy(
+                outNames + entry * READDIR_NAME_LENGTH, nameData,
+                sizeof(nameData)
+            );
         }
+
+        entry++;
     }
 
     const FRESULT fresult2 = f_closedir(&dir);
@@ -1092,6 +3803,22 @@ s32 EmuFSHandle::ReadDir(
         return FResultToISFSError(fresult);
     }
 
+    // The table is copied from the caller's output once the size of the
+    // listing is known. A count-only call or a listing cut short by maxCount
+    // caches just the count.
+    const u32 tableSize = entry * READDIR_NAME_LENGTH;
+    if (Config::s_instance->GetReadDirCacheSize() >= tableSize) {
+        char* names = nullptr;
+        if (outNames != nullptr && entry != 0 && entry <= maxCount) {
+            names = new char[tableSize];
+            if (names != nullptr) {
+                std::memcpy(names, outNames, tableSize);
+            }
+        }
+
+        ReadDirCacheInsert(efsPath, names, entry, generation);
+    }
+
     PRINT(IOS_EmuFS, INFO, "Count: %u", entry);
     *count = entry;
 
@@ -1100,7 +3827,7 @@ s32 EmuFSHandle::ReadDir(
 
 /**
  * Set attributes for a file or directory.
- * Uses s_efsPath.
+ * Uses the request context path buffer.
  * @returns ISFS error code.
  */
 s32 EmuFSHandle::SetAttr(
@@ -1108,13 +3835,23 @@ s32 EmuFSHandle::SetAttr(
     u8 otherPerm, u8 attributes
 )
 {
+    auto& efsPath = GetRequestContext()->efsPath;
+
     if (!m_isManager) {
         return ISFS::ISFSError::INVALID;
     }
 
+    // Changes are made to the external copy of a redirected path
+    if (m_redirect) {
+        const s32 ret = MaterializeRedirect(path, true);
+        if (ret != ISFS::ISFSError::OK) {
+            return ret;
+        }
+    }
+
     // Get the replaced path
-    if (!GetFATFSPath(path, s_efsPath, sizeof(s_efsPath))) {
-        if (s_efsPath[0] == 0) {
+    if (!GetFATFSPath(path, efsPath, sizeof(efsPath), m_redirect)) {
+        if (efsPath[0] == 0) {
             return ISFS::ISFSError::NOT_FOUND;
         }
 
@@ -1122,24 +3859,27 @@ s32 EmuFSHandle::SetAttr(
         ISFS::AttrBlock attr = {ownerId,   groupId,   {},         ownerPerm,
                                 groupPerm, otherPerm, attributes, {}};
         std::strncpy(attr.path, path, sizeof(attr.path));
-        return m_resource.Ioctl(
+        const s32 ret = m_resource.Ioctl(
             ISFS::ISFSIoctl::SET_ATTR, &attr, sizeof(attr), nullptr, 0
         );
+        // Cached files were only checked against the old permissions
+        NANDCacheInvalidate(path);
+        return ret;
     }
 
-    const FRESULT fresult = f_stat(s_efsPath, nullptr);
+    const FRESULT fresult = FATCache::Stat(efsPath, nullptr);
     if (fresult != FR_OK) {
         PRINT(
             IOS_EmuFS, ERROR,
             "SetAttr: Failed to set attributes for file or directory '%s'",
-            s_efsPath
+            efsPath
         );
         return FResultToISFSError(fresult);
     }
 
     PRINT(
         IOS_EmuFS, INFO, "SetAttr: Set attributes for file or directory '%s'",
-        s_efsPath
+        efsPath
     );
 
     return ISFS::ISFSError::OK;
@@ -1147,7 +3887,7 @@ s32 EmuFSHandle::SetAttr(
 
 /**
  * Get attributes for a file or directory.
- * Uses s_efsPath.
+ * Uses the request context path buffer.
  * @returns ISFS error code.
  */
 s32 EmuFSHandle::GetAttr(
@@ -1155,6 +3895,8 @@ s32 EmuFSHandle::GetAttr(
     u8* otherPerm, u8* attributes
 )
 {
+    auto& efsPath = GetRequestContext()->efsPath;
+
     if (!m_isManager) {
         return ISFS::ISFSError::INVALID;
     }
@@ -1168,8 +3910,8 @@ s32 EmuFSHandle::GetAttr(
                             GROUP_PERM, OTHER_PERM, ATTRIBUTES, {}};
 
     // Get the replaced path
-    if (!GetFATFSPath(path, s_efsPath, sizeof(s_efsPath), m_redirect)) {
-        if (s_efsPath[0] == 0) {
+    if (!GetFATFSPath(path, efsPath, sizeof(efsPath), m_redirect)) {
+        if (efsPath[0] == 0) {
             return ISFS::ISFSError::NOT_FOUND;
         }
 
@@ -1183,11 +3925,11 @@ s32 EmuFSHandle::GetAttr(
         }
     } else {
         // Test that the file exists
-        const FRESULT fresult = f_stat(s_efsPath, nullptr);
+        const FRESULT fresult = FATCache::Stat(efsPath, nullptr);
         if (fresult != FR_OK) {
             PRINT(
                 IOS_EmuFS, ERROR,
-                "Failed to get attributes for file or directory '%s'", s_efsPath
+                "Failed to get attributes for file or directory '%s'", efsPath
             );
             return FResultToISFSError(fresult);
         }
@@ -1205,25 +3947,37 @@ s32 EmuFSHandle::GetAttr(
 
 /**
  * Delete a file or directory.
- * Uses s_efsPath.
+ * Uses the request context path buffer.
  * @returns ISFS error code.
  */
 s32 EmuFSHandle::Delete(const char* path)
 {
+    auto& efsPath = GetRequestContext()->efsPath;
+
     if (!m_isManager) {
         return ISFS::ISFSError::INVALID;
     }
 
+    // Changes are made to the external copy of a redirected path
+    if (m_redirect) {
+        const s32 ret = MaterializeRedirect(path, true);
+        if (ret != ISFS::ISFSError::OK) {
+            return ret;
+        }
+    }
+
     // Get the replaced path
-    if (!GetFATFSPath(path, s_efsPath, sizeof(s_efsPath), m_redirect)) {
-        if (s_efsPath[0] == 0) {
+    if (!GetFATFSPath(path, efsPath, sizeof(efsPath), m_redirect)) {
+        if (efsPath[0] == 0) {
             return ISFS::ISFSError::NOT_FOUND;
         }
 
         // NAND path
-        return m_resource.Ioctl(
+        const s32 ret = m_resource.Ioctl(
             ISFS::ISFSIoctl::DELETE, path, ISFS::MAX_PATH_LENGTH, nullptr, 0
         );
+        NANDCacheInvalidate(path);
+        return ret;
     }
 
     // Check if the path is a mounted path or a proxied NAND path
@@ -1234,40 +3988,74 @@ s32 EmuFSHandle::Delete(const char* path)
         }
     }
 
-    const FRESULT fresult = f_unlink(s_efsPath);
+    // Get the size first for usage accounting
+    FILINFO info;
+    if (FATCache::Stat(efsPath, &info) != FR_OK) {
+        info.fattrib = AM_DIR;
+        info.fsize = 0;
+    }
+
+    const FRESULT fresult = FATCache::Unlink(efsPath);
+    InvalidateReadDirCache();
     if (fresult != FR_OK) {
         PRINT(
             IOS_EmuFS, ERROR, "Failed to delete file or directory '%s'",
-            s_efsPath
+            efsPath
         );
         return FResultToISFSError(fresult);
     }
 
-    PRINT(IOS_EmuFS, INFO, "Deleted file or directory '%s'", s_efsPath);
+    // Only the removed entry changes, so the trees containing it stay valid.
+    // f_unlink only removes empty directories, so a deleted directory was at
+    // most tracked as an empty tree of its own.
+    if (info.fattrib & AM_DIR) {
+        UsageForget(efsPath);
+    }
+    UsageUpdate(
+        efsPath,
+        (info.fattrib & AM_DIR) ? 0 : -s32(SizeToClusters(info.fsize)), -1
+    );
+
+    PRINT(IOS_EmuFS, INFO, "Deleted file or directory '%s'", efsPath);
 
     return ISFS::ISFSError::OK;
 }
 
 /**
  * Rename a file or directory.
- * Uses s_efsPath and s_efsPath2.
+ * Uses the request context path buffers.
  * @returns ISFS error code.
  */
 s32 EmuFSHandle::Rename(const char* pathOld, const char* pathNew)
 {
+    RequestContext* context = GetRequestContext();
+    auto& efsPath = context->efsPath;
+    auto& efsPath2 = context->efsPath2;
+
     if (!m_isManager) {
         return ISFS::ISFSError::INVALID;
     }
 
+    // Changes are made to the external copies of redirected paths
+    if (m_redirect) {
+        s32 ret = MaterializeRedirect(pathOld, true);
+        if (ret == ISFS::ISFSError::OK) {
+            ret = MaterializeRedirect(pathNew, true);
+        }
+        if (ret != ISFS::ISFSError::OK) {
+            return ret;
+        }
+    }
+
     // Use one character path to get the device
-    char *efsOldPath = s_efsPath, *efsNewPath = s_efsPath2;
+    char *efsOldPath = efsPath, *efsNewPath = efsPath2;
 
-    if (!GetFATFSPath(pathOld, efsOldPath, sizeof(efsOldPath), m_redirect) &&
+    if (!GetFATFSPath(pathOld, efsOldPath, sizeof(efsPath), m_redirect) &&
         efsOldPath[0] == 0) {
         return ISFS::ISFSError::NOT_FOUND;
     }
 
-    if (!GetFATFSPath(pathNew, efsNewPath, sizeof(efsNewPath), m_redirect) &&
+    if (!GetFATFSPath(pathNew, efsNewPath, sizeof(efsPath2), m_redirect) &&
         efsNewPath[0] == 0) {
         return ISFS::ISFSError::NOT_FOUND;
     }
@@ -1281,19 +4069,24 @@ s32 EmuFSHandle::Rename(const char* pathOld, const char* pathNew)
         std::strncpy(
             renameBlock.pathNew, efsNewPath, sizeof(renameBlock.pathNew)
         );
-        return m_resource.Ioctl(
+        const s32 ret = m_resource.Ioctl(
             ISFS::ISFSIoctl::RENAME, &renameBlock, sizeof(renameBlock), nullptr,
             0
         );
+        NANDCacheInvalidate(renameBlock.pathOld);
+        NANDCacheInvalidate(renameBlock.pathNew);
+        return ret;
     }
 
-    if (m_redirect) {
-        s32 ret = TryCloseProxyHandle(pathOld);
+    // Cached handles are keyed by ISFS path, so none may be left under
+    // either path once a file or directory moves
+    {
+        s32 ret = TryCloseProxyHandlesUnder(pathOld);
         if (ret != ISFS::ISFSError::OK) {
             return ret;
         }
 
-        ret = TryCloseProxyHandle(pathNew);
+        ret = TryCloseProxyHandlesUnder(pathNew);
         if (ret != ISFS::ISFSError::OK) {
             return ret;
         }
@@ -1301,15 +4094,33 @@ s32 EmuFSHandle::Rename(const char* pathOld, const char* pathNew)
 
     if (efsOldPath[0] == efsNewPath[0]) {
         // Same external device
-        const FRESULT fresult = f_rename(efsOldPath, efsNewPath);
+        FILINFO info;
+        if (FATCache::Stat(efsOldPath, &info) != FR_OK) {
+            info.fattrib = AM_DIR;
+        }
+
+        const FRESULT fresult = FATCache::Rename(efsOldPath, efsNewPath);
+        InvalidateReadDirCache();
         if (fresult != FR_OK) {
             PRINT(
                 IOS_EmuFS, ERROR,
                 "Failed to rename file or directory '%s' -> '%s'", efsOldPath,
                 efsNewPath
             );
+            return FResultToISFSError(fresult);
         }
-        return FResultToISFSError(fresult);
+
+        if (info.fattrib & AM_DIR) {
+            // The usage of the moved tree isn't known
+            UsageInvalidate(efsOldPath);
+            UsageInvalidate(efsNewPath);
+        } else {
+            s32 fileClusters = SizeToClusters(info.fsize);
+            UsageUpdate(efsOldPath, -fileClusters, -1);
+            UsageUpdate(efsNewPath, fileClusters, 1);
+        }
+
+        return ISFS::ISFSError::OK;
     }
 
     // Cross filesystem rename
@@ -1369,20 +4180,30 @@ s32 EmuFSHandle::Rename(const char* pathOld, const char* pathNew)
 
 /**
  * Create a new file.
- * Uses s_efsPath.
+ * Uses the request context path buffer.
  * @returns ISFS error code.
  */
 s32 EmuFSHandle::CreateFile(
     const char* path, u8 ownerPerm, u8 groupPerm, u8 otherPerm, u8 attributes
 )
 {
+    auto& efsPath = GetRequestContext()->efsPath;
+
     if (!m_isManager) {
         return ISFS::ISFSError::INVALID;
     }
 
+    // Changes are made to the external copy of a redirected path
+    if (m_redirect) {
+        const s32 ret = RedirectCopyOnWrite(path);
+        if (ret != ISFS::ISFSError::OK) {
+            return ret;
+        }
+    }
+
     // Get the replaced path
-    if (!GetFATFSPath(path, s_efsPath, sizeof(s_efsPath), m_redirect)) {
-        if (s_efsPath[0] == 0) {
+    if (!GetFATFSPath(path, efsPath, sizeof(efsPath), m_redirect, true)) {
+        if (efsPath[0] == 0) {
             return ISFS::ISFSError::NOT_FOUND;
         }
 
@@ -1390,26 +4211,31 @@ s32 EmuFSHandle::CreateFile(
         ISFS::AttrBlock attr = {m_uid,     m_gid,     {},         ownerPerm,
                                 groupPerm, otherPerm, attributes, {}};
         std::strncpy(attr.path, path, sizeof(attr.path));
-        return m_resource.Ioctl(
+        const s32 ret = m_resource.Ioctl(
             ISFS::ISFSIoctl::DELETE, path, ISFS::MAX_PATH_LENGTH, nullptr, 0
         );
+        NANDCacheInvalidate(path);
+        return ret;
     }
 
     FIL fil;
     const FRESULT fresult =
-        f_open(&fil, s_efsPath, FA_CREATE_NEW | FA_READ | FA_WRITE);
+        FATCache::Open(&fil, efsPath, FA_CREATE_NEW | FA_READ | FA_WRITE);
+    InvalidateReadDirCache();
     if (fresult != FR_OK) {
-        PRINT(IOS_EmuFS, ERROR, "Failed to create file '%s'", s_efsPath);
+        PRINT(IOS_EmuFS, ERROR, "Failed to create file '%s'", efsPath);
         return FResultToISFSError(fresult);
     }
 
     f_sync(&fil);
 
+    UsageUpdate(efsPath, 0, 1);
+
     // Cache the file handle
     if (m_redirect && IsISFSPathValid(path) &&
-        PathElementCompare(path + 1, EMUFS_MOUNT_POINT) == 0) {
+        PathElementCompare(path + 1, EMUFS_MOUNT_POINT + 1) == 0) {
         s32 ret = FindFreeHandle();
-        if (ret < 0 || ret >= ISFS::MAX_OPEN_COUNT) {
+        if (ret < 0) {
             f_close(&fil);
             return ISFS::ISFSError::OK;
         }
@@ -1424,7 +4250,10 @@ s32 EmuFSHandle::CreateFile(
 
         handle->m_backendFileOpened = true;
         handle->m_file = fil;
-        std::strncpy(handle->m_proxyPath, path, ISFS::MAX_PATH_LENGTH);
+        if (!handle->SetProxyPath(path)) {
+            handle->CloseBackend();
+        }
+        ReleaseHandle(ret);
 
         return ISFS::ISFSError::OK;
     }
@@ -1434,22 +4263,39 @@ s32 EmuFSHandle::CreateFile(
     return ISFS::ISFSError::OK;
 }
 
+/**
+ * Get the number of clusters and inodes used by a directory tree.
+ * Uses the request context path buffers.
+ * @returns ISFS error code.
+ */
 s32 EmuFSHandle::GetUsage(const char* path, u32* clusters, u32* inodes)
 {
+    RequestContext* context = GetRequestContext();
+    auto& efsPath = context->efsPath;
+    auto& efsPath2 = context->efsPath2;
+
     if (!m_isManager) {
         return ISFS::ISFSError::INVALID;
     }
 
+    // A unit that is being copied is only measured once all of it is copied
+    if (m_redirect) {
+        const s32 ret = MaterializeRedirect(path, false);
+        if (ret != ISFS::ISFSError::OK) {
+            return ret;
+        }
+    }
+
     // Get the replaced path
-    if (!GetFATFSPath(path, s_efsPath, sizeof(s_efsPath), m_redirect)) {
-        if (s_efsPath[0] == 0) {
+    if (!GetFATFSPath(path, efsPath, sizeof(efsPath), m_redirect)) {
+        if (efsPath[0] == 0) {
             return ISFS::ISFSError::NOT_FOUND;
         }
 
         // NAND path
         u32 tmpClusters = 0, tmpInodes = 0;
         IOS::IOVector<1, 2> vec;
-        vec.in[0].data = s_efsPath;
+        vec.in[0].data = efsPath;
         vec.in[0].len = ISFS::MAX_PATH_LENGTH;
         vec.out[0].data = &tmpClusters;
         vec.out[0].len = sizeof(u32);
@@ -1463,11 +4309,28 @@ s32 EmuFSHandle::GetUsage(const char* path, u32* clusters, u32* inodes)
 
         WriteIfNotNull(clusters, tmpClusters);
         WriteIfNotNull(inodes, tmpInodes);
+        return ISFS::ISFSError::OK;
+    }
+
+    u32 tmpClusters = 0, tmpInodes = 0;
+    FRESULT fresult = UsageGet(
+        efsPath, efsPath2, sizeof(efsPath2), &tmpClusters, &tmpInodes
+    );
+    if (fresult != FR_OK) {
+        return FResultToISFSError(fresult);
+    }
+
+    // The clusters used by a whole volume come from its free cluster count,
+    // which also covers directories and anything written outside EmuFS
+    if (IsVolumeRoot(efsPath)) {
+        fresult = GetVolumeUsage(efsPath, &tmpClusters);
+        if (fresult != FR_OK) {
+            return FResultToISFSError(fresult);
+        }
     }
 
-    // TODO
-    WriteIfNotNull<u32>(clusters, 0);
-    WriteIfNotNull<u32>(inodes, 0);
+    WriteIfNotNull(clusters, tmpClusters);
+    WriteIfNotNull(inodes, tmpInodes);
 
     return ISFS::ISFSError::OK;
 }
@@ -1497,14 +4360,25 @@ s32 EmuFSHandle::GetFileStats(u32* size, u32* position)
     if (std::holds_alternative<FIL>(m_file)) {
         FIL* fil = &std::get<FIL>(m_file);
 
+        s32 ret = FlushWriteBuffer();
+        if (ret != ISFS::ISFSError::OK) {
+            return ret;
+        }
+
         if (size != nullptr) {
             *size = f_size(fil);
         }
 
         if (position != nullptr) {
-            *position = f_tell(fil);
+            *position = f_tell(fil) - (m_readLength - m_readPos);
         }
 
+        return ISFS::ISFSError::OK;
+    } else if (m_nandCache != nullptr) {
+        const ISFSFileHandle* file = &std::get<ISFSFileHandle>(m_file);
+        WriteIfNotNull<u32>(size, file->size);
+        WriteIfNotNull<u32>(position, file->position);
+
         return ISFS::ISFSError::OK;
     } else if (std::holds_alternative<ISFSFileHandle>(m_file)) {
         IOS::File::Stats stats;
@@ -1529,6 +4403,171 @@ s32 EmuFSHandle::GetFileStats(u32* size, u32* position)
     return ISFS::ISFSError::INVALID;
 }
 
+/**
+ * Read a batch of whole files for the extended interface. External files are
+ * read in the order of their directory entries and first clusters, so files
+ * from the same directories are read with few seeks. NAND files and files
+ * that can't be found go last.
+ * Uses the request context path buffers.
+ * @param results Receives the size of each file, or an ISFS error code. A file
+ * larger than its buffer is only read up to the buffer size.
+ * @param modified Optional, receives the FAT modified date and time of each
+ * file, or 0 for NAND files.
+ * @returns ISFS error code.
+ */
+s32 EmuFSHandle::ReadFiles(
+    u32 count, IOS::TVector* paths, IOS::TVector* buffers, s32* results,
+    u32* modified
+)
+{
+    RequestContext* context = GetRequestContext();
+    auto& efsPath = context->efsPath;
+    auto& efsPath2 = context->efsPath2;
+
+    if (!m_isManager || count > ISFS::EX_READ_FILES_MAX_COUNT) {
+        return ISFS::ISFSError::INVALID;
+    }
+
+    struct ReadOrder {
+        u32 index;
+        // Directory entry offset and first cluster of an external file, all
+        // ones for NAND files
+        QWORD dirOffset;
+        DWORD cluster;
+    };
+
+    ReadOrder order[ISFS::EX_READ_FILES_MAX_COUNT];
+
+    for (u32 i = 0; i < count; i++) {
+        order[i] = {
+            .index = i,
+            .dirOffset = static_cast<QWORD>(~0),
+            .cluster = static_cast<DWORD>(~0),
+        };
+
+        if (modified != nullptr) {
+            modified[i] = 0;
+        }
+
+        std::memcpy(efsPath2, paths[i].data, paths[i].len);
+        if (efsPath2[paths[i].len - 1] != '\0' ||
+            !IsEmuFSPathValid(efsPath2) ||
+            PathElementCompare(efsPath2 + 1, "dev") == 0) {
+            results[i] = ISFS::ISFSError::INVALID;
+            continue;
+        }
+
+        results[i] = ISFS::ISFSError::OK;
+
+        if (!GetFATFSPath(efsPath2, efsPath, sizeof(efsPath), m_redirect)) {
+            continue;
+        }
+
+        // Writes still buffered by open handles aren't in the file yet
+        const s32 ret = FlushPathWriteBuffers(efsPath);
+        if (ret != ISFS::ISFSError::OK) {
+            results[i] = ret;
+            continue;
+        }
+
+        // One stat gives the sort keys and the modified time, and leaves the
+        // directory entry in the lookup cache so the open below doesn't walk
+        // the path again
+        FILINFO info;
+        FRESULT fresult = FATCache::Stat(efsPath, &info);
+        if (fresult == FR_OK && (info.fattrib & AM_DIR)) {
+            fresult = FR_NO_FILE;
+        }
+        if (fresult != FR_OK) {
+            results[i] = FResultToISFSError(fresult);
+            continue;
+        }
+
+        order[i].dirOffset = info.dir_ofs;
+        order[i].cluster = info.sclust;
+        if (modified != nullptr) {
+            modified[i] = (info.fdate << 16) | info.ftime;
+        }
+    }
+
+    std::sort(order, order + count, [](const ReadOrder& a, const ReadOrder& b) {
+        if (a.dirOffset != b.dirOffset) {
+            return a.dirOffset < b.dirOffset;
+        }
+
+        if (a.cluster != b.cluster) {
+            return a.cluster < b.cluster;
+        }
+
+        return a.index < b.index;
+    });
+
+    for (u32 i = 0; i < count; i++) {
+        const u32 index = order[i].index;
+        if (results[index] != ISFS::ISFSError::OK) {
+            continue;
+        }
+
+        std::memcpy(efsPath2, paths[index].data, paths[index].len);
+        u8* buffer = static_cast<u8*>(buffers[index].data);
+
+        // External files are read straight from a FIL, without the handle's
+        // write buffer and read-ahead
+        if (order[i].dirOffset != static_cast<QWORD>(~0) &&
+            GetFATFSPath(efsPath2, efsPath, sizeof(efsPath), m_redirect)) {
+            FIL fil;
+            FRESULT fresult = FATCache::Open(&fil, efsPath, FA_READ);
+            if (fresult != FR_OK) {
+                results[index] = FResultToISFSError(fresult);
+                continue;
+            }
+
+            const u32 size = f_size(&fil);
+            const u32 length = std::min(size, buffers[index].len);
+            UINT bytesRead = 0;
+            fresult = f_read(&fil, buffer, length, &bytesRead);
+            f_close(&fil);
+
+            if (fresult != FR_OK) {
+                results[index] = FResultToISFSError(fresult);
+            } else if (bytesRead != length) {
+                results[index] = ISFS::ISFSError::UNKNOWN;
+            } else {
+                results[index] = size;
+            }
+            continue;
+        }
+
+        EmuFSHandle file;
+        s32 ret =
+            file.OpenFile(efsPath2, IOS::Mode::READ, m_uid, m_gid, m_redirect);
+
+        u32 size = 0;
+        if (ret == ISFS::ISFSError::OK) {
+            ret = file.GetFileStats(&size, nullptr);
+        }
+
+        const u32 length = std::min(size, buffers[index].len);
+        for (u32 done = 0; ret == ISFS::ISFSError::OK && done < length;) {
+            const s32 bytesRead = file.Read(buffer + done, length - done);
+            if (bytesRead <= 0) {
+                ret = bytesRead < 0 ? bytesRead : ISFS::ISFSError::UNKNOWN;
+                break;
+            }
+
+            done += bytesRead;
+        }
+
+        if (ret == ISFS::ISFSError::OK) {
+            ret = file.Close();
+        }
+
+        results[index] = ret == ISFS::ISFSError::OK ? size : ret;
+    }
+
+    return ISFS::ISFSError::OK;
+}
+
 template <typename T>
 T* ipc_vector_cast(void* ptr, u32 len)
 {
@@ -1784,6 +4823,13 @@ s32 EmuFSHandle::Ioctl(
         // This command is called to wait for any in-progress file operations to
         // be completed before shutting down
         PRINT(IOS_EmuFS, INFO, "Shutdown: ISFS_Shutdown()");
+
+        const auto stats = DeviceEmuFS::GetNANDCacheStats();
+        PRINT(
+            IOS_EmuFS, INFO,
+            "NAND cache: %u hits, %u misses, %u inserts, %u invalidations",
+            stats.hits, stats.misses, stats.inserts, stats.invalidations
+        );
         return ISFS::ISFSError::OK;
     }
 
@@ -2006,6 +5052,11 @@ s32 EmuFSHandle::Ioctlv(
         return true;
     };
 
+    if (s_blockExtendedInterface && command >= ISFS::ISFSIoctl::EX_OPEN) {
+        PRINT(IOS_EmuFS, ERROR, "Extended interface blocked: %u", command);
+        return ISFS::ISFSError::INVALID;
+    }
+
     switch (command) {
     // [ISFS_ReadDir]
     // vec[0]: path
@@ -2149,13 +5200,14 @@ s32 EmuFSHandle::Ioctlv(
             return ISFS::ISFSError::INVALID;
         }
 
-        std::memcpy(s_efsPath2, vec[0].data, vec[0].len);
-        if (!IsEmuFSPathValid(s_efsPath2)) {
+        auto& efsPath2 = GetRequestContext()->efsPath2;
+        std::memcpy(efsPath2, vec[0].data, vec[0].len);
+        if (!IsEmuFSPathValid(efsPath2)) {
             PRINT(IOS_EmuFS, ERROR, "ExOpen: Invalid path");
             return ISFS::ISFSError::INVALID;
         }
 
-        if (PathElementCompare(s_efsPath2 + 1, "dev")) {
+        if (PathElementCompare(efsPath2 + 1, "dev") == 0) {
             // Don't let the caller open a resource manager
             PRINT(
                 IOS_EmuFS, ERROR, "ExOpen: Attempt to open a resource manager"
@@ -2164,9 +5216,60 @@ s32 EmuFSHandle::Ioctlv(
         }
 
         // Reset the handle as we're converting it to a file handle
+        ReleaseManagerResource();
         CloseBackend();
 
-        return OpenFile(s_efsPath2, *mode, m_uid, m_gid, false);
+        const s32 ret = OpenFile(efsPath2, *mode, m_uid, m_gid, false);
+        if (ret == ISFS::ISFSError::OK) {
+            // Later requests on the handle are for the file
+            ScopeLock lock(s_routeMutex);
+            s_handleLane[m_fd] = GetHandleLane(this);
+        }
+        return ret;
+    }
+
+    // [ISFS_ExReadFiles]
+    // vec[0 .. count-1](in): Paths
+    // vec[count .. count*2-1](out): File data buffers
+    // vec[count*2](out): Size of each file or ISFS error code, s32[count]
+    case ISFS::ISFSIoctl::EX_READ_FILES: {
+        // Reads many small files in one request instead of an open, stats,
+        // read and close for each
+        const u32 count = inCount;
+        if (count == 0 || count > ISFS::EX_READ_FILES_MAX_COUNT ||
+            (outCount != count + 1 && outCount != count + 2)) {
+            PRINT(IOS_EmuFS, ERROR, "ExReadFiles: Wrong vector count");
+            return ISFS::ISFSError::INVALID;
+        }
+
+        for (u32 i = 0; i < count; i++) {
+            if (vec[i].len == 0 || vec[i].len > ISFS::EMUFS_MAX_PATH_LENGTH) {
+                PRINT(IOS_EmuFS, ERROR, "ExReadFiles: Invalid path vector");
+                return ISFS::ISFSError::INVALID;
+            }
+        }
+
+        s32* results =
+            ipc_vector_cast<s32>(vec[count * 2].data, vec[count * 2].len);
+        if (results == nullptr || vec[count * 2].len < count * sizeof(s32)) {
+            PRINT(IOS_EmuFS, ERROR, "ExReadFiles: Invalid results vector");
+            return ISFS::ISFSError::INVALID;
+        }
+
+        // Optional modified times
+        u32* modified = nullptr;
+        if (outCount == count + 2) {
+            modified = ipc_vector_cast<u32>(
+                vec[count * 2 + 1].data, vec[count * 2 + 1].len
+            );
+            if (modified == nullptr ||
+                vec[count * 2 + 1].len < count * sizeof(u32)) {
+                PRINT(IOS_EmuFS, ERROR, "ExReadFiles: Invalid times vector");
+                return ISFS::ISFSError::INVALID;
+            }
+        }
+
+        return ReadFiles(count, vec, vec + count, results, modified);
     }
 
     default:
@@ -2175,13 +5278,146 @@ s32 EmuFSHandle::Ioctlv(
     }
 }
 
+/**
+ * Get the lane that handles requests for an open handle.
+ */
+static u8 GetHandleLane(const EmuFSHandle* handle)
+{
+    if (handle->m_isManager) {
+        return LANE_MANAGER;
+    }
+
+    if (std::holds_alternative<EmuFSHandle::ISFSFileHandle>(handle->m_file)) {
+        return LANE_NAND;
+    }
+
+    // Spread external files over the external lanes by handle, so files on
+    // different devices can be used at the same time
+    return LANE_EXTERNAL + handle->m_fd % (LANE_COUNT - LANE_EXTERNAL);
+}
+
+/**
+ * Get the lane to handle a request on a path on. Requests on the same path
+ * always go to the same lane so they can't race each other. Paths in a
+ * redirect unit may need the unit copied to external storage, so they're
+ * treated as external.
+ */
+static u8 GetPathLane(const char* path, bool redirect)
+{
+    char unit[ISFS::MAX_PATH_LENGTH];
+    if (!DeviceEmuFS::IsPathReplaced(path) &&
+        !(redirect && GetRedirectUnit(path, unit))) {
+        return LANE_NAND;
+    }
+
+    return LANE_EXTERNAL + HashProxyPath(path) % (LANE_COUNT - LANE_EXTERNAL);
+}
+
+/**
+ * Get the lane to handle an open request on.
+ */
+static u8 GetOpenLane(const char* openPath)
+{
+    char path[ISFS::MAX_PATH_LENGTH] = {};
+    std::memcpy(path, openPath, ISFS::MAX_PATH_LENGTH - 1);
+    path[0] = ISFS::SEPARATOR_CHAR;
+
+    return GetPathLane(path, true);
+}
+
+/**
+ * Get the lane to handle a request on a manager handle on. Commands on a path
+ * are routed by it like opens, so NAND commands don't wait on external
+ * storage. Everything else, and requests too malformed to find the path in,
+ * go to the manager lane and fail there. Only called while no request is in
+ * flight on the handle, so no worker is changing it.
+ */
+static u8 GetManagerLane(const IOS::Request* request)
+{
+    const EmuFSHandle* handle = &s_handles[request->fd];
+    char path[ISFS::MAX_PATH_LENGTH] = {};
+    char path2[ISFS::MAX_PATH_LENGTH] = {};
+    const void* data = nullptr;
+    u32 length = 0;
+
+    if (request->cmd == IOS::Cmd::IOCTL) {
+        void* in = request->ioctl.in;
+        const u32 inLen = request->ioctl.in_len;
+
+        switch (static_cast<ISFS::ISFSIoctl>(request->ioctl.cmd)) {
+        case ISFS::ISFSIoctl::CREATE_DIR:
+        case ISFS::ISFSIoctl::SET_ATTR:
+        case ISFS::ISFSIoctl::CREATE_FILE: {
+            auto attrBlock = ipc_vector_cast<ISFS::AttrBlock>(in, inLen);
+            if (attrBlock != nullptr) {
+                data = attrBlock->path;
+                length = ISFS::MAX_PATH_LENGTH;
+            }
+            break;
+        }
+
+        case ISFS::ISFSIoctl::GET_ATTR:
+        case ISFS::ISFSIoctl::DELETE:
+            data = in;
+            length = inLen;
+            break;
+
+        case ISFS::ISFSIoctl::RENAME: {
+            auto renameBlock = ipc_vector_cast<ISFS::RenameBlock>(in, inLen);
+            if (renameBlock != nullptr) {
+                data = renameBlock->pathOld;
+                length = ISFS::MAX_PATH_LENGTH;
+                std::memcpy(
+                    path2, renameBlock->pathNew, ISFS::MAX_PATH_LENGTH - 1
+                );
+            }
+            break;
+        }
+
+        default:
+            break;
+        }
+    } else if (request->cmd == IOS::Cmd::IOCTLV) {
+        switch (static_cast<ISFS::ISFSIoctl>(request->ioctlv.cmd)) {
+        case ISFS::ISFSIoctl::READ_DIR:
+        case ISFS::ISFSIoctl::GET_USAGE:
+        case ISFS::ISFSIoctl::EX_OPEN:
+            if (request->ioctlv.in_count >= 1) {
+                data = request->ioctlv.vec[0].data;
+                length = request->ioctlv.vec[0].len;
+            }
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    if (data == nullptr || length == 0) {
+        return LANE_MANAGER;
+    }
+
+    // Long extended paths are routed by their first part, which holds the
+    // mount point
+    std::memcpy(path, data, std::min(length, ISFS::MAX_PATH_LENGTH - 1));
+
+    // A rename between NAND and external storage is handled on the lane of
+    // the external path
+    u8 lane = GetPathLane(path, handle->m_redirect);
+    if (lane == LANE_NAND && path2[0] != '\0') {
+        lane = GetPathLane(path2, handle->m_redirect);
+    }
+
+    return lane;
+}
+
 static s32 HandleRequest(IOS::Request* req)
 {
     s32 ret = ISFS::ISFSError::INVALID;
     s32 fd = req->fd;
     EmuFSHandle* handle = nullptr;
     if (req->cmd != IOS::Cmd::OPEN) {
-        ASSERT(fd >= 0 && fd < ISFS::MAX_OPEN_COUNT);
+        ASSERT(fd >= 0 && fd < ISFS::EMUFS_MAX_OPEN_COUNT);
 
         handle = &s_handles[fd];
         ASSERT(handle != nullptr);
@@ -2228,41 +5464,41 @@ static s32 HandleRequest(IOS::Request* req)
         }
 
         // Check if the file is already open
-        ret = EmuFSHandle::FindProxyHandle(path);
-        if (ret < 0) {
+        fd = EmuFSHandle::ClaimProxyHandle(path);
+        if (fd < 0) {
+            ret = fd;
             break;
         }
-        fd = ret;
 
-        if (fd < ISFS::MAX_OPEN_COUNT) {
-            if (s_handles[fd].m_inUse) {
-                ret = ISFS::ISFSError::LOCKED;
+        if (fd < ISFS::EMUFS_MAX_OPEN_COUNT) {
+            // Reopen cached file
+            handle = &s_handles[fd];
+            ret = handle->Reopen(
+                req->open.mode, req->open.uid, req->open.gid
+            );
+            if (ret == ISFS::ISFSError::OK) {
+                ScopeLock lock(s_routeMutex);
+                s_handleLane[fd] = GetHandleLane(handle);
+                ret = fd;
                 break;
             }
 
-            // Reopen cached file
-            handle = &s_handles[fd];
-            ret = handle->Reopen();
+            // The cached file can't be used for this request, close it and
+            // open the file again in the same handle
+            ret = handle->CloseBackend();
             if (ret != ISFS::ISFSError::OK) {
+                EmuFSHandle::ReleaseHandle(fd);
                 break;
             }
-
-            ret = fd;
-            break;
-        }
-
-        // Open a new file
-        ret = EmuFSHandle::FindFreeHandle();
-        if (ret < 0) {
-            break;
-        }
-        fd = ret;
-
-        if (fd >= ISFS::MAX_OPEN_COUNT) {
-            ret = ISFS::ISFSError::MAX_HANDLES_OPEN;
-            break;
+        } else {
+            // Open a new file
+            ret = EmuFSHandle::FindFreeHandle();
+            if (ret < 0) {
+                break;
+            }
+            fd = ret;
+            handle = &s_handles[fd];
         }
-        handle = &s_handles[fd];
 
         // Reset the handle
         {
@@ -2276,9 +5512,20 @@ static s32 HandleRequest(IOS::Request* req)
         );
         if (ret != ISFS::ISFSError::OK) {
             handle->~EmuFSHandle();
+            EmuFSHandle::ReleaseHandle(fd);
             break;
         }
 
+        // Keep external files open after close so they can be reopened
+        // without another path lookup
+        if (std::holds_alternative<FIL>(handle->m_file)) {
+            handle->SetProxyPath(path);
+        }
+
+        {
+            ScopeLock lock(s_routeMutex);
+            s_handleLane[fd] = GetHandleLane(handle);
+        }
         ret = fd;
         break;
     }
@@ -2286,6 +5533,7 @@ static s32 HandleRequest(IOS::Request* req)
     case IOS::Cmd::CLOSE:
         PRINT(IOS_EmuFS, INFO, "IOS_Close(%d)", fd);
         ret = handle->Close();
+        EmuFSHandle::ReleaseHandle(fd);
         break;
 
     case IOS::Cmd::READ:
@@ -2351,14 +5599,72 @@ static s32 HandleRequest(IOS::Request* req)
 
 static Queue<IOS::Request*> s_ipcQueue;
 
+// Sized so the dispatcher never blocks on a busy lane while other lanes have
+// work waiting
+static Queue<IOS::Request*, 48> s_laneQueues[LANE_COUNT];
+
+static s32 WorkerThreadEntry(void* arg)
+{
+    const u32 lane = reinterpret_cast<u32>(arg);
+    s_requestContexts[lane].threadId = IOS_GetThreadId();
+
+    while (true) {
+        IOS::Request* request = s_laneQueues[lane].Receive();
+        const s32 fd = request->cmd != IOS::Cmd::OPEN ? request->fd : -1;
+        const s32 ret = HandleRequest(request);
+
+        if (fd >= 0) {
+            ScopeLock lock(s_routeMutex);
+            s_handlePending[fd]--;
+        }
+
+        request->Reply(ret);
+    }
+
+    // Can never reach here
+    return 0;
+}
+
 static s32 ThreadEntry([[maybe_unused]] void* arg)
 {
     PRINT(IOS_EmuFS, INFO, "Starting FS...");
     PRINT(IOS_EmuFS, INFO, "EmuFS thread ID: %d", IOS_GetThreadId());
 
+    for (u32 lane = 0; lane < LANE_COUNT; lane++) {
+        new Thread(
+            WorkerThreadEntry, reinterpret_cast<void*>(lane), nullptr, 0x2000,
+            80
+        );
+    }
+
+    // Below the lanes, so they only take the disk while the lanes are idle
+    new Thread(UsageScanThreadEntry, nullptr, nullptr, 0x2000, 70);
+    new Thread(RedirectCopyThreadEntry, nullptr, nullptr, 0x2000, 70);
+
+    // Hand out requests to the lanes
     while (true) {
         IOS::Request* request = s_ipcQueue.Receive();
-        request->Reply(HandleRequest(request));
+
+        u8 lane;
+        if (request->cmd == IOS::Cmd::OPEN) {
+            lane = GetOpenLane(request->open.path);
+        } else {
+            const s32 fd = request->fd;
+            ASSERT(fd >= 0 && fd < ISFS::EMUFS_MAX_OPEN_COUNT);
+
+            // Follow the requests still in flight on the file descriptor,
+            // so a close can't overtake a command that uses the handle
+            ScopeLock lock(s_routeMutex);
+            if (s_handlePending[fd] == 0) {
+                s_handleRoute[fd] = s_handleLane[fd] == LANE_MANAGER
+                                        ? GetManagerLane(request)
+                                        : s_handleLane[fd];
+            }
+            s_handlePending[fd]++;
+            lane = s_handleRoute[fd];
+        }
+
+        s_laneQueues[lane].Send(request);
     }
 
     // Can never reach here
@@ -2378,6 +5684,8 @@ void DeviceEmuFS::Init()
     for (u32 i = 0; i < s_handles.size(); i++) {
         s_handles[i].~EmuFSHandle();
     }
+    InitHandleTable();
+    InitManagerFds();
 
     new Thread(ThreadEntry, nullptr, nullptr, 0x2000, 80);
 }
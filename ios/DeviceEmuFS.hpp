@@ -18,4 +18,29 @@ void Init();
  */
 bool IsPathReplaced(const char* isfsPath);
 
+struct NANDCacheStats {
+    // Opens served from memory
+    u32 hits;
+    // Opens of cacheable files that had to go to NAND
+    u32 misses;
+    u32 inserts;
+    u32 invalidations;
+};
+
+/**
+ * Get the counters of the small NAND file cache.
+ */
+NANDCacheStats GetNANDCacheStats();
+
+/**
+ * Start the background usage scan of a volume. Called when it's mounted.
+ */
+void NotifyMount(u32 drv);
+
+/**
+ * Refuse the extended manager commands from now on. Called when the game
+ * starts.
+ */
+void BlockExtendedInterface();
+
 } // namespace DeviceEmuFS
@@ -4,6 +4,7 @@
 // SPDX-License-Identifier: GPL-2.0-only
 
 #include "DeviceStarling.hpp"
+#include <CPUCache.hpp>
 #include <DiskManager.hpp>
 #include <Kernel.hpp>
 #include <Log.hpp>
@@ -11,6 +12,8 @@
 #include <Util.h>
 #include <array>
 #include <cassert>
+#include <cstddef>
+#include <cstdio>
 #include <cstring>
 
 /**
@@ -18,22 +21,70 @@
  */
 DeviceStarling::DeviceStarling()
 {
+    m_ring = reinterpret_cast<DeviceStarlingTypes::CommandRing*>( //
+        COMMAND_DATA_ADDRESS
+    );
+    m_ring->writeIndex = 0;
+    m_ring->readIndex = 0;
+    CPUCache::DCFlush(
+        m_ring, offsetof(DeviceStarlingTypes::CommandRing, entries)
+    );
+
     s32 ret = IOS_RegisterResourceManager(
         DeviceStarlingTypes::RM_PATH, m_ipcQueue.GetID()
     );
     assert(ret >= 0);
 }
 
+/**
+ * Push a command to the loader's command ring, and wake the loader if it's
+ * waiting on it.
+ */
+bool DeviceStarling::PushCommand(
+    DeviceStarlingTypes::Command command,
+    const DeviceStarlingTypes::CommandData& data
+)
+{
+    ScopeLock lock(m_ringMutex);
+
+    CPUCache::DCInvalidate(&m_ring->readIndex, sizeof(u32));
+    u32 writeIndex = m_ring->writeIndex;
+    if (writeIndex - m_ring->readIndex >=
+        DeviceStarlingTypes::CommandRing::ENTRY_COUNT) {
+        PRINT(IOS, ERROR, "Command ring is full, dropping %d", command);
+        return false;
+    }
+
+    DeviceStarlingTypes::CommandEntry* entry = &m_ring->entries
+        [writeIndex % DeviceStarlingTypes::CommandRing::ENTRY_COUNT];
+    entry->command = command;
+    entry->data = data;
+    CPUCache::DCFlush(entry, sizeof(*entry));
+
+    // The entry must be visible before the index that publishes it
+    m_ring->writeIndex = writeIndex + 1;
+    CPUCache::DCFlush(&m_ring->writeIndex, sizeof(u32));
+
+    // The loader only waits after finding the ring empty, so this is the push
+    // that made it non-empty
+    if (m_waitRequest != nullptr) {
+        m_waitRequest->Reply(IOS::IOSError::OK);
+        m_waitRequest = nullptr;
+    }
+
+    return true;
+}
+
 /**
  * Notify the loader that a disk was inserted.
  */
 void DeviceStarling::InsertDisk(u32 diskId)
 {
     // Notify the loader that the disk was inserted and select it.
-    m_commandQueue.Send({
-        .command = DeviceStarlingTypes::Command::SELECT_DISK,
-        .data = DeviceStarlingTypes::CommandData::FromDiskID(diskId),
-    });
+    PushCommand(
+        DeviceStarlingTypes::Command::SELECT_DISK,
+        DeviceStarlingTypes::CommandData::FromDiskID(diskId)
+    );
 
     u32 drv = DiskManager::DevIDToDrv(diskId);
 
@@ -50,27 +101,51 @@ void DeviceStarling::InsertDisk(u32 diskId)
         DIR dir;
         auto fret = f_opendir(&dir, scanDir);
         if (fret != FR_OK) {
-            PRINT(IOS, INFO, "Couldn't open '%s'", scanDir, fret);
+            PRINT(IOS, INFO, "Couldn't open '%s': %d", scanDir, fret);
             continue;
         }
 
         PRINT(IOS, INFO, "Scanning '%s'", scanDir);
 
         FILINFO info;
-        while ((fret = f_readdir(&dir, &info)) == FR_OK) {
+        while ((fret = f_readdir(&dir, &info)) == FR_OK &&
+               info.fname[0] != '\0') {
             if (!StrNoCaseEndsWith(info.fname, ".xml")) {
                 continue;
             }
 
-            // Send the Riivolution XML to the loader.
-            m_commandQueue.Send({
-                .command = DeviceStarlingTypes::Command::INSERT_RIIVOLUTION_XML,
-                .data = info,
-            });
+            // Send the Riivolution XML path to the loader.
+            DeviceStarlingTypes::CommandData data;
+            data.riivolutionXml.diskId = diskId;
+            u32 len = snprintf(
+                data.riivolutionXml.path, sizeof(data.riivolutionXml.path),
+                "%s/%s", scanDir + 2, info.fname
+            );
+            if (len >= sizeof(data.riivolutionXml.path)) {
+                PRINT(IOS, ERROR, "Path too long: '%s'", info.fname);
+                continue;
+            }
+
+            PushCommand(
+                DeviceStarlingTypes::Command::INSERT_RIIVOLUTION_XML, data
+            );
         }
+
+        f_closedir(&dir);
     }
 }
 
+/**
+ * Notify the loader that a disk was removed.
+ */
+void DeviceStarling::RemoveDisk(u32 diskId)
+{
+    PushCommand(
+        DeviceStarlingTypes::Command::REMOVE_DISK,
+        DeviceStarlingTypes::CommandData::FromDiskID(diskId)
+    );
+}
+
 static constexpr s32 NO_REPLY = -99;
 
 /**
@@ -86,20 +161,22 @@ s32 DeviceStarling::HandleIoctl(IOS::Request* request)
     [[maybe_unused]] void* out = outLen != 0 ? request->ioctl.out : nullptr;
 
     switch (command) {
-    case DeviceStarlingTypes::Ioctl::RECEIVE_COMMAND: {
-        if (outLen != COMMAND_DATA_MAXLEN) {
-            PRINT(IOS, ERROR, "RECEIVE_COMMAND: Invalid output length");
+    case DeviceStarlingTypes::Ioctl::WAIT_COMMAND: {
+        ScopeLock lock(m_ringMutex);
+
+        if (m_waitRequest != nullptr) {
+            PRINT(IOS, ERROR, "WAIT_COMMAND: Already waiting");
             return IOS::IOSError::INVALID;
         }
 
-        if (!IsAligned(out, 32)) {
-            PRINT(IOS, ERROR, "RECEIVE_COMMAND: Invalid output alignment");
-            return IOS::IOSError::INVALID;
+        // A command may have been pushed after the loader saw the ring empty
+        CPUCache::DCInvalidate(&m_ring->readIndex, sizeof(u32));
+        if (m_ring->readIndex != m_ring->writeIndex) {
+            return IOS::IOSError::OK;
         }
 
-        // Enqueue the request to reply on the next command
-        m_responseQueue.Send(request);
-        m_commandRequested = true;
+        // Reply on the next push
+        m_waitRequest = request;
         // Internal code to skip replying
         return NO_REPLY;
     }
@@ -146,11 +223,12 @@ s32 DeviceStarling::HandleRequest(IOS::Request* request)
     case IOS::Cmd::CLOSE: {
         PRINT(IOS, INFO, "Loader closed /dev/starling");
 
-        if (m_commandRequested) {
-            m_responseQueue.Receive()->Reply(
+        ScopeLock lock(m_ringMutex);
+        if (m_waitRequest != nullptr) {
+            m_waitRequest->Reply(
                 s32(DeviceStarlingTypes::Command::CLOSE_REPLY)
             );
-            m_commandRequested = false;
+            m_waitRequest = nullptr;
         }
 
         m_opened = false;
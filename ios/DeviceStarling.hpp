@@ -8,8 +8,8 @@
 #include <DeviceStarlingTypes.hpp>
 #include <FAT.h>
 #include <IOS.hpp>
+#include <OS.hpp>
 #include <Types.h>
-#include <variant>
 
 class DeviceStarling
 {
@@ -45,20 +45,23 @@ protected:
      */
     s32 HandleRequest(IOS::Request* req);
 
-    struct InternalCommandData {
-        DeviceStarlingTypes::Command command;
-
-        // Data is freed after sending.
-        std::variant<
-            std::monostate, DeviceStarlingTypes::CommandData, const void*,
-            FILINFO>
-            data;
-    };
+    /**
+     * Push a command to the loader's command ring, and wake the loader if it's
+     * waiting on it.
+     * @returns False if the ring is full.
+     */
+    bool PushCommand(
+        DeviceStarlingTypes::Command command,
+        const DeviceStarlingTypes::CommandData& data
+    );
 
     Queue<IOS::Request*> m_ipcQueue;
-    Queue<IOS::Request*, 1> m_responseQueue;
-    Queue<InternalCommandData> m_commandQueue;
+
+    DeviceStarlingTypes::CommandRing* m_ring;
+    // Guards the write side of the ring and m_waitRequest
+    Mutex m_ringMutex;
+    // Pending WAIT_COMMAND request, replied to on the next push
+    IOS::Request* m_waitRequest = nullptr;
 
     bool m_opened = false;
-    bool m_commandRequested = false;
 };
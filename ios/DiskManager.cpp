@@ -5,7 +5,9 @@
 
 #include "DiskManager.hpp"
 #include "Config.hpp"
+#include "DeviceEmuFS.hpp"
 #include "DeviceStarling.hpp"
+#include "FATCache.hpp"
 #include "SDCard.hpp"
 #include "System.hpp"
 #include <Console.hpp>
@@ -468,6 +470,8 @@ void DiskManager::UpdateHandle(u32 devId)
         char str[16] = "0:";
         str[0] = devId + '0';
 
+        FATCache::InvalidateVolume(DevIDToDrv(devId));
+
         FRESULT fret = f_unmount(str);
         if (fret != FR_OK) {
             PRINT(
@@ -512,6 +516,8 @@ void DiskManager::UpdateHandle(u32 devId)
         dev->mounted = true;
         dev->error = false;
 
+        DeviceEmuFS::NotifyMount(DevIDToDrv(devId));
+
         // System::GetEventRM()->NotifyDeviceInsertion(devId);
 
         // Open log file if it's enabled. By notifying the channel first, the
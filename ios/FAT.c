@@ -2627,6 +2627,8 @@ static void get_fileinfo (
 		fno->altname[0] = 0;					/* exFAT does not support SFN */
 
 		fno->dir_ofs = (QWORD)dp->sect * SS(fs) + dp->dptr % SS(fs);    /* Entry offset */
+		fno->sclust = ld_dword(fs->dirbuf + XDIR_FstClus);		/* Start cluster */
+		fno->stat = fs->dirbuf[XDIR_GenFlags] & 2;				/* Allocation status */
 		fno->fattrib = fs->dirbuf[XDIR_Attr] & AM_MASKX;		/* Attribute */
 		fno->fsize = (fno->fattrib & AM_DIR) ? 0 : ld_qword(fs->dirbuf + XDIR_FileSize);	/* Size */
 		fno->ftime = ld_word(fs->dirbuf + XDIR_ModTime + 0);	/* Time */
@@ -2702,6 +2704,8 @@ static void get_fileinfo (
 #endif
 
 	fno->dir_ofs = (QWORD)dp->sect * SS(fs) + dp->dptr % SS(fs); /* Entry offset */
+	fno->sclust = ld_clust(fs, dp->dir);				/* Start cluster */
+	fno->stat = 0;										/* Allocation status */
 	fno->fattrib = dp->dir[DIR_Attr] & AM_MASK;			/* Attribute */
 	fno->fsize = ld_dword(dp->dir + DIR_FileSize);		/* Size */
 	fno->ftime = ld_word(dp->dir + DIR_ModTime + 0);	/* Time */
@@ -3652,53 +3656,121 @@ FRESULT f_mount (
 /* Open a File                                                           */
 /*-----------------------------------------------------------------------*/
 
+/* Check that the name at a FAT directory entry is the one given to create_name */
+static int fast_name_matched (
+    FATFS* fs,          /* Pointer to the filesystem object */
+    const DIR* dj,      /* Directory object holding the created name */
+    BYTE* dir,          /* Pointer to the SFN entry in the win[] */
+    UINT ofs            /* Offset of the SFN entry in the sector */
+)
+{
+    BYTE ord, sum;
+    BYTE* ent;
+
+
+    if (!(dj->fn[NSFLAG] & NS_LOSS) && !memcmp(dir, dj->fn, 11)) return 1;  /* SFN matched */
+    if (dj->fn[NSFLAG] & NS_NOLFN) return 0;
+    sum = sum_sfn(dir);
+    for (ord = 1; ; ord++) {                                    /* Walk back through the LFN entries */
+        if (ofs < (UINT)ord * SZDIRE) return 0;                 /* LFN starts in the previous sector */
+        ent = dir - ord * SZDIRE;
+        if (ent[DIR_Name] == DDEM || (ent[DIR_Attr] & AM_MASK) != AM_LFN) return 0;
+        if ((ent[LDIR_Ord] & ~LLEF) != ord || ent[LDIR_Chksum] != sum) return 0;
+        if (!cmp_lfn(fs->lfnbuf, ent)) return 0;
+        if (ent[LDIR_Ord] & LLEF) return 1;                     /* Whole LFN matched */
+    }
+}
+
 FRESULT f_fastopen (
     FIL* fp,            /* Pointer to the blank file object */
     FATFS* fs,          /* Pointer to the filesystem object */
-    QWORD dir_ofs       /* Offset of the directory entry */
+    QWORD dir_ofs,      /* Offset of the directory entry */
+    const TCHAR* name,  /* Name the entry is expected to have */
+    BYTE mode           /* Access mode flags (FA_READ and FA_WRITE only) */
 )
 {
     FRESULT res;
     LBA_t sect;
     BYTE* dir;
+    DIR dj;
+    DEF_NAMBUF
 
 
-    if (!fp || !fs) return FR_INVALID_OBJECT;
+    if (!fp || !fs || !fs->fs_type || !name) return FR_INVALID_OBJECT;
+    fp->obj.fs = 0;
+    mode &= FA_READ | FA_WRITE;
 
+#if FF_FS_REENTRANT
+    if (!lock_fs(fs)) return FR_TIMEOUT;                        /* Obtain the filesystem object */
+#endif
+    res = fs->fs_type ? FR_OK : FR_INVALID_OBJECT;              /* Volume unmounted while waiting? */
+    dj.obj.fs = fs;
+    INIT_NAMBUF(fs);
+    if (res == FR_OK) res = create_name(&dj, &name);            /* Name to compare the entry against */
     sect = dir_ofs / SS(fs);                                    /* Sector# of the directory entry */
-    res = move_window(fs, sect);
+    if (res == FR_OK) res = move_window(fs, sect);
     if (res == FR_OK) {
         dir = fs->win + (dir_ofs % SS(fs));                     /* Pointer to the entry in the win[] */
 #if FF_FS_EXFAT
         if (fs->fs_type == FS_EXFAT) {
-            fp->obj.sclust = ld_dword(dir + XDIR_FstClus);      /* Start cluster */
-            fp->obj.objsize = ld_qword(dir + XDIR_FileSize);    /* Size */
-            fp->obj.stat = dir[XDIR_GenFlags] & 2;              /* Allocation status */
-            fp->obj.n_frag = 0;                                 /* No last fragment info */
+            BYTE nc;
+            UINT di, ni;
+
+            if ((mode & FA_WRITE) || dir_ofs % SS(fs) + ((UINT)dir[XDIR_NumSec] + 1) * SZDIRE > SS(fs)) {
+                res = FR_INVALID_PARAMETER;                     /* Containing directory info or name is not known */
+            } else if (dir[XDIR_Type] != ET_FILEDIR || (dir[XDIR_Attr] & AM_DIR)) {
+                res = FR_NO_FILE;                               /* Entry is not a file anymore */
+            } else {
+                for (nc = dir[XDIR_NumName], di = SZDIRE * 2, ni = 0; nc; nc--, di += 2, ni++) {
+                    if ((di % SZDIRE) == 0) di += 2;
+                    if (ff_wtoupper(ld_word(dir + di)) != ff_wtoupper(fs->lfnbuf[ni])) break;
+                }
+                if (nc != 0 || fs->lfnbuf[ni]) {
+                    res = FR_NO_FILE;                           /* Entry now holds another file */
+                } else {
+                    fp->obj.sclust = ld_dword(dir + XDIR_FstClus);  /* Start cluster */
+                    fp->obj.objsize = ld_qword(dir + XDIR_FileSize);/* Size */
+                    fp->obj.stat = dir[XDIR_GenFlags] & 2;      /* Allocation status */
+                    fp->obj.n_frag = 0;                         /* No last fragment info */
+                }
+            }
         } else
 #endif
         {
-            fp->obj.sclust = ld_clust(fs, dir);                 /* Get object allocation info */
-            fp->obj.objsize = ld_dword(dir + DIR_FileSize);
+            if (dir[DIR_Name] == DDEM || dir[DIR_Name] == 0 || dir[DIR_Attr] == AM_LFN || (dir[DIR_Attr] & (AM_DIR | AM_VOL))) {
+                res = FR_NO_FILE;                               /* Entry is not a file anymore */
+            } else if (!fast_name_matched(fs, &dj, dir, (UINT)(dir_ofs % SS(fs)))) {
+                res = FR_NO_FILE;                               /* Entry now holds another file */
+            } else if ((mode & FA_WRITE) && (dir[DIR_Attr] & AM_RDO)) {
+                res = FR_DENIED;                                /* Write mode open against R/O file */
+            } else {
+                fp->obj.sclust = ld_clust(fs, dir);             /* Get object allocation info */
+                fp->obj.objsize = ld_dword(dir + DIR_FileSize);
+#if !FF_FS_READONLY
+                fp->dir_sect = sect;                            /* Pointer to the directory entry */
+                fp->dir_ptr = dir;
+#endif
+            }
         }
+    }
+    if (res == FR_OK) {
 #if FF_USE_FASTSEEK
-            fp->cltbl = 0;                                      /* Disable fast seek mode */
-#endif
-            fp->obj.fs = fs;                                    /* Validate the file object */
-            fp->obj.id = fs->id;
-            fp->flag = FA_READ;                                 /* Set file access mode */
-            fp->err = 0;                                        /* Clear error flag */
-            fp->sect = 0;                                       /* Invalidate current data sector */
-            fp->fptr = 0;                                       /* Set file pointer top of the file */
+        fp->cltbl = 0;                                          /* Disable fast seek mode */
+#endif
+        fp->obj.fs = fs;                                        /* Validate the file object */
+        fp->obj.id = fs->id;
+        fp->flag = mode;                                        /* Set file access mode */
+        fp->err = 0;                                            /* Clear error flag */
+        fp->sect = 0;                                           /* Invalidate current data sector */
+        fp->fptr = 0;                                           /* Set file pointer top of the file */
 #if !FF_FS_READONLY
 #if !FF_FS_TINY
-            memset(fp->buf, 0, sizeof fp->buf);                 /* Clear sector buffer */
+        memset(fp->buf, 0, sizeof fp->buf);                     /* Clear sector buffer */
 #endif
 #endif
     }
 
-    if (res != FR_OK) fp->obj.fs = 0;                           /* Invalidate file object on error */
-
+    FREE_NAMBUF();
     LEAVE_FF(fs, res);
 }
 
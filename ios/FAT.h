@@ -246,10 +246,12 @@ typedef struct {
 
 typedef struct {
 	QWORD   dir_ofs;        /* Directory entry offset */
+	DWORD	sclust;			/* Start cluster (0: empty file) */
 	FSIZE_t	fsize;			/* File size */
 	WORD	fdate;			/* Modified date */
 	WORD	ftime;			/* Modified time */
 	BYTE	fattrib;		/* File attribute */
+	BYTE	stat;			/* Allocation status (exFAT: 2 if the file has no FAT chain) */
 #if FF_USE_LFN
 	TCHAR	altname[FF_SFN_BUF + 1];/* Altenative file name */
 	TCHAR	fname[FF_LFN_BUF + 1];	/* Primary file name */
@@ -302,7 +304,7 @@ typedef enum {
 /*--------------------------------------------------------------*/
 /* FatFs module application interface                           */
 
-FRESULT f_fastopen (FIL* fp, FATFS* fs, QWORD dir_ofs);             /* Open a file */
+FRESULT f_fastopen (FIL* fp, FATFS* fs, QWORD dir_ofs, const TCHAR* name, BYTE mode); /* Open a file from its directory entry */
 FRESULT f_open (FIL* fp, const TCHAR* path, BYTE mode);				/* Open or create a file */
 FRESULT f_close (FIL* fp);											/* Close an open file object */
 FRESULT f_read (FIL* fp, void* buff, UINT btr, UINT* br);			/* Read data from the file */
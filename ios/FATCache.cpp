@@ -0,0 +1,312 @@
+// FATCache.cpp - FatFS directory entry lookup cache
+//   Written by Palapeli
+//
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include "FATCache.hpp"
+#include "DiskManager.hpp"
+#include <OS.hpp>
+#include <cstring>
+
+namespace FATCache
+{
+
+static constexpr u32 SetCount = 16;
+static constexpr u32 WayCount = 4;
+static constexpr u32 MaxPathLength = 96;
+
+struct Entry {
+    bool valid;
+    bool isDir;
+    u8 drv;
+    WORD fsId;
+    u32 hash;
+    u32 lastUse;
+    QWORD dirOffset;
+    char path[MaxPathLength];
+};
+
+static Entry s_entries[SetCount][WayCount];
+static u32 s_useCounter = 0;
+static Mutex s_mutex;
+
+// Incremented on every invalidation. A lookup or insert that started before
+// an invalidation is discarded, as the entry may have moved in between.
+static u32 s_generation = 0;
+
+static inline char FoldCase(char c)
+{
+    return c >= 'a' && c <= 'z' ? c - 'a' + 'A' : c;
+}
+
+/**
+ * FNV-1a hash of the full path, including the drive prefix. FAT names are
+ * case insensitive, so the path is hashed in upper case.
+ */
+static u32 HashPath(const char* path)
+{
+    u32 hash = 0x811C9DC5;
+    for (; *path != '\0'; path++) {
+        hash = (hash ^ static_cast<u8>(FoldCase(*path))) * 0x01000193;
+    }
+    return hash;
+}
+
+/**
+ * Compare up to len characters of two paths, ignoring case.
+ */
+static bool PathEqual(const char* a, const char* b, u32 len = ~0u)
+{
+    for (u32 i = 0; i < len; i++) {
+        if (FoldCase(a[i]) != FoldCase(b[i])) {
+            return false;
+        }
+        if (a[i] == '\0') {
+            return true;
+        }
+    }
+    return true;
+}
+
+/**
+ * Get the mounted filesystem object from a "N:/..." path.
+ */
+static FATFS* GetVolume(const char* path, u8* drvOut)
+{
+    if (path[0] < '0' || path[0] > '9' || path[1] != ':') {
+        return nullptr;
+    }
+
+    u32 drv = path[0] - '0';
+    if (drv >= DiskManager::DeviceCount) {
+        return nullptr;
+    }
+
+    FATFS* fs =
+        DiskManager::s_instance->GetFilesystem(DiskManager::DRVToDevID(drv));
+    if (fs->fs_type == 0) {
+        return nullptr;
+    }
+
+    *drvOut = drv;
+    return fs;
+}
+
+static u32 GetGeneration()
+{
+    ScopeLock lock(s_mutex);
+    return s_generation;
+}
+
+static bool Lookup(
+    const char* path, u32 hash, const FATFS* fs, u32 generation, Entry* out
+)
+{
+    ScopeLock lock(s_mutex);
+
+    if (generation != s_generation) {
+        return false;
+    }
+
+    Entry* set = s_entries[hash % SetCount];
+    for (u32 i = 0; i < WayCount; i++) {
+        if (set[i].valid && set[i].hash == hash && set[i].fsId == fs->id &&
+            PathEqual(set[i].path, path)) {
+            set[i].lastUse = ++s_useCounter;
+            *out = set[i];
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void Insert(
+    const char* path, u32 hash, u8 drv, const FATFS* fs, QWORD dirOffset,
+    bool isDir, u32 generation
+)
+{
+    if (std::strlen(path) >= MaxPathLength) {
+        return;
+    }
+
+    ScopeLock lock(s_mutex);
+
+    if (generation != s_generation) {
+        return;
+    }
+
+    // Replace the existing entry for the path or the least recently used one
+    Entry* set = s_entries[hash % SetCount];
+    Entry* victim = &set[0];
+    for (u32 i = 0; i < WayCount; i++) {
+        if (set[i].valid && set[i].hash == hash &&
+            PathEqual(set[i].path, path)) {
+            victim = &set[i];
+            break;
+        }
+
+        if (!set[i].valid) {
+            victim = &set[i];
+        } else if (victim->valid && set[i].lastUse < victim->lastUse) {
+            victim = &set[i];
+        }
+    }
+
+    victim->valid = true;
+    victim->isDir = isDir;
+    victim->drv = drv;
+    victim->fsId = fs->id;
+    victim->hash = hash;
+    victim->lastUse = ++s_useCounter;
+    victim->dirOffset = dirOffset;
+    std::strcpy(victim->path, path);
+}
+
+/**
+ * Drop the entry for a path and every entry below it.
+ */
+static void InvalidatePath(const char* path)
+{
+    u32 len = std::strlen(path);
+    while (len > 0 && path[len - 1] == '/') {
+        len--;
+    }
+
+    ScopeLock lock(s_mutex);
+
+    s_generation++;
+
+    for (u32 i = 0; i < SetCount; i++) {
+        for (u32 j = 0; j < WayCount; j++) {
+            Entry* entry = &s_entries[i][j];
+            if (entry->valid && PathEqual(entry->path, path, len) &&
+                (entry->path[len] == '\0' || entry->path[len] == '/')) {
+                entry->valid = false;
+            }
+        }
+    }
+}
+
+FRESULT Open(FIL* fp, const char* path, BYTE mode)
+{
+    u8 drv;
+    FATFS* fs = GetVolume(path, &drv);
+
+    // exFAT needs the containing directory info, which only the path walk
+    // provides, and creating a file always needs the path walk.
+    if (fs == nullptr || fs->fs_type == FS_EXFAT ||
+        (mode & ~(FA_READ | FA_WRITE))) {
+        return f_open(fp, path, mode);
+    }
+
+    const u32 hash = HashPath(path);
+    const u32 generation = GetGeneration();
+
+    // The entry's name is checked against the leaf, in case the slot was
+    // reused by something that bypassed these wrappers
+    const char* leaf = std::strrchr(path, '/');
+    leaf = leaf != nullptr ? leaf + 1 : path + 2;
+
+    Entry entry;
+    if (Lookup(path, hash, fs, generation, &entry) && !entry.isDir) {
+        FRESULT fresult = f_fastopen(fp, fs, entry.dirOffset, leaf, mode);
+        if (fresult == FR_OK && GetGeneration() == generation) {
+            return FR_OK;
+        }
+
+        if (fresult == FR_OK) {
+            f_close(fp);
+        }
+    }
+
+    FRESULT fresult = f_open(fp, path, mode);
+    if (fresult == FR_OK) {
+        QWORD dirOffset = (QWORD) fp->dir_sect * FF_MAX_SS +
+                          static_cast<u32>(fp->dir_ptr - fs->win);
+        Insert(path, hash, drv, fs, dirOffset, false, generation);
+    }
+
+    return fresult;
+}
+
+FRESULT Stat(const char* path, FILINFO* fno)
+{
+    u8 drv;
+    FATFS* fs = GetVolume(path, &drv);
+    const u32 hash = HashPath(path);
+    const u32 generation = GetGeneration();
+
+    Entry entry;
+    if (fs != nullptr && fno == nullptr &&
+        Lookup(path, hash, fs, generation, &entry)) {
+        return FR_OK;
+    }
+
+    FILINFO info;
+    FRESULT fresult = f_stat(path, &info);
+    if (fresult != FR_OK) {
+        return fresult;
+    }
+
+    // The volume may have been mounted by f_stat
+    if (fs == nullptr) {
+        fs = GetVolume(path, &drv);
+    }
+
+    if (fs != nullptr) {
+        Insert(
+            path, hash, drv, fs, info.dir_ofs, info.fattrib & AM_DIR,
+            generation
+        );
+    }
+
+    if (fno != nullptr) {
+        *fno = info;
+    }
+
+    return FR_OK;
+}
+
+FRESULT Unlink(const char* path)
+{
+    InvalidatePath(path);
+    FRESULT fresult = f_unlink(path);
+    InvalidatePath(path);
+    return fresult;
+}
+
+FRESULT Rename(const char* pathOld, const char* pathNew)
+{
+    InvalidatePath(pathOld);
+    InvalidatePath(pathNew);
+    FRESULT fresult = f_rename(pathOld, pathNew);
+    InvalidatePath(pathOld);
+    InvalidatePath(pathNew);
+    return fresult;
+}
+
+FRESULT Mkdir(const char* path)
+{
+    InvalidatePath(path);
+    FRESULT fresult = f_mkdir(path);
+    InvalidatePath(path);
+    return fresult;
+}
+
+void InvalidateVolume(u32 drv)
+{
+    ScopeLock lock(s_mutex);
+
+    s_generation++;
+
+    for (u32 i = 0; i < SetCount; i++) {
+        for (u32 j = 0; j < WayCount; j++) {
+            if (s_entries[i][j].drv == drv) {
+                s_entries[i][j].valid = false;
+            }
+        }
+    }
+}
+
+} // namespace FATCache
@@ -0,0 +1,51 @@
+// FATCache.hpp - FatFS directory entry lookup cache
+//   Written by Palapeli
+//
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+
+#include "FAT.h"
+#include <Types.h>
+
+// Wrappers around FatFS path functions that remember where a path's directory
+// entry lives on the volume, so opening the same file again does not need to
+// walk every directory in the path. Anything that creates, removes or moves a
+// directory entry must go through these wrappers to keep the cache coherent.
+
+namespace FATCache
+{
+
+/**
+ * Open a file, skipping the path walk if the directory entry is cached.
+ * Create flags always go through f_open.
+ */
+FRESULT Open(FIL* fp, const char* path, BYTE mode);
+
+/**
+ * Get file status. If fno is null this is an existence check and can be
+ * answered from the cache.
+ */
+FRESULT Stat(const char* path, FILINFO* fno);
+
+/**
+ * Remove a file or directory and drop its cached entries.
+ */
+FRESULT Unlink(const char* path);
+
+/**
+ * Rename or move a file or directory and drop its cached entries.
+ */
+FRESULT Rename(const char* pathOld, const char* pathNew);
+
+/**
+ * Create a directory and drop any cached entries under the path.
+ */
+FRESULT Mkdir(const char* path);
+
+/**
+ * Drop all cached entries for a volume. Called when the volume is unmounted.
+ */
+void InvalidateVolume(u32 drv);
+
+} // namespace FATCache
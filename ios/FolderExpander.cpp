@@ -0,0 +1,328 @@
+// FolderExpander.cpp - Riivolution folder node expansion
+//   Written by Palapeli
+//
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include "FolderExpander.hpp"
+#include "DiskManager.hpp"
+#include <Log.hpp>
+#include <Util.h>
+#include <cctype>
+#include <cstring>
+
+static constexpr u32 FNVBasis = 0x811C9DC5;
+
+/**
+ * Continue the FNV-1a hash of a directory path with the name of one of its
+ * entries. The disc is case insensitive, so the name is hashed in lower case.
+ */
+static u32 HashName(u32 hash, const char* name)
+{
+    hash = (hash ^ '/') * 0x01000193;
+    for (; *name != '\0'; name++) {
+        hash = (hash ^ static_cast<u8>(tolower(*name))) * 0x01000193;
+    }
+    return hash;
+}
+
+FolderExpander::FolderExpander(
+    u8* fst, u32 fstSize, EmuDITypes::FSTIndexSlot* index, u32 indexSize,
+    u32 nextOffset
+)
+  : m_fst(reinterpret_cast<FSTEntry*>(fst))
+  , m_index(index)
+  , m_indexMask(indexSize - 1)
+  , m_nextOffset(nextOffset)
+{
+    if (fstSize < sizeof(FSTEntry) || !m_fst[0].isDir) {
+        PRINT(IOS_EmuDI, ERROR, "Invalid FST root");
+        return;
+    }
+
+    // The size of the root entry is the entry count
+    m_entryCount = m_fst[0].dir.next;
+    if (m_entryCount == 0 || m_entryCount > fstSize / sizeof(FSTEntry)) {
+        PRINT(IOS_EmuDI, ERROR, "Invalid FST entry count: %u", m_entryCount);
+        return;
+    }
+
+    if (indexSize <= m_entryCount || (indexSize & m_indexMask) != 0) {
+        PRINT(
+            IOS_EmuDI, ERROR, "FST index too small: %u <= %u", indexSize,
+            m_entryCount
+        );
+        return;
+    }
+
+    m_names = reinterpret_cast<const char*>(fst) +
+              m_entryCount * sizeof(FSTEntry);
+    m_namesSize = fstSize - m_entryCount * sizeof(FSTEntry);
+
+    std::memset(m_index, 0, indexSize * sizeof(EmuDITypes::FSTIndexSlot));
+
+    // Walk the FST once, keeping the path hash of every open directory
+    u32 dirEnd[MaxFSTDepth];
+    u32 dirHash[MaxFSTDepth];
+    u32 depth = 0;
+    dirEnd[0] = m_entryCount;
+    dirHash[0] = FNVBasis;
+
+    for (u32 i = 1; i < m_entryCount; i++) {
+        while (depth > 0 && i >= dirEnd[depth]) {
+            depth--;
+        }
+
+        const char* name = GetName(i);
+        if (name == nullptr) {
+            PRINT(IOS_EmuDI, ERROR, "Invalid FST name for entry %u", i);
+            return;
+        }
+
+        const u32 hash = HashName(dirHash[depth], name);
+
+        u32 slot = hash & m_indexMask;
+        while (m_index[slot].entry != 0) {
+            slot = (slot + 1) & m_indexMask;
+        }
+        m_index[slot] = {.hash = hash, .entry = i};
+
+        if (!m_fst[i].isDir) {
+            continue;
+        }
+
+        const u32 next = m_fst[i].dir.next;
+        if (next <= i || next > dirEnd[depth] || depth + 1 == MaxFSTDepth) {
+            PRINT(IOS_EmuDI, ERROR, "Invalid FST directory entry %u", i);
+            return;
+        }
+
+        depth++;
+        dirEnd[depth] = next;
+        dirHash[depth] = hash;
+    }
+
+    m_valid = true;
+}
+
+/**
+ * Get the name of an FST entry, or nullptr if it's out of bounds.
+ */
+const char* FolderExpander::GetName(u32 entry) const
+{
+    const u32 offset = m_fst[entry].stringOffset;
+    if (offset >= m_namesSize ||
+        std::memchr(m_names + offset, '\0', m_namesSize - offset) == nullptr) {
+        return nullptr;
+    }
+
+    return m_names + offset;
+}
+
+/**
+ * Find an FST entry by the hash of its path. The name of the entry is
+ * compared to rule out a hash collision.
+ * @returns The entry, or 0 if no entry has the path.
+ */
+u32 FolderExpander::Find(u32 hash, const char* name) const
+{
+    for (u32 slot = hash & m_indexMask; m_index[slot].entry != 0;
+         slot = (slot + 1) & m_indexMask) {
+        if (m_index[slot].hash == hash &&
+            strcasecmp(GetName(m_index[slot].entry), name) == 0) {
+            return m_index[slot].entry;
+        }
+    }
+
+    return 0;
+}
+
+FRESULT FolderExpander::Expand(
+    const EmuDITypes::FolderPatch* folder, EmuDITypes::DVDPatch* patches,
+    u32 maxPatches, u32* patchCount
+)
+{
+    if (!m_valid) {
+        return FR_INVALID_PARAMETER;
+    }
+
+    const char* externalPath = folder->externalPath;
+    if (externalPath[0] < '0' || externalPath[0] > '9' ||
+        externalPath[1] != ':' ||
+        std::memchr(externalPath, '\0', sizeof(folder->externalPath)) ==
+            nullptr) {
+        PRINT(IOS_EmuDI, ERROR, "Invalid external path");
+        return FR_INVALID_NAME;
+    }
+
+    // Find the folder on the disc, one component at a time
+    char discPath[sizeof(folder->discPath)];
+    if (std::memchr(folder->discPath, '\0', sizeof(discPath)) == nullptr) {
+        PRINT(IOS_EmuDI, ERROR, "Invalid disc path");
+        return FR_INVALID_NAME;
+    }
+    std::memcpy(discPath, folder->discPath, sizeof(discPath));
+
+    u32 dirHash = FNVBasis;
+    for (char* name = discPath; *name != '\0';) {
+        char* end = std::strchr(name, '/');
+        if (end != nullptr) {
+            *end = '\0';
+        }
+
+        if (*name != '\0') {
+            dirHash = HashName(dirHash, name);
+            const u32 entry = Find(dirHash, name);
+            if (entry == 0 || !m_fst[entry].isDir) {
+                PRINT(
+                    IOS_EmuDI, ERROR, "Disc folder not found: %s",
+                    folder->discPath
+                );
+                return FR_NO_PATH;
+            }
+        }
+
+        if (end == nullptr) {
+            break;
+        }
+        name = end + 1;
+    }
+
+    m_folder = folder;
+    m_patches = patches;
+    m_maxPatches = maxPatches;
+    m_patchCount = patchCount;
+    m_drv = externalPath[0] - '0';
+    std::strcpy(m_path, externalPath);
+
+    return ExpandDir(dirHash, 0);
+}
+
+/**
+ * Stream the directory at m_path, patching every file that replaces one on
+ * the disc.
+ * @param dirHash Path hash of the matching disc directory.
+ */
+FRESULT FolderExpander::ExpandDir(u32 dirHash, u32 depth)
+{
+    DIR dir;
+    FRESULT fresult = f_opendir(&dir, m_path);
+    if (fresult != FR_OK) {
+        PRINT(IOS_EmuDI, ERROR, "Failed to open %s: %d", m_path, fresult);
+        return fresult;
+    }
+
+    const u32 pathLength = std::strlen(m_path);
+
+    while ((fresult = f_readdir(&dir, &m_info)) == FR_OK &&
+           m_info.fname[0] != '\0') {
+        const u32 hash = HashName(dirHash, m_info.fname);
+        const u32 entry = Find(hash, m_info.fname);
+
+        if (!(m_info.fattrib & AM_DIR)) {
+            if (entry == 0 || m_fst[entry].isDir) {
+                // Adding files needs the FST to be rebuilt
+                PRINT(
+                    IOS_EmuDI, WARN, "Not on the disc: %s/%s", m_path,
+                    m_info.fname
+                );
+                continue;
+            }
+
+            fresult = AddPatch(entry);
+            if (fresult != FR_OK) {
+                break;
+            }
+            continue;
+        }
+
+        if (!(m_folder->flags & EmuDITypes::FOLDER_RECURSIVE)) {
+            continue;
+        }
+
+        if (entry == 0 || !m_fst[entry].isDir) {
+            PRINT(
+                IOS_EmuDI, WARN, "Not on the disc: %s/%s", m_path, m_info.fname
+            );
+            continue;
+        }
+
+        const u32 nameLength = std::strlen(m_info.fname);
+        if (depth + 1 == MaxFolderDepth ||
+            pathLength + 1 + nameLength >= sizeof(m_path)) {
+            PRINT(
+                IOS_EmuDI, WARN, "Folder too deep: %s/%s", m_path, m_info.fname
+            );
+            continue;
+        }
+
+        m_path[pathLength] = '/';
+        std::memcpy(m_path + pathLength + 1, m_info.fname, nameLength + 1);
+        fresult = ExpandDir(hash, depth + 1);
+        m_path[pathLength] = '\0';
+
+        if (fresult != FR_OK) {
+            break;
+        }
+    }
+
+    f_closedir(&dir);
+    return fresult;
+}
+
+/**
+ * Point an FST file entry at the file in m_info.
+ */
+FRESULT FolderExpander::AddPatch(u32 entry)
+{
+    if (m_info.fsize > 0x7FFFFFFF) {
+        PRINT(IOS_EmuDI, WARN, "File too large: %s", m_info.fname);
+        return FR_OK;
+    }
+
+    const u32 fileSize = m_info.fsize;
+    FSTEntry* fstEntry = &m_fst[entry];
+
+    // Without resize the disc size is kept, and a shorter file is only
+    // patched up to its own end
+    if (m_folder->flags & EmuDITypes::FOLDER_RESIZE) {
+        fstEntry->file.length = fileSize;
+    }
+
+    const u32 patchLength =
+        AlignUp(fileSize < fstEntry->file.length ? fileSize
+                                                 : fstEntry->file.length,
+                4) >>
+        2;
+    // An empty file has no cluster to read from, so the entry keeps its
+    // offset on the disc
+    if (patchLength == 0 || m_info.sclust == 0) {
+        return FR_OK;
+    }
+
+    const u32 length = AlignUp(fstEntry->file.length, 32) >> 2;
+    if (m_nextOffset + length < m_nextOffset) {
+        PRINT(IOS_EmuDI, ERROR, "Out of patched disc space");
+        return FR_NOT_ENOUGH_CORE;
+    }
+
+    const u32 offset = m_nextOffset;
+    fstEntry->file.startAddr = offset;
+    m_nextOffset += length;
+
+    if (*m_patchCount == m_maxPatches) {
+        PRINT(IOS_EmuDI, ERROR, "Out of DVD patches");
+        return FR_NOT_ENOUGH_CORE;
+    }
+
+    m_patches[(*m_patchCount)++] = {
+        .disc_offset = offset,
+        .disc_length = patchLength,
+        .start_cluster = m_info.sclust,
+        .cur_cluster = m_info.sclust,
+        .file_offset = 0,
+        .drv = m_drv,
+        .stat = m_info.stat,
+    };
+
+    return FR_OK;
+}
@@ -0,0 +1,100 @@
+// FolderExpander.hpp - Riivolution folder node expansion
+//   Written by Palapeli
+//
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+
+#include "FAT.h"
+#include <EmuDITypes.hpp>
+#include <Types.h>
+
+// Matches folders on the storage device against the disc FST and produces a
+// DVD patch for every file replaced. The FST paths are hashed into an index
+// once, then each folder is streamed with f_readdir and every entry is looked
+// up by the hash of its path. The start cluster comes from the directory
+// entry, so no file is opened. Patched offsets are handed out in increasing
+// order, so the patches come out sorted by disc offset.
+class FolderExpander
+{
+public:
+    /**
+     * Index the paths of an FST.
+     * @param fst The FST. The offset and size of every replaced file is
+     * rewritten in place.
+     * @param index Scratch for the path index. The slot count must be a power
+     * of two larger than the FST entry count.
+     * @param nextOffset Patched word offset to place the first file at.
+     */
+    FolderExpander(
+        u8* fst, u32 fstSize, EmuDITypes::FSTIndexSlot* index, u32 indexSize,
+        u32 nextOffset
+    );
+
+    bool IsValid() const
+    {
+        return m_valid;
+    }
+
+    u32 GetNextOffset() const
+    {
+        return m_nextOffset;
+    }
+
+    /**
+     * Expand a folder node, appending its patches to a table.
+     * @param patchCount Number of patches in the table, updated on return.
+     * @returns FR_NOT_ENOUGH_CORE if the table or the patched address space is
+     * full, or the error from the storage device.
+     */
+    FRESULT Expand(
+        const EmuDITypes::FolderPatch* folder, EmuDITypes::DVDPatch* patches,
+        u32 maxPatches, u32* patchCount
+    );
+
+private:
+    static constexpr u32 MaxFSTDepth = 32;
+    static constexpr u32 MaxFolderDepth = 8;
+
+    struct FSTEntry {
+        u8 isDir : 8;
+        u32 stringOffset : 24;
+
+        union {
+            struct {
+                u32 parent;
+                u32 next;
+            } dir;
+
+            struct {
+                u32 startAddr;
+                u32 length;
+            } file;
+        };
+    };
+
+    static_assert(sizeof(FSTEntry) == 0xC);
+
+    const char* GetName(u32 entry) const;
+    u32 Find(u32 hash, const char* name) const;
+    FRESULT ExpandDir(u32 dirHash, u32 depth);
+    FRESULT AddPatch(u32 entry);
+
+    bool m_valid = false;
+    FSTEntry* m_fst;
+    u32 m_entryCount;
+    const char* m_names;
+    u32 m_namesSize;
+    EmuDITypes::FSTIndexSlot* m_index;
+    u32 m_indexMask;
+    u32 m_nextOffset;
+
+    // State of the folder being expanded
+    const EmuDITypes::FolderPatch* m_folder;
+    EmuDITypes::DVDPatch* m_patches;
+    u32 m_maxPatches;
+    u32* m_patchCount;
+    u16 m_drv;
+    char m_path[512];
+    FILINFO m_info;
+};
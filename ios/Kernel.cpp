@@ -5,7 +5,7 @@
 
 #include "Kernel.hpp"
 #include "Config.hpp"
-#include "DeviceEmuFS.hpp"
+#include "PathTrie.hpp"
 #include "Syscalls.h"
 #include "System.hpp"
 #include <IOS.hpp>
@@ -33,6 +33,65 @@ ASM_THUMB_FUNCTION(static void IOSOpenStrncpyTrampoline(),
 
 // clang-format on
 
+// What the IOS_Open hook does with a path opened by the PPC
+enum OpenAction : u8 {
+    // No rule, the path is left alone
+    OPEN_PASS = 0,
+    // Left alone, and keeps shorter rules from applying
+    OPEN_KEEP,
+    // Fail the open
+    OPEN_BLOCK,
+    // Send to EmuFS
+    OPEN_EMUFS,
+    // Send to the Starling ES/DI replacements
+    OPEN_STARLING,
+};
+
+struct OpenRule {
+    const char* path;
+    PathTrie<512>::Match match;
+    OpenAction action;
+};
+
+constexpr OpenRule OPEN_RULES[] = {
+    // ISFS redirects never apply to devices
+    {"/dev/", PathTrie<512>::Match::PREFIX, OPEN_KEEP},
+    // Disallow opening the loader file RM, as it doesn't have a handler
+    // anymore and will permanently lock the IPC thread
+    {"/dev/starling/loader", PathTrie<512>::Match::PREFIX, OPEN_BLOCK},
+    {"/dev/flash", PathTrie<512>::Match::EXACT, OPEN_BLOCK},
+    {"/dev/boot2", PathTrie<512>::Match::EXACT, OPEN_BLOCK},
+    {"/dev/fs", PathTrie<512>::Match::EXACT, OPEN_EMUFS},
+    {"/dev/es", PathTrie<512>::Match::EXACT, OPEN_STARLING},
+    {"/dev/di", PathTrie<512>::Match::PREFIX, OPEN_STARLING},
+    // EmuFS mount point
+    {"/mnt", PathTrie<512>::Match::EXACT, OPEN_EMUFS},
+    {"/mnt/", PathTrie<512>::Match::PREFIX, OPEN_EMUFS},
+};
+
+// All of the rules above plus the redirected ISFS paths from the config,
+// built before the hook is installed
+static PathTrie<512> s_openRules;
+static bool s_openRulesBuilt = false;
+
+static void BuildOpenRules()
+{
+    for (const OpenRule& rule : OPEN_RULES) {
+        [[maybe_unused]] bool ret =
+            s_openRules.Insert(rule.path, rule.match, rule.action);
+        assert(ret);
+    }
+
+    for (u32 i = 0; i < Config::s_instance->GetISFSRedirectCount(); i++) {
+        const char* prefix = Config::s_instance->GetISFSRedirect(i);
+        if (!s_openRules.Insert(
+                prefix, PathTrie<512>::Match::PREFIX, OPEN_EMUFS
+            )) {
+            PRINT(IOS, ERROR, "Too many redirect rules, skipping '%s'", prefix);
+        }
+    }
+}
+
 extern "C" char* IOSOpenStrncpy(char* dest, const char* src, u32 num, s32 pid)
 {
     strncpy(dest, src, num);
@@ -50,42 +109,21 @@ extern "C" char* IOSOpenStrncpy(char* dest, const char* src, u32 num, s32 pid)
         return dest;
     }
 
-    if (strncmp(src, "/dev/", sizeof("/dev/") - 1) != 0) {
-        // ISFS path
-        if (DeviceEmuFS::IsPathReplaced(src)) {
-            dest[0] = '$';
-        }
-
-        return dest;
-    }
-
-    if (!strncmp(
-            src, "/dev/starling/loader", sizeof("/dev/starling/loader") - 1
-        )) {
-        // Disallow opening the loader file RM, as it doesn't have a handler
-        // anymore and will permanently lock the IPC thread
-        dest[0] = 0;
-        return dest;
-    }
-
-    if (!strcmp(src, "/dev/flash") || !strcmp(src, "/dev/boot2")) {
-        // No
+    switch (s_openRules.Find(src, num)) {
+    case OPEN_BLOCK:
         dest[0] = 0;
-        return dest;
-    }
+        break;
 
-    if (!strcmp(src, "/dev/fs")) {
+    case OPEN_EMUFS:
         dest[0] = '$';
-        return dest;
-    }
+        break;
 
-    if (!strcmp(src, "/dev/es")) {
+    case OPEN_STARLING:
         dest[0] = '~';
-        return dest;
-    }
+        break;
 
-    if (!strncmp(src, "/dev/di", 7)) {
-        dest[0] = '~';
+    default:
+        break;
     }
 
     return dest;
@@ -154,6 +192,12 @@ void Kernel::PatchIOSOpen()
 {
     PRINT(IOS, WARN, "The search for IOS_Open syscall");
 
+    // Only built once, the hook may already be installed
+    if (!s_openRulesBuilt) {
+        BuildOpenRules();
+        s_openRulesBuilt = true;
+    }
+
     u32 jumptable = FindSyscallTable();
     if (jumptable == 0) {
         PRINT(IOS, ERROR, "Could not find syscall table");
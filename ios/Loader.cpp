@@ -36,6 +36,10 @@ namespace Loader
 
 #define DEVICE_NAME "/dev/starling/loader"
 
+// How long to wait for the PPC to decode the module, in hardware timer ticks
+// (1.898 MHz). Decoding takes well under a second.
+static constexpr u32 MODULE_READY_TIMEOUT = 1898614 * 10;
+
 ASM_ARM_FUNCTION( //
     static u32 GetStackPointer(),
     // clang-format off
@@ -242,8 +246,29 @@ static s32 FileRMThreadEntry([[maybe_unused]] void* arg)
 {
     LOADER_PRINT(INFO, "File RM thread entry");
 
+    // The PPC finishes decoding the module after bootstrapping IOS, and sets
+    // the ready word once it's in memory. If it never does, the PPC side has
+    // failed and IOS_LaunchRM would wait forever.
+    const u32 startTime = HWRegRead<ACR::TIMER>();
+    while (true) {
+        IOS_InvalidateDCache(
+            (void*) IOS_FILE_INFO_ADDRESS, IOS_FILE_INFO_MAXLEN
+        );
+        if (ReadU32(IOS_FILE_INFO_ADDRESS + 8) != 0)
+            break;
+
+        if (HWRegRead<ACR::TIMER>() - startTime >= MODULE_READY_TIMEOUT) {
+            LOADER_PRINT(ERROR, "Timed out waiting for the module");
+            Console::Print("timed out waiting for the module, ");
+            LoaderAssertFail(__LINE__);
+        }
+
+        IOS_YieldThread();
+    }
+
     s_fileAddr = (u8*) (ReadU32(IOS_FILE_INFO_ADDRESS) & ~0xC0000000);
     s_fileSize = ReadU32(IOS_FILE_INFO_ADDRESS + 4);
+    IOS_InvalidateDCache(s_fileAddr, s_fileSize);
 
     // Check for ELF header
     LOADER_ASSERT(ReadU32(s_fileAddr) == 0x7F454C46);
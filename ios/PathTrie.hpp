@@ -0,0 +1,129 @@
+// PathTrie.hpp - Fixed size path prefix trie
+//   Written by Palapeli
+//
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+
+#include <Types.h>
+
+// Maps path rules to small values. Rules are inserted up front from a normal
+// thread. Find never allocates and looks at each character of the path once,
+// so it's safe to call from the IOS_Open hook with interrupts disabled.
+// Children are kept sorted by character, so a lookup stops scanning a level
+// as soon as it passes the character.
+template <u32 TNodeCount>
+class PathTrie
+{
+    static_assert(TNodeCount > 1 && TNodeCount < 0xFFFF);
+
+public:
+    enum class Match {
+        // The path is exactly the rule
+        EXACT,
+        // The path starts with the rule
+        PREFIX,
+    };
+
+    /**
+     * Add a rule. A longer matching rule takes priority over a shorter one,
+     * and an exact rule over a prefix rule of the same length.
+     * @param value Non-zero value to return from Find.
+     * @returns False if the trie is full.
+     */
+    bool Insert(const char* path, Match match, u8 value)
+    {
+        u16 node = 0;
+        for (; *path != '\0'; path++) {
+            const char c = *path;
+
+            // Find the child or the point to insert it in order
+            u16* link = &m_nodes[node].child;
+            while (*link != None && m_nodes[*link].c < c) {
+                link = &m_nodes[*link].sibling;
+            }
+
+            if (*link == None || m_nodes[*link].c != c) {
+                if (m_nodeCount == TNodeCount) {
+                    return false;
+                }
+
+                const u16 newNode = m_nodeCount++;
+                m_nodes[newNode] = {
+                    .c = c,
+                    .exactValue = 0,
+                    .prefixValue = 0,
+                    .child = None,
+                    .sibling = *link,
+                };
+                *link = newNode;
+            }
+
+            node = *link;
+        }
+
+        if (match == Match::EXACT) {
+            m_nodes[node].exactValue = value;
+        } else {
+            m_nodes[node].prefixValue = value;
+        }
+
+        return true;
+    }
+
+    /**
+     * Find the value of the longest rule matching the path, reading at most
+     * maxLength characters.
+     * @returns The rule's value, or 0 if no rule matches.
+     */
+    u8 Find(const char* path, u32 maxLength) const
+    {
+        u16 node = 0;
+        u8 value = m_nodes[0].prefixValue;
+
+        u32 i = 0;
+        for (; i < maxLength && path[i] != '\0'; i++) {
+            u16 child = m_nodes[node].child;
+            while (child != None && m_nodes[child].c < path[i]) {
+                child = m_nodes[child].sibling;
+            }
+
+            if (child == None || m_nodes[child].c != path[i]) {
+                return value;
+            }
+
+            node = child;
+            if (m_nodes[node].prefixValue != 0) {
+                value = m_nodes[node].prefixValue;
+            }
+        }
+
+        if (i < maxLength && m_nodes[node].exactValue != 0) {
+            return m_nodes[node].exactValue;
+        }
+
+        return value;
+    }
+
+private:
+    static constexpr u16 None = 0xFFFF;
+
+    struct Node {
+        char c;
+        u8 exactValue;
+        u8 prefixValue;
+        u16 child;
+        u16 sibling;
+    };
+
+    Node m_nodes[TNodeCount] = {
+        {
+            .c = '\0',
+            .exactValue = 0,
+            .prefixValue = 0,
+            .child = None,
+            .sibling = None,
+        },
+    };
+    u16 m_nodeCount = 1;
+};
@@ -214,8 +214,10 @@ s32 System::ThreadEntry([[maybe_unused]] void* arg)
 
 s32 System::s_heapId = -1;
 
-// TODO: The size could be determined automatically
-constexpr u32 SYSTEM_HEAP_SIZE = 0x40000; // 256 KB
+// TODO: The size could be determined automatically. The heap is part of the
+// module's BSS, which has to fit in the 0x6D000 bytes of ios_module.ld along
+// with the code and data.
+constexpr u32 SYSTEM_HEAP_SIZE = 0x30000; // 192 KB
 static u8 s_systemHeapData[SYSTEM_HEAP_SIZE] alignas(32);
 
 static u8 s_systemThreadStack[0x1000] alignas(32);
@@ -68,6 +68,13 @@ VirtualDiscISO::VirtualDiscISO(const char* path, const char* path2)
         assert(fret == FR_OK);
     }
 
+    m_devId = DiskManager::DRVToDevID(m_isoFile.obj.fs->pdrv);
+
+    for (u32 i = 0; i < m_numParts; i++) {
+        u32 fragments = BuildExtentMap(i);
+        PRINT(IOS_EmuDI, INFO, "Part %u fragments: %u", i, fragments);
+    }
+
     PRINT(IOS_EmuDI, INFO, "Successfully opened ISO file");
     PRINT(IOS_EmuDI, INFO, "Part size: %08X", m_partSize);
     PRINT(IOS_EmuDI, INFO, "Num parts: %08X", m_numParts);
@@ -83,6 +90,145 @@ bool VirtualDiscISO::IsInserted()
     return DiskManager::s_instance->IsInserted(m_devId);
 }
 
+/**
+ * Convert the FatFS link map of an ISO part into a sector extent map. Returns
+ * the number of fragments in the part.
+ */
+u32 VirtualDiscISO::BuildExtentMap(u32 part)
+{
+    FIL* fp = part == 0 ? &m_isoFile : &m_isoFile2;
+    FATFS* fs = fp->obj.fs;
+
+    m_extentCount[part] = 0;
+
+    // The link map is a list of (cluster count, start cluster) pairs
+    // terminated by a zero count.
+    const DWORD* tbl = fp->cltbl + 1;
+    u32 fragments = 0;
+    u32 fileSector = 0;
+    for (; tbl[0] != 0; tbl += 2, fragments++) {
+        u32 sectorCount = tbl[0] * fs->csize;
+
+        if (fragments < MaxExtents) {
+            m_extents[part][fragments] = {
+                .fileSector = fileSector,
+                .sectorCount = sectorCount,
+                .lba = fs->database + (LBA_t) fs->csize * (tbl[1] - 2),
+            };
+        }
+
+        fileSector += sectorCount;
+    }
+
+    if (fragments > MaxExtents) {
+        PRINT(
+            IOS_EmuDI, WARN,
+            "Part %u is too fragmented for direct reads, using FatFS", part
+        );
+        return fragments;
+    }
+
+    m_extentCount[part] = fragments;
+    return fragments;
+}
+
+/**
+ * Read whole sectors of an ISO part directly from the device, splitting the
+ * read at extent boundaries.
+ */
+bool VirtualDiscISO::ReadPartSectors(u32 part, u8* out, u32 sector, u32 count)
+{
+    const Extent* begin = m_extents[part];
+    const Extent* end = begin + m_extentCount[part];
+
+    // Find the last extent starting at or before the sector
+    const Extent* extent =
+        std::upper_bound(begin, end, sector, [](u32 value, const Extent& e) {
+            return value < e.fileSector;
+        });
+    extent--;
+
+    while (count > 0) {
+        if (extent < begin || extent >= end ||
+            sector - extent->fileSector >= extent->sectorCount) {
+            PRINT(IOS_EmuDI, ERROR, "Sector %08X not in extent map", sector);
+            return false;
+        }
+
+        u32 extentOffset = sector - extent->fileSector;
+        u32 runLength = std::min(
+            {count, extent->sectorCount - extentOffset, MaxTransferSectors}
+        );
+
+        if (!DiskManager::s_instance->DeviceRead(
+                m_devId, out, static_cast<u32>(extent->lba + extentOffset),
+                runLength
+            )) {
+            return false;
+        }
+
+        out += runLength * SectorSize;
+        sector += runLength;
+        count -= runLength;
+
+        if (sector - extent->fileSector >= extent->sectorCount)
+            extent++;
+    }
+
+    return true;
+}
+
+/**
+ * Read a byte range of an ISO part using the extent map. Unaligned edges are
+ * read through a bounce sector.
+ */
+bool VirtualDiscISO::ReadPartDirect(u32 part, u8* out, u64 offset, u32 len)
+{
+    FIL* fp = part == 0 ? &m_isoFile : &m_isoFile2;
+    FATFS* fs = fp->obj.fs;
+
+    // Hold the volume lock so the direct reads are serialized with FatFS.
+    if (!ff_req_grant(fs->sobj))
+        return false;
+
+    bool ret = true;
+    if (fs->fs_type == 0 || fs->id != fp->obj.id) {
+        PRINT(IOS_EmuDI, ERROR, "ISO volume is no longer mounted");
+        ret = false;
+    }
+
+    u32 sector = offset / SectorSize;
+    u32 sectorOffset = offset % SectorSize;
+
+    if (ret && sectorOffset != 0) {
+        u32 copyLen = std::min(len, SectorSize - sectorOffset);
+        ret = ReadPartSectors(part, m_sectorBuffer, sector, 1);
+        if (ret) {
+            std::memcpy(out, m_sectorBuffer + sectorOffset, copyLen);
+            out += copyLen;
+            len -= copyLen;
+            sector++;
+        }
+    }
+
+    if (ret && len >= SectorSize) {
+        u32 count = len / SectorSize;
+        ret = ReadPartSectors(part, out, sector, count);
+        out += count * SectorSize;
+        len -= count * SectorSize;
+        sector += count;
+    }
+
+    if (ret && len > 0) {
+        ret = ReadPartSectors(part, m_sectorBuffer, sector, 1);
+        if (ret)
+            std::memcpy(out, m_sectorBuffer, len);
+    }
+
+    ff_rel_grant(fs->sobj);
+    return ret;
+}
+
 bool VirtualDiscISO::ReadRaw(void* buffer, u32 wordOffset, u32 byteLen)
 {
     const u32 lastPart = m_numParts - 1;
@@ -129,14 +275,23 @@ bool VirtualDiscISO::ReadRaw(void* buffer, u32 wordOffset, u32 byteLen)
             return false;
         }
 
-        auto fret = f_lseek(fp, partOffset);
-        if (fret != FR_OK)
-            return false;
-        UINT br;
-        fret = f_read(fp, buffer, lengthToRead, &br);
-        if (fret != FR_OK)
-            return false;
+        if (m_extentCount[partNum] != 0) {
+            if (!ReadPartDirect(
+                    partNum, reinterpret_cast<u8*>(buffer), partOffset,
+                    lengthToRead
+                ))
+                return false;
+        } else {
+            auto fret = f_lseek(fp, partOffset);
+            if (fret != FR_OK)
+                return false;
+            UINT br;
+            fret = f_read(fp, buffer, lengthToRead, &br);
+            if (fret != FR_OK)
+                return false;
+        }
 
+        buffer = reinterpret_cast<u8*>(buffer) + lengthToRead;
         partOffset = 0;
         byteLen -= lengthToRead;
         partNum++;
@@ -35,6 +35,23 @@ protected:
     bool ReadAndDecryptBlock(u32 wordOffset);
 
 private:
+    /**
+     * A contiguous run of sectors belonging to an ISO part.
+     */
+    struct Extent {
+        u32 fileSector;
+        u32 sectorCount;
+        LBA_t lba;
+    };
+
+    static constexpr u32 SectorSize = 512;
+    static constexpr u32 MaxExtents = 128;
+    static constexpr u32 MaxTransferSectors = 0x400;
+
+    u32 BuildExtentMap(u32 part);
+    bool ReadPartDirect(u32 part, u8* out, u64 offset, u32 len);
+    bool ReadPartSectors(u32 part, u8* out, u32 sector, u32 count);
+
     FIL m_isoFile;
 
     // If ISO is split into multiple parts.
@@ -47,6 +64,12 @@ private:
     // FatFS fast seek feature
     DWORD m_isoClmt[0x1000] = {0};
 
+    // Extent map built from the link map, used to read directly from the
+    // device. An extent count of zero falls back to f_read.
+    Extent m_extents[2][MaxExtents];
+    u32 m_extentCount[2] = {0, 0};
+    u8 m_sectorBuffer[SectorSize] ATTRIBUTE_ALIGN(32);
+
 protected:
     u32 m_devId = 0;
 
@@ -1,5 +1,8 @@
 #include "Archive.hpp"
+#include <IOS.hpp>
+#include <Util.h>
 #include <cstring>
+#include <new>
 
 struct FSTEntry {
     u8 isDir : 8;
@@ -21,12 +24,18 @@ struct FSTEntry {
 static_assert(sizeof(FSTEntry) == 0xC);
 
 Archive::Archive(const u8* data, u32 size)
+  : Archive(data, size, size)
+{
+}
+
+Archive::Archive(const u8* data, u32 residentSize, u32 size)
   : m_data(data)
   , m_size(size)
+  , m_residentSize(residentSize)
 {
     m_ok = false;
 
-    if (m_size < 0x20 + 0xC) {
+    if (m_residentSize < 0x20 + 0xC) {
         return;
     }
 
@@ -35,23 +44,25 @@ Archive::Archive(const u8* data, u32 size)
     }
 
     u32 metadataSize = read<u32>(0x8);
-    if (metadataSize > 0x20 + m_size) {
+    if (metadataSize > 0x20 + m_residentSize) {
         return;
     }
 
     m_entriesOffset = read<u32>(0x4);
-    if (m_entriesOffset > m_size || m_entriesOffset + 0xc > m_size) {
+    if (m_entriesOffset > m_residentSize ||
+        m_entriesOffset + 0xc > m_residentSize) {
         return;
     }
     m_entryCount = read<u32>(m_entriesOffset + 0x8);
-    if (m_entriesOffset + m_entryCount * 0xc > m_size ||
+    if (m_entriesOffset + m_entryCount * 0xc > m_residentSize ||
         m_entryCount * 0xc > metadataSize) {
         return;
     }
 
     m_stringsOffset = m_entriesOffset + m_entryCount * 0xc;
     m_stringsSize = metadataSize - m_entryCount * 0xc;
-    if (m_stringsOffset > m_size || m_stringsOffset + m_stringsSize > m_size) {
+    if (m_stringsOffset > m_residentSize ||
+        m_stringsOffset + m_stringsSize > m_residentSize) {
         return;
     }
 
@@ -63,8 +74,166 @@ bool Archive::ok() const
     return m_ok;
 }
 
-std::variant<std::monostate, Archive::File, Archive::Dir>
-Archive::get(u32 entrynum) const
+Archive::Entry Archive::get(u32 entrynum) const
+{
+    if (m_index != nullptr) {
+        if (entrynum >= m_entryCount) {
+            return std::monostate{};
+        }
+
+        return m_index[entrynum];
+    }
+
+    return getUnindexed(entrynum);
+}
+
+Archive::Entry Archive::get(const char* path) const
+{
+    if (m_index == nullptr) {
+        return getUnindexed(path);
+    }
+
+    u32 hash = 0x811C9DC5;
+    const char* name = path;
+    u32 nameLength = 0;
+    while (*path != '\0') {
+        const char* sep = strchr(path, '/');
+        u32 length = sep ? sep - path : strlen(path);
+        if (length != 0) {
+            hash = hashName(hash, path, length);
+            name = path;
+            nameLength = length;
+        }
+
+        path = sep ? sep + 1 : path + length;
+    }
+
+    if (nameLength == 0) {
+        return m_index[0];
+    }
+
+    for (u32 slot = hash & m_indexMask;
+         m_indexSlots[slot].entrynum != INDEX_EMPTY;
+         slot = (slot + 1) & m_indexMask) {
+        if (m_indexSlots[slot].hash != hash) {
+            continue;
+        }
+
+        const Entry& entry = m_index[m_indexSlots[slot].entrynum];
+        const char* entryName = nullptr;
+        if (auto* file = std::get_if<File>(&entry)) {
+            entryName = file->name;
+        } else if (auto* dir = std::get_if<Dir>(&entry)) {
+            entryName = dir->name;
+        }
+
+        if (entryName != nullptr && !strncmp(entryName, name, nameLength) &&
+            entryName[nameLength] == '\0') {
+            return entry;
+        }
+    }
+
+    return std::monostate{};
+}
+
+/**
+ * Continue the FNV-1a hash of a directory path with the name of one of its
+ * entries.
+ */
+u32 Archive::hashName(u32 hash, const char* name, u32 length)
+{
+    hash = (hash ^ '/') * 0x01000193;
+    for (u32 i = 0; i < length; i++) {
+        hash = (hash ^ static_cast<u8>(name[i])) * 0x01000193;
+    }
+    return hash;
+}
+
+/**
+ * Get the path hash table size, a power of two at most half full.
+ */
+u32 Archive::indexSlotCount() const
+{
+    u32 count = 16;
+    while (count < m_entryCount * 2) {
+        count <<= 1;
+    }
+    return count;
+}
+
+u32 Archive::indexSize() const
+{
+    if (!ok()) {
+        return 0;
+    }
+
+    return m_entryCount * sizeof(Entry) + indexSlotCount() * sizeof(IndexSlot);
+}
+
+bool Archive::buildIndex(void* index, u32 size)
+{
+    if (!ok() || size < indexSize()) {
+        return false;
+    }
+
+    Entry* entries = static_cast<Entry*>(index);
+    IndexSlot* slots = reinterpret_cast<IndexSlot*>(entries + m_entryCount);
+    const u32 slotCount = indexSlotCount();
+    memset(slots, 0xFF, slotCount * sizeof(IndexSlot));
+
+    // Walk the entries once, keeping the path hash of every open directory
+    u32 dirEnd[INDEX_MAX_DEPTH];
+    u32 dirHash[INDEX_MAX_DEPTH];
+    u32 depth = 0;
+    dirEnd[0] = m_entryCount;
+    dirHash[0] = 0x811C9DC5;
+
+    new (&entries[0]) Entry(getUnindexed(0u));
+    if (!std::holds_alternative<Dir>(entries[0])) {
+        return false;
+    }
+
+    for (u32 i = 1; i < m_entryCount; i++) {
+        while (depth > 0 && i >= dirEnd[depth]) {
+            depth--;
+        }
+
+        Entry* entry = new (&entries[i]) Entry(getUnindexed(i));
+        const char* name;
+        if (auto* file = std::get_if<File>(entry)) {
+            name = file->name;
+        } else if (auto* dir = std::get_if<Dir>(entry)) {
+            name = dir->name;
+        } else {
+            return false;
+        }
+
+        const u32 hash = hashName(dirHash[depth], name, strlen(name));
+
+        u32 slot = hash & (slotCount - 1);
+        while (slots[slot].entrynum != INDEX_EMPTY) {
+            slot = (slot + 1) & (slotCount - 1);
+        }
+        slots[slot] = {hash, i};
+
+        if (auto* dir = std::get_if<Dir>(entry)) {
+            if (dir->next > dirEnd[depth] || depth + 1 == INDEX_MAX_DEPTH) {
+                return false;
+            }
+
+            depth++;
+            dirEnd[depth] = dir->next;
+            dirHash[depth] = hash;
+        }
+    }
+
+    m_index = entries;
+    m_indexSlots = slots;
+    m_indexMask = slotCount - 1;
+    return true;
+}
+
+Archive::Entry Archive::getUnindexed(u32 entrynum) const
 {
     if (!ok()) {
         return std::monostate{};
@@ -103,11 +272,10 @@ Archive::get(u32 entrynum) const
     }
 }
 
-std::variant<std::monostate, Archive::File, Archive::Dir>
-Archive::get(const char* path) const
+Archive::Entry Archive::getUnindexed(const char* path) const
 {
     u32 entrynum = 0;
-    auto entry = get(entrynum);
+    auto entry = getUnindexed(entrynum);
 
     while (*path != '\0' && std::holds_alternative<Dir>(entry)) {
         const char* sep = strchr(path, '/');
@@ -115,7 +283,7 @@ Archive::get(const char* path) const
 
         Dir dir = std::get<Dir>(entry);
         for (entrynum = dir.entrynum + 1; entrynum < dir.next;) {
-            entry = get(entrynum);
+            entry = getUnindexed(entrynum);
             std::optional<const char*> name{};
             if (auto* file = std::get_if<File>(&entry)) {
                 name = file->name;
@@ -125,7 +293,8 @@ Archive::get(const char* path) const
             if (!name) {
                 return std::monostate{};
             }
-            if (!strncmp(*name, path, length)) {
+            // The whole name must match, not just start with the component
+            if (!strncmp(*name, path, length) && (*name)[length] == '\0') {
                 break;
             }
             Dir* subdir = std::get_if<Dir>(&entry);
@@ -151,7 +320,7 @@ Archive::get(const char* path) const
 std::optional<const char*> Archive::getString(u32 offset) const
 {
     const char* string = reinterpret_cast<const char*>(m_data + offset);
-    for (; offset < m_size; offset++) {
+    for (; offset < m_residentSize; offset++) {
         if (read<char>(offset) == '\0') {
             return string;
         }
@@ -159,3 +328,116 @@ std::optional<const char*> Archive::getString(u32 offset) const
 
     return {};
 }
+
+FileArchive::FileArchive(IOS::File* file)
+  : m_file(file)
+  , m_fileSize(0)
+  , m_headerOk(false)
+{
+    if (m_file->GetFd() < 0) {
+        return;
+    }
+
+    m_fileSize = m_file->GetSize();
+    if (m_file->Seek(0, IOS_SEEK_SET) != 0 ||
+        m_file->Read(m_header, sizeof(m_header)) !=
+            static_cast<s32>(sizeof(m_header))) {
+        return;
+    }
+
+    m_headerOk = *reinterpret_cast<const u32*>(m_header) == 0x55AA382D;
+}
+
+u32 FileArchive::tablesSize() const
+{
+    if (!m_headerOk) {
+        return 0;
+    }
+
+    // The tables start at the root entry, and are followed by the file data
+    const u32 entriesOffset = *reinterpret_cast<const u32*>(m_header + 0x4);
+    const u32 metadataSize = *reinterpret_cast<const u32*>(m_header + 0x8);
+    if (entriesOffset > m_fileSize ||
+        metadataSize > m_fileSize - entriesOffset) {
+        return 0;
+    }
+
+    return AlignUp(entriesOffset + metadataSize, 32);
+}
+
+bool FileArchive::load(u8* buffer)
+{
+    const u32 size = tablesSize();
+    if (size == 0) {
+        return false;
+    }
+
+    // The header has already been read. The last block may be cut short by
+    // the end of the file.
+    std::memcpy(buffer, m_header, sizeof(m_header));
+    const u32 expected = (size < m_fileSize ? size : m_fileSize) - 0x20;
+    if (m_file->Read(buffer + sizeof(m_header), size - 0x20) <
+        static_cast<s32>(expected)) {
+        return false;
+    }
+
+    m_archive.emplace(buffer, size, m_fileSize);
+    return m_archive->ok();
+}
+
+u32 FileArchive::indexSize() const
+{
+    if (!ok()) {
+        return 0;
+    }
+
+    return m_archive->indexSize();
+}
+
+bool FileArchive::buildIndex(void* index, u32 size)
+{
+    if (!ok()) {
+        return false;
+    }
+
+    return m_archive->buildIndex(index, size);
+}
+
+bool FileArchive::ok() const
+{
+    return m_archive && m_archive->ok();
+}
+
+Archive::Entry FileArchive::get(const char* path) const
+{
+    if (!ok()) {
+        return std::monostate{};
+    }
+
+    return m_archive->get(path);
+}
+
+s32 FileArchive::read(
+    const Archive::File& member, void* out, u32 offset, u32 size
+)
+{
+    if (offset > member.size) {
+        return IOS::IOSError::INVALID;
+    }
+
+    if (size > member.size - offset) {
+        size = member.size - offset;
+    }
+
+    const s32 seek = m_file->Seek(member.offset + offset, IOS_SEEK_SET);
+    if (seek < 0) {
+        return seek;
+    }
+
+    const s32 ret = m_file->Read(out, AlignUp(size, 32));
+    if (ret < 0) {
+        return ret;
+    }
+
+    return static_cast<u32>(ret) < size ? ret : size;
+}
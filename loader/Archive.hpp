@@ -4,6 +4,11 @@
 #include <optional>
 #include <variant>
 
+namespace IOS
+{
+class File;
+}
+
 class Archive
 {
 public:
@@ -21,13 +26,48 @@ public:
         u32 next;
     };
 
+    using Entry = std::variant<std::monostate, File, Dir>;
+
     Archive(const u8* data, u32 size);
+
+    /**
+     * Use an archive of which only the start is in memory. Entries and names
+     * must be within residentSize, file data is only checked against size.
+     */
+    Archive(const u8* data, u32 residentSize, u32 size);
     ~Archive() = default;
     bool ok() const;
-    std::variant<std::monostate, File, Dir> get(u32 entrynum) const;
-    std::variant<std::monostate, File, Dir> get(const char* path) const;
+    Entry get(u32 entrynum) const;
+    Entry get(const char* path) const;
+
+    /**
+     * Get the space needed by buildIndex.
+     */
+    u32 indexSize() const;
+
+    /**
+     * Decode every entry once and hash its full path, so get is O(1) after.
+     * @param index Space for the index, 4 byte aligned. Must outlive the
+     * archive.
+     * @returns False if the space is too small or the archive is malformed,
+     * in which case lookups keep walking the archive.
+     */
+    bool buildIndex(void* index, u32 size);
 
 private:
+    struct IndexSlot {
+        u32 hash;
+        u32 entrynum;
+    };
+
+    static constexpr u32 INDEX_EMPTY = 0xFFFFFFFF;
+    static constexpr u32 INDEX_MAX_DEPTH = 32;
+
+    static u32 hashName(u32 hash, const char* name, u32 length);
+    u32 indexSlotCount() const;
+    Entry getUnindexed(u32 entrynum) const;
+    Entry getUnindexed(const char* path) const;
+
     template <typename T>
     T read(u32 offset) const
     {
@@ -44,9 +84,65 @@ private:
 
     const u8* m_data;
     u32 m_size;
+    u32 m_residentSize;
     u32 m_entriesOffset;
     u32 m_entryCount;
     u32 m_stringsOffset;
     u32 m_stringsSize;
     bool m_ok;
+
+    // Decoded entries, followed by the path hash table
+    Entry* m_index = nullptr;
+    IndexSlot* m_indexSlots;
+    u32 m_indexMask;
+};
+
+// A U8 archive read from a file on demand. Only the header, node table and
+// string table are loaded, and members are read straight from the file with
+// aligned reads, so large archives never have to be resident.
+class FileArchive
+{
+public:
+    explicit FileArchive(IOS::File* file);
+
+    /**
+     * Get the size of the buffer load needs, or 0 if the header is invalid.
+     */
+    u32 tablesSize() const;
+
+    /**
+     * Load the node and string tables.
+     * @param buffer Space of tablesSize() bytes, 32 byte aligned. Must
+     * outlive the archive.
+     */
+    bool load(u8* buffer);
+
+    /**
+     * Get the space needed by buildIndex, or 0 if the tables aren't loaded.
+     */
+    u32 indexSize() const;
+
+    /**
+     * Index the loaded tables, see Archive::buildIndex.
+     */
+    bool buildIndex(void* index, u32 size);
+
+    bool ok() const;
+    Archive::Entry get(const char* path) const;
+
+    /**
+     * Read part of a member. Whole 32 byte blocks are read, so out needs
+     * space for size rounded up to 32.
+     * @param out Where to read to, 32 byte aligned.
+     * @param offset Offset in the member.
+     * @returns The number of bytes of the member read, or an IOS error.
+     */
+    s32 read(const Archive::File& member, void* out, u32 offset, u32 size);
+
+private:
+    IOS::File* m_file;
+    u32 m_fileSize;
+    u8 m_header[0x20] alignas(32);
+    bool m_headerOk;
+    std::optional<Archive> m_archive;
 };
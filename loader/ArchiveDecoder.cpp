@@ -0,0 +1,281 @@
+// ArchiveDecoder.cpp - Incremental LZ4 and LZMA archive decompression
+//   Written by mkwcat
+
+#include "ArchiveDecoder.hpp"
+#include <Log.hpp>
+#include <cstring>
+
+/**
+ * Copy 8 bytes as two words. Broadway handles misaligned integer loads and
+ * stores in hardware, but not misaligned floating point ones, which GCC may
+ * pick for a plain 8 byte copy. memcpy isn't a builtin in this build, so
+ * __builtin_memcpy is used to get single lwz and stw instructions.
+ */
+static inline void Copy8(u8* dst, const u8* src)
+{
+    u32 word0, word1;
+    __builtin_memcpy(&word0, src, 4);
+    __builtin_memcpy(&word1, src + 4, 4);
+    __builtin_memcpy(dst, &word0, 4);
+    __builtin_memcpy(dst + 4, &word1, 4);
+}
+
+static inline u32 ReadLE32(const u8* data)
+{
+    return data[0] | data[1] << 8 | data[2] << 16 | data[3] << 24;
+}
+
+/**
+ * Read the extra bytes of an LZ4 literal or match length.
+ * @returns False if the length runs past the end of the block.
+ */
+static inline bool
+ReadLZ4Length(const u8** in, const u8* blockEnd, u32* length)
+{
+    const u8* at = *in;
+    u32 value;
+    do {
+        if (at == blockEnd) {
+            return false;
+        }
+        value = *at++;
+        *length += value;
+    } while (value == 0xFF);
+
+    *in = at;
+    return true;
+}
+
+ArchiveDecoder::ArchiveDecoder(const u8* in, u32 inSize, u8* out, u32 outSize)
+  : m_in(in)
+  , m_inEnd(in + inSize)
+  , m_outStart(out)
+  , m_out(out)
+  , m_outEnd(out + outSize)
+{
+    if (inSize >= 4 && ReadLE32(in) == LZ4_LEGACY_MAGIC) {
+        m_in += 4;
+        m_blockEnd = m_in;
+        m_codec = Codec::LZ4;
+        return;
+    }
+
+    // The alone header is the properties and the 64 bit decoded size. The
+    // packer doesn't record the size, the stream ends with an end mark.
+    if (inSize < LZMA_HEADER_SIZE) {
+        PRINT(System, ERROR, "Archive is too small: %u", inSize);
+        return;
+    }
+
+    LzmaDec_Construct(&m_lzma);
+    if (LzmaDec_AllocateProbs(&m_lzma, in, LZMA_PROPS_SIZE, nullptr) !=
+        SZ_OK) {
+        PRINT(System, ERROR, "Unknown archive codec");
+        return;
+    }
+    m_lzma.dic = out;
+    m_lzma.dicBufSize = outSize;
+    LzmaDec_Init(&m_lzma);
+
+    m_in += LZMA_HEADER_SIZE;
+    m_codec = Codec::LZMA;
+}
+
+ArchiveDecoder::Codec ArchiveDecoder::GetCodec() const
+{
+    return m_codec;
+}
+
+bool ArchiveDecoder::DecodeTo(u32 size)
+{
+    if (size > static_cast<u32>(m_outEnd - m_outStart)) {
+        return false;
+    }
+
+    return Decode(size) && GetDecodedSize() >= size;
+}
+
+bool ArchiveDecoder::DecodeAll()
+{
+    return Decode(m_outEnd - m_outStart) && m_done;
+}
+
+u32 ArchiveDecoder::GetDecodedSize() const
+{
+    return m_out - m_outStart;
+}
+
+bool ArchiveDecoder::IsDone() const
+{
+    return m_done;
+}
+
+bool ArchiveDecoder::Decode(u32 size)
+{
+    if (m_done || GetDecodedSize() >= size) {
+        return true;
+    }
+
+    switch (m_codec) {
+    case Codec::LZ4:
+        return DecodeLZ4(m_outStart + size);
+
+    case Codec::LZMA:
+        return DecodeLZMA(size);
+
+    default:
+        return false;
+    }
+}
+
+/**
+ * Decode whole LZ4 sequences until the output reaches the target. Copies are
+ * done 8 bytes at a time where the buffers have room for it, which can write
+ * a little past the decoded size; that space is decoded over later.
+ */
+bool ArchiveDecoder::DecodeLZ4(u8* target)
+{
+    const u8* in = m_in;
+    u8* out = m_out;
+    u8* const outEnd = m_outEnd;
+    bool corrupt = false;
+
+    while (true) {
+        const u8* const blockEnd = m_blockEnd;
+
+        // Blocks are read even once the target is reached, so the end of the
+        // stream is found if the archive fills the output exactly
+        if (in == blockEnd) {
+            if (in == m_inEnd) {
+                m_done = true;
+                break;
+            }
+
+            if (m_inEnd - in < 4) {
+                corrupt = true;
+                break;
+            }
+            const u32 blockSize = ReadLE32(in);
+            in += 4;
+            if (blockSize > static_cast<u32>(m_inEnd - in)) {
+                corrupt = true;
+                break;
+            }
+            m_blockEnd = in + blockSize;
+            continue;
+        }
+
+        if (out >= target) {
+            break;
+        }
+
+        const u32 token = *in++;
+
+        u32 length = token >> 4;
+        if (length == 0xF && !ReadLZ4Length(&in, blockEnd, &length)) {
+            corrupt = true;
+            break;
+        }
+        if (length > static_cast<u32>(blockEnd - in) ||
+            length > static_cast<u32>(outEnd - out)) {
+            corrupt = true;
+            break;
+        }
+
+        // Most literal runs are short enough for two fixed copies
+        if (length <= 16 && blockEnd - in >= 16 && outEnd - out >= 16) {
+            Copy8(out, in);
+            Copy8(out + 8, in + 8);
+        } else {
+            std::memcpy(out, in, length);
+        }
+        in += length;
+        out += length;
+
+        // The last sequence of a block is only literals
+        if (in == blockEnd) {
+            continue;
+        }
+
+        if (blockEnd - in < 2) {
+            corrupt = true;
+            break;
+        }
+        const u32 offset = in[0] | in[1] << 8;
+        in += 2;
+
+        length = (token & 0xF) + LZ4_MIN_MATCH;
+        if (length == 0xF + LZ4_MIN_MATCH &&
+            !ReadLZ4Length(&in, blockEnd, &length)) {
+            corrupt = true;
+            break;
+        }
+        if (offset == 0 || offset > static_cast<u32>(out - m_outStart) ||
+            length > static_cast<u32>(outEnd - out)) {
+            corrupt = true;
+            break;
+        }
+
+        const u8* match = out - offset;
+        u8* const matchEnd = out + length;
+        if (offset >= 8 && static_cast<u32>(outEnd - out) >= length + 8) {
+            // Each 8 byte copy only reads bytes already written
+            for (; out < matchEnd; out += 8, match += 8) {
+                Copy8(out, match);
+            }
+        } else {
+            // Overlapping matches repeat the last offset bytes
+            while (out < matchEnd) {
+                *out++ = *match++;
+            }
+        }
+        out = matchEnd;
+    }
+
+    m_in = in;
+    m_out = out;
+
+    if (corrupt) {
+        PRINT(
+            System, ERROR, "Corrupt LZ4 archive at offset 0x%X",
+            GetDecodedSize()
+        );
+        return false;
+    }
+
+    return true;
+}
+
+bool ArchiveDecoder::DecodeLZMA(u32 size)
+{
+    // Finishing at the end of the output checks for the end mark, so the end
+    // of the stream is found if the archive fills the output exactly
+    const ELzmaFinishMode finishMode =
+        size == m_lzma.dicBufSize ? LZMA_FINISH_END : LZMA_FINISH_ANY;
+
+    SizeT inSize = m_inEnd - m_in;
+    ELzmaStatus status;
+    const SRes ret = LzmaDec_DecodeToDic(
+        &m_lzma, size, m_in, &inSize, finishMode, &status
+    );
+    m_in += inSize;
+    m_out = m_outStart + m_lzma.dicPos;
+
+    if (ret != SZ_OK) {
+        PRINT(System, ERROR, "Corrupt LZMA archive: %d", ret);
+        return false;
+    }
+
+    // The whole stream is in memory, so needing more input means it's
+    // truncated
+    if (status == LZMA_STATUS_FINISHED_WITH_MARK ||
+        (status == LZMA_STATUS_MAYBE_FINISHED_WITHOUT_MARK &&
+         m_in == m_inEnd)) {
+        m_done = true;
+    } else if (status == LZMA_STATUS_NEEDS_MORE_INPUT) {
+        PRINT(System, ERROR, "Truncated LZMA archive");
+        return false;
+    }
+
+    return true;
+}
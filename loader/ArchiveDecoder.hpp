@@ -0,0 +1,68 @@
+#pragma once
+
+#include "7zLzmaDec.h"
+#include <Types.h>
+
+// Decompresses an archive in steps, so the members at its start can be used
+// while the rest is still compressed. The codec is detected from the stream:
+// an LZ4 legacy frame (wuj5 .arc.lz4) or an LZMA alone stream (.arc.lzma).
+class ArchiveDecoder
+{
+public:
+    enum class Codec {
+        INVALID,
+        LZMA,
+        LZ4,
+    };
+
+    /**
+     * Start decoding an archive. Nothing is decoded until DecodeTo.
+     * @param out Where to decode to. Bytes past the decoded size may be
+     * written as scratch until decoding is done.
+     */
+    ArchiveDecoder(const u8* in, u32 inSize, u8* out, u32 outSize);
+
+    Codec GetCodec() const;
+
+    /**
+     * Decode at least the first size bytes of the archive.
+     * @returns False if the stream is corrupt, or ends or runs out of output
+     * space first.
+     */
+    bool DecodeTo(u32 size);
+
+    /**
+     * Decode the rest of the archive.
+     * @returns False if the stream is corrupt or runs out of output space.
+     */
+    bool DecodeAll();
+
+    /**
+     * Get the number of bytes decoded, which is the archive size once done.
+     */
+    u32 GetDecodedSize() const;
+
+    bool IsDone() const;
+
+private:
+    static constexpr u32 LZ4_LEGACY_MAGIC = 0x184C2102;
+    static constexpr u32 LZ4_MIN_MATCH = 4;
+    static constexpr u32 LZMA_HEADER_SIZE = LZMA_PROPS_SIZE + 8;
+
+    bool Decode(u32 size);
+    bool DecodeLZ4(u8* target);
+    bool DecodeLZMA(u32 size);
+
+    Codec m_codec = Codec::INVALID;
+    bool m_done = false;
+    const u8* m_in;
+    const u8* m_inEnd;
+    u8* m_outStart;
+    u8* m_out;
+    u8* m_outEnd;
+
+    // End of the current LZ4 block
+    const u8* m_blockEnd;
+
+    CLzmaDec m_lzma;
+};
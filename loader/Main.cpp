@@ -3,7 +3,7 @@
 //
 // SPDX-License-Identifier: GPL-2.0-only
 
-#include "7zLzmaDec.h"
+#include "ArchiveDecoder.hpp"
 #include <AddressMap.h>
 #include <Archive.hpp>
 #include <Arguments.hpp>
@@ -16,9 +16,11 @@
 #include <Log.hpp>
 #include <PatchManager.hpp>
 #include <StarlingIOS.hpp>
+#include <Util.h>
 #include <array>
 #include <cstring>
 #include <iterator>
+#include <optional>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -62,7 +64,7 @@ static inline void CopyWords(u32* dest, u32* src, u32 count)
 
 void WaitMilliseconds(u32 milliseconds)
 {
-    u32 duration = milliseconds * 60750;
+    u32 duration = milliseconds * TB_TICKS_PER_MS;
     u32 start = __builtin_ppc_mftb();
     while (__builtin_ppc_mftb() - start < duration) {
     }
@@ -252,26 +254,49 @@ bool LoadWiiShopDOL()
 extern u8 LoaderArchive[];
 extern u32 LoaderArchiveSize;
 
-static bool s_bootArcDecomp = false;
 static u8* s_bootArcData = reinterpret_cast<u8*>(BOOT_ARC_ADDRESS);
-static u32 s_bootArcSize = BOOT_ARC_MAXLEN;
+static std::optional<ArchiveDecoder> s_bootArcDecoder;
 
-Archive GetLoaderArchive()
+// Path index of the loader archive. It only holds a few members, so this is
+// kept in BSS rather than scratch space.
+static u32 s_bootArcIndex[0x80];
+
+/**
+ * Get the loader archive with only its header and tables decoded. Members
+ * must be decoded with DecodeLoaderFile before they're used.
+ */
+static Archive GetLoaderArchiveTables()
 {
-    if (!s_bootArcDecomp) {
-        ELzmaStatus status;
-        u32 inLen = LoaderArchiveSize - 5;
-        auto ret = LzmaDecode(
-            s_bootArcData, &s_bootArcSize, LoaderArchive + 0xD, &inLen,
-            LoaderArchive, LZMA_PROPS_SIZE, LZMA_FINISH_END, &status, 0
+    if (!s_bootArcDecoder.has_value()) {
+        s_bootArcDecoder.emplace(
+            LoaderArchive, LoaderArchiveSize, s_bootArcData, BOOT_ARC_MAXLEN
         );
+    }
 
-        assert(ret == SZ_OK);
+    // The header ends with the offset of the member data, which follows the
+    // tables
+    if (s_bootArcDecoder->DecodeTo(0x10)) {
+        s_bootArcDecoder->DecodeTo(ReadU32(s_bootArcData + 0xC));
+    }
 
-        s_bootArcDecomp = true;
+    return Archive(
+        s_bootArcData, s_bootArcDecoder->GetDecodedSize(), BOOT_ARC_MAXLEN
+    );
+}
+
+/**
+ * Decode the loader archive up to the end of a member.
+ */
+static std::optional<Archive::File>
+DecodeLoaderFile(const Archive& archive, const char* path)
+{
+    auto entry = archive.get(path);
+    Archive::File* file = std::get_if<Archive::File>(&entry);
+    if (!file || !s_bootArcDecoder->DecodeTo(file->offset + file->size)) {
+        return std::nullopt;
     }
 
-    return Archive(s_bootArcData, s_bootArcSize);
+    return *file;
 }
 
 struct HBCArgv {
@@ -305,7 +330,16 @@ void Launch()
 
     PatchManager::StaticInit();
 
-    Archive archive = GetLoaderArchive();
+    // Only the tables and the IOS loader are decoded before IOS is
+    // bootstrapped, the IOS module is decoded while it starts up
+    const u32 startTime = __builtin_ppc_mftb();
+    Archive archive = GetLoaderArchiveTables();
+    if (!archive.buildIndex(s_bootArcIndex, sizeof(s_bootArcIndex))) {
+        PRINT(
+            System, WARN, "Loader archive index not built, size: 0x%X",
+            archive.indexSize()
+        );
+    }
 
     u32 argc = 0;
     const char* argv[128] = {};
@@ -326,8 +360,7 @@ void Launch()
     }
 
     Console::Print("I[Loader] Starting IOS loader... ");
-    auto entry = archive.get("./ios_loader.bin");
-    Archive::File* file = std::get_if<Archive::File>(&entry);
+    auto file = DecodeLoaderFile(archive, "./ios_loader.bin");
     if (!file) {
         Console::Print("\nERROR : Failed to get the IOS boot payload.\n");
         return;
@@ -341,26 +374,45 @@ void Launch()
         reinterpret_cast<void*>(IOS_BOOT_ADDRESS), file->size
     );
 
-    entry = archive.get("./ios_module.elf");
-    file = std::get_if<Archive::File>(&entry);
-    if (!file) {
+    auto entry = archive.get("./ios_module.elf");
+    const Archive::File* module = std::get_if<Archive::File>(&entry);
+    if (!module) {
         Console::Print("\nERROR : Failed to get the IOS module.\n");
         return;
     }
 
-    WriteU32(IOS_FILE_INFO_ADDRESS, s_bootArcData + file->offset);
-    WriteU32(IOS_FILE_INFO_ADDRESS + 4, file->size);
+    // The IOS loader waits for the ready word to be set before it reads the
+    // module
+    WriteU32(IOS_FILE_INFO_ADDRESS, s_bootArcData + module->offset);
+    WriteU32(IOS_FILE_INFO_ADDRESS + 4, module->size);
+    WriteU32(IOS_FILE_INFO_ADDRESS + 8, 0);
     StarlingIOS::SafeFlush(
         reinterpret_cast<void*>(IOS_FILE_INFO_ADDRESS), IOS_FILE_INFO_MAXLEN
     );
-    StarlingIOS::SafeFlush(s_bootArcData + file->offset, file->size);
 
     if (!StarlingIOS::BootstrapEntry()) {
         Console::Print("\nERROR : Failed to launch the IOS boot payload.\n");
         return;
     }
+    const u32 bootstrapTime = __builtin_ppc_mftb();
+
+    if (!s_bootArcDecoder->DecodeTo(module->offset + module->size)) {
+        Console::Print("\nERROR : Failed to decode the IOS module.\n");
+        return;
+    }
+
+    // IOS is running, so the module is flushed directly rather than through
+    // an IPC request, and the ready word is written uncached
+    CPUCache::DCFlush(s_bootArcData, module->offset + module->size);
+    WriteU32((IOS_FILE_INFO_ADDRESS + 8) | 0xC0000000, 1);
     Console::Print("OK\n");
 
+    PRINT(
+        System, INFO, "Bootstrapped IOS in %u us, IOS module ready in %u us",
+        (bootstrapTime - startTime) / (TB_TICKS_PER_MS / 1000),
+        (__builtin_ppc_mftb() - startTime) / (TB_TICKS_PER_MS / 1000)
+    );
+
     argc = 5;
     argv[1] = "--patch-id";
     argv[2] = "mkwcat-special-nsmbw-project";
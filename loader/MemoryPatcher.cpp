@@ -0,0 +1,86 @@
+// MemoryPatcher.cpp - Batched Riivolution memory patches
+//   Written by mkwcat
+
+#include "MemoryPatcher.hpp"
+#include <Log.hpp>
+#include <Util.h>
+#include <cstring>
+
+u32 MemoryPatcher::Apply(Patch* patches, u32 count)
+{
+    const u32 startTime = __builtin_ppc_mftb();
+
+    // Check and write in document order, so an original is compared with
+    // memory as the patches before it left it
+    u32 applied = 0;
+    for (u32 i = 0; i < count; i++) {
+        Patch* patch = &patches[i];
+        patch->applied = false;
+
+        if (patch->length == 0) {
+            continue;
+        }
+
+        if (patch->original != nullptr &&
+            std::memcmp(patch->address, patch->original, patch->length) != 0) {
+            PRINT(
+                Patcher, WARN, "Memory patch at %08X doesn't match original",
+                reinterpret_cast<u32>(patch->address)
+            );
+            continue;
+        }
+
+        std::memcpy(patch->address, patch->value, patch->length);
+        patch->applied = true;
+        applied++;
+    }
+
+    const u32 ticks = __builtin_ppc_mftb() - startTime;
+    PRINT(
+        Patcher, INFO, "Applied %u of %u memory patches in %u us", applied,
+        count, ticks / (TB_TICKS_PER_MS / 1000)
+    );
+
+    return applied;
+}
+
+/**
+ * Get the value of a hex digit, or -1 if it isn't one.
+ */
+static s32 HexDigit(char c)
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+u32 MemoryPatcher::DecodeHex(const char* str, u8* out, u32 maxSize)
+{
+    if (str[0] == '0' && (str[1] == 'x' || str[1] == 'X')) {
+        str += 2;
+    }
+
+    const u32 length = std::strlen(str);
+    if (length == 0 || length % 2 != 0 || length / 2 > maxSize) {
+        return 0;
+    }
+
+    for (u32 i = 0; i < length / 2; i++) {
+        const s32 high = HexDigit(str[i * 2]);
+        const s32 low = HexDigit(str[i * 2 + 1]);
+        if (high < 0 || low < 0) {
+            return 0;
+        }
+
+        out[i] = high << 4 | low;
+    }
+
+    return length / 2;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <Types.h>
+
+// Applies Riivolution memory patches as one batch, in document order. There's
+// no cache maintenance here: the patches go to the DOL before it's run, and
+// RunDOL flushes and invalidates every line of it as it's copied into place.
+class MemoryPatcher
+{
+public:
+    struct Patch {
+        u8* address;
+        const u8* value;
+        // Bytes expected at the address before patching, or nullptr to patch
+        // unconditionally. The same length as value.
+        const u8* original;
+        u32 length;
+
+        // Set by Apply
+        bool applied;
+    };
+
+    /**
+     * Apply memory patches in document order, so the last of two overlapping
+     * patches wins and an original sees the patches before it.
+     * @returns The number of patches applied.
+     */
+    static u32 Apply(Patch* patches, u32 count);
+
+    /**
+     * Decode a Riivolution hex value, with or without a "0x" prefix.
+     * @returns The number of bytes, or 0 if the value is invalid or longer
+     * than maxSize.
+     */
+    static u32 DecodeHex(const char* str, u8* out, u32 maxSize);
+};
@@ -0,0 +1,151 @@
+// MemorySearch.cpp - Multi-pattern memory search
+//   Written by mkwcat
+
+#include "MemorySearch.hpp"
+#include <Log.hpp>
+#include <Util.h>
+#include <cassert>
+#include <cstring>
+
+/**
+ * Get the number of bits of the index table for a pattern count, keeping it
+ * at most half full.
+ */
+static u32 GetTableBits(u32 count)
+{
+    u32 bits = 4;
+    while ((1u << bits) < count * 2) {
+        bits++;
+    }
+    return bits;
+}
+
+u32 MemorySearch::GetWorkSize(u32 count)
+{
+    return (1 << FILTER_BITS) / 8 + count * sizeof(u32) +
+           AlignUp((1 << GetTableBits(count)) * sizeof(u16), 4);
+}
+
+MemorySearch::MemorySearch(Pattern* patterns, u32 count, void* work)
+  : m_patterns(patterns)
+  , m_count(count)
+  , m_found(0)
+  , m_wordAligned(true)
+  , m_bias(0)
+{
+    // Pattern indices are stored in a u16, with NO_PATTERN marking a free slot
+    assert(count < NO_PATTERN);
+
+    const u32 tableBits = GetTableBits(count);
+    m_tableShift = 32 - tableBits;
+    m_tableMask = (1 << tableBits) - 1;
+
+    m_filter = static_cast<u32*>(work);
+    m_keys = m_filter + (1 << FILTER_BITS) / 32;
+    m_table = reinterpret_cast<u16*>(m_keys + count);
+
+    std::memset(m_filter, 0, (1 << FILTER_BITS) / 8);
+    std::memset(m_table, 0xFF, (1 << tableBits) * sizeof(u16));
+
+    for (u32 i = 0; i < count; i++) {
+        Pattern* pattern = &patterns[i];
+        pattern->match = nullptr;
+
+        if (pattern->length < MIN_PATTERN_LENGTH) {
+            PRINT(Patcher, ERROR, "Search pattern too short");
+            m_found++;
+            continue;
+        }
+
+        if (pattern->align == 0) {
+            pattern->align = 1;
+        }
+        if (pattern->align % 4 != 0) {
+            m_wordAligned = false;
+        }
+
+        const u8* data = pattern->data;
+        const u32 key = data[0] << 24 | data[1] << 16 | data[2] << 8 | data[3];
+        m_keys[i] = key;
+
+        const u32 hash = HashWord(key);
+        const u32 bit = hash >> (32 - FILTER_BITS);
+        m_filter[bit >> 5] |= 1 << (bit & 31);
+
+        u32 slot = hash >> m_tableShift;
+        while (m_table[slot] != NO_PATTERN) {
+            slot = (slot + 1) & m_tableMask;
+        }
+        m_table[slot] = i;
+    }
+}
+
+/**
+ * Check the patterns starting with a word against memory.
+ * @returns True if every pattern has now been found.
+ */
+bool MemorySearch::CheckCandidates(u32 word, const u8* at, const u8* end)
+{
+    for (u32 slot = HashWord(word) >> m_tableShift;
+         m_table[slot] != NO_PATTERN; slot = (slot + 1) & m_tableMask) {
+        Pattern* pattern = &m_patterns[m_table[slot]];
+        if (m_keys[m_table[slot]] != word || pattern->match != nullptr ||
+            (reinterpret_cast<u32>(at) + m_bias) % pattern->align != 0 ||
+            pattern->length > static_cast<u32>(end - at)) {
+            continue;
+        }
+
+        if (std::memcmp(
+                at + MIN_PATTERN_LENGTH, pattern->data + MIN_PATTERN_LENGTH,
+                pattern->length - MIN_PATTERN_LENGTH
+            ) == 0) {
+            pattern->match = at;
+            m_found++;
+        }
+    }
+
+    return m_found == m_count;
+}
+
+u32 MemorySearch::Search(const u8* start, const u8* end, u32 address)
+{
+    if (m_found == m_count || end - start < 4) {
+        return m_found;
+    }
+
+    m_bias = address - reinterpret_cast<u32>(start);
+
+    // Words aligned in memory are only aligned at the address if the two are
+    // a multiple of 4 apart
+    if (m_wordAligned && m_bias % 4 == 0) {
+        // Only aligned words can match
+        const u32* word = reinterpret_cast<const u32*>(AlignUp(start, 4));
+        const u32* wordEnd = reinterpret_cast<const u32*>(AlignDown(end, 4));
+        for (; word < wordEnd; word++) {
+            if (TestFilter(HashWord(*word)) &&
+                CheckCandidates(
+                    *word, reinterpret_cast<const u8*>(word), end
+                )) {
+                break;
+            }
+        }
+    } else {
+        // Roll a big endian word along, one byte at a time
+        u32 word = start[0] << 16 | start[1] << 8 | start[2];
+        for (const u8* at = start; at + 4 <= end; at++) {
+            word = word << 8 | at[3];
+            if (TestFilter(HashWord(word)) && CheckCandidates(word, at, end)) {
+                break;
+            }
+        }
+    }
+
+    u32 found = 0;
+    for (u32 i = 0; i < m_count; i++) {
+        if (m_patterns[i].match != nullptr) {
+            found++;
+        }
+    }
+
+    return found;
+}
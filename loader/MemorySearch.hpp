@@ -0,0 +1,91 @@
+#pragma once
+
+#include <Types.h>
+
+// Finds many byte patterns in one pass over memory, for Riivolution memory
+// nodes with search set. Patterns are indexed by their first word. The scan
+// reads memory a word at a time and rejects most words with a single bit test
+// in a filter, so only words a pattern starts with are looked up and compared
+// in full. If every pattern is word aligned, only aligned words are read,
+// otherwise a word is rolled along one byte at a time.
+class MemorySearch
+{
+public:
+    static constexpr u32 MIN_PATTERN_LENGTH = 4;
+
+    struct Pattern {
+        const u8* data;
+        u32 length;
+        // A match must start at a multiple of align
+        u32 align;
+
+        // Set by Search to the first match, or nullptr if not found
+        const u8* match;
+    };
+
+    /**
+     * Get the size of the work space needed to search for count patterns.
+     */
+    static u32 GetWorkSize(u32 count);
+
+    /**
+     * Index the patterns. Patterns shorter than MIN_PATTERN_LENGTH are never
+     * found.
+     * @param work Work space of GetWorkSize(count) bytes, 4 byte aligned.
+     */
+    MemorySearch(Pattern* patterns, u32 count, void* work);
+
+    /**
+     * Scan memory once, recording the first match of each pattern. The scan
+     * stops early once every pattern is found. Patterns found by an earlier
+     * call aren't searched for again, so separate ranges can be searched one
+     * after another.
+     * @returns The number of patterns found.
+     */
+    u32 Search(const u8* start, const u8* end)
+    {
+        return Search(start, end, reinterpret_cast<u32>(start));
+    }
+
+    /**
+     * Scan memory that will be at another address once it's in use, like a
+     * DOL section before it's copied into place. Alignment is checked at
+     * that address.
+     * @param address The address start will be at.
+     * @returns The number of patterns found.
+     */
+    u32 Search(const u8* start, const u8* end, u32 address);
+
+private:
+    static constexpr u32 FILTER_BITS = 14;
+    static constexpr u32 NO_PATTERN = 0xFFFF;
+
+    static u32 HashWord(u32 word)
+    {
+        return word * 0x9E3779B1;
+    }
+
+    bool TestFilter(u32 hash) const
+    {
+        const u32 bit = hash >> (32 - FILTER_BITS);
+        return m_filter[bit >> 5] & (1 << (bit & 31));
+    }
+
+    bool CheckCandidates(u32 word, const u8* at, const u8* end);
+
+    Pattern* m_patterns;
+    u32 m_count;
+    u32 m_found;
+    // Every pattern is word aligned
+    bool m_wordAligned;
+    // Added to a memory address to get the address alignment is checked at
+    u32 m_bias;
+
+    u32* m_filter;
+    // First word of each pattern
+    u32* m_keys;
+    // Open addressed by the first word hash, holding pattern indices
+    u16* m_table;
+    u32 m_tableShift;
+    u32 m_tableMask;
+};
@@ -4,11 +4,27 @@
 #include <AddressMap.h>
 #include <IOS.hpp>
 #include <Log.hpp>
+#include <Util.h>
 #include <XML/rapidxml.hpp>
+#include <algorithm>
 #include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
 
 PatchUnit* PatchManager::s_first;
 PatchUnit* PatchManager::s_last;
+u8* PatchManager::s_scratch;
+PatchManager::PatchIndexEntry* PatchManager::s_patchIndex;
+u32 PatchManager::s_patchIndexSize;
+PatchManager::MemoryPatch PatchManager::s_memoryPatches[MaxMemoryPatches];
+u32 PatchManager::s_memoryPatchCount;
+u8 PatchManager::s_memoryData[MaxMemoryData];
+u32 PatchManager::s_memoryDataSize;
+PatchManager::DiscNode PatchManager::s_discNodes[MaxDiscNodes];
+u32 PatchManager::s_discNodeCount;
+EmuDITypes::FolderPatch PatchManager::s_folderPatches[MaxFolderPatches];
+u32 PatchManager::s_folderPatchCount;
 
 void PatchManager::StaticInit()
 {
@@ -16,61 +32,661 @@ void PatchManager::StaticInit()
     s_first->m_next = nullptr;
     s_first->m_type = PatchUnit::Type::DISABLED;
     s_last = s_first;
+    FreeScratch();
 }
 
+char* PatchManager::AllocScratch(u32 size)
+{
+    // The end of the last unit, plus room for the next unit's header
+    const u8* listEnd = reinterpret_cast<const u8*>(s_last + 1);
+    if (s_last->m_type != PatchUnit::Type::DISABLED) {
+        listEnd = reinterpret_cast<const u8*>(s_last->m_next + 1);
+    }
+
+    if (size > static_cast<u32>(s_scratch - listEnd)) {
+        return nullptr;
+    }
+
+    u8* scratch = AlignDown(s_scratch - size, 32);
+    if (scratch < listEnd) {
+        return nullptr;
+    }
+
+    s_scratch = scratch;
+    return reinterpret_cast<char*>(scratch);
+}
+
+void PatchManager::FreeScratch()
+{
+    s_scratch = reinterpret_cast<u8*>(PATCH_LIST_ADDRESS + PATCH_LIST_MAXLEN);
+    s_patchIndex = nullptr;
+}
+
+// Mount points searched by a /mnt/* path
+static constexpr const char* MOUNT_NAMES[] = {
+    "sd", "usb0", "usb1", "usb2", "usb3", "usb4", "usb5", "usb6", "usb7",
+};
+
+/**
+ * Get the drive of the device a /mnt path is on, which is the index of its
+ * mount point. Paths on no mount point are taken to be on the SD card.
+ */
+static u32 GetMountDrive(const char* path)
+{
+    if (std::strncmp(path, "/mnt/", 5) != 0) {
+        return 0;
+    }
+
+    for (u32 i = 0; i < std::size(MOUNT_NAMES); i++) {
+        const u32 length = std::strlen(MOUNT_NAMES[i]);
+        if (std::strncmp(path + 5, MOUNT_NAMES[i], length) == 0 &&
+            path[5 + length] == '/') {
+            return i;
+        }
+    }
+
+    return 0;
+}
+
+const char* PatchManager::GetMountName(u32 drive)
+{
+    return drive < std::size(MOUNT_NAMES) ? MOUNT_NAMES[drive] : MOUNT_NAMES[0];
+}
+
+// Most directory entries looked at for XML files
+static constexpr u32 XML_DIR_MAX_COUNT = 32;
+
 bool PatchManager::LoadRiivolutionXML(const char* path)
 {
-    // TODO: Handle directory path
+    if (std::strncmp(path, "/mnt/*/", 7) == 0) {
+        bool loaded = false;
+        for (const char* mount : MOUNT_NAMES) {
+            char mountPath[ISFS::MAX_PATH_LENGTH];
+            if (std::snprintf(
+                    mountPath, sizeof(mountPath), "/mnt/%s/%s", mount, path + 7
+                ) < static_cast<s32>(sizeof(mountPath))) {
+                loaded |= LoadRiivolutionXML(mountPath);
+            }
+        }
+
+        return loaded;
+    }
+
+    // Try the path as a directory first
+    if (std::strlen(path) < ISFS::MAX_PATH_LENGTH) {
+        char dirPath[ISFS::MAX_PATH_LENGTH] = {};
+        std::strcpy(dirPath, path);
+
+        char names[XML_DIR_MAX_COUNT][13];
+        u32 maxCount = XML_DIR_MAX_COUNT;
+        u32 count = 0;
+
+        IOS::IOVector<2, 2> vec;
+        vec.in[0].data = dirPath;
+        vec.in[0].len = sizeof(dirPath);
+        vec.in[1].data = &maxCount;
+        vec.in[1].len = sizeof(maxCount);
+        vec.out[0].data = names;
+        vec.out[0].len = sizeof(names);
+        vec.out[1].data = &count;
+        vec.out[1].len = sizeof(count);
+
+        IOS::ResourceCtrl<ISFS::ISFSIoctl> fs("/dev/fs");
+        if (fs.Ioctlv(ISFS::ISFSIoctl::READ_DIR, vec) ==
+            ISFS::ISFSError::OK) {
+            if (count >= XML_DIR_MAX_COUNT) {
+                PRINT(
+                    Patcher, WARN,
+                    "Only the first %u entries of '%s' are checked for XML "
+                    "files",
+                    XML_DIR_MAX_COUNT, dirPath
+                );
+            }
+
+            return LoadRiivolutionXMLDir(
+                dirPath, names, std::min(count, XML_DIR_MAX_COUNT)
+            );
+        }
+    }
 
     PRINT(Patcher, INFO, "Loading Riivolution XML file '%s'", path);
 
-    IOS::File xmlFile(path, IOS::Mode::READ);
-    if (!xmlFile.IsValid()) {
-        PRINT(
-            Patcher, ERROR, "Failed to open Riivolution XML file: %d",
-            xmlFile.GetFd()
-        );
+    return LoadRiivolutionXMLFiles(&path, 1);
+}
+
+bool PatchManager::LoadRiivolutionXMLDir(
+    const char* path, const char (*names)[13], u32 count
+)
+{
+    PRINT(Patcher, INFO, "Loading Riivolution XML directory '%s'", path);
+
+    constexpr u32 MaxBatch = ISFS::EX_READ_FILES_MAX_COUNT;
+
+    char paths[MaxBatch][ISFS::MAX_PATH_LENGTH];
+    const char* batchPaths[MaxBatch];
+
+    bool loaded = false;
+    for (u32 i = 0; i < count;) {
+        u32 batchCount = 0;
+        for (; i < count && batchCount < MaxBatch; i++) {
+            char* filePath = paths[batchCount];
+            if (!StrNoCaseEndsWith(names[i], ".xml") ||
+                std::snprintf(
+                    filePath, ISFS::MAX_PATH_LENGTH, "%s/%s", path, names[i]
+                ) >= static_cast<s32>(ISFS::MAX_PATH_LENGTH)) {
+                continue;
+            }
+
+            batchPaths[batchCount++] = filePath;
+        }
+
+        if (batchCount == 0) {
+            break;
+        }
+
+        loaded |= LoadRiivolutionXMLFiles(batchPaths, batchCount);
+    }
+
+    return loaded;
+}
+
+// Compiled databases are cached here, named by the hash of the XML path
+static constexpr const char DB_CACHE_PARENT_DIR[] = "/mnt/sd/starling";
+static constexpr const char DB_CACHE_DIR[] = "/mnt/sd/starling/cache";
+
+static constexpr u32 DB_CACHE_MAGIC = 0x52444332; // RDC2
+
+// Header of a cached database file, followed by the database. The cache is
+// used as is if the XML path, size and modified time match, and after a check
+// of the XML hash if only the time changed. The path is kept because the file
+// name is only a hash of it. XMLs with longer paths aren't cached.
+struct DBCacheHeader {
+    u32 magic;
+    u32 xmlSize;
+    u32 xmlModified;
+    u32 xmlHash;
+    u32 dbSize;
+    u32 reserved[3];
+    char xmlPath[ISFS::MAX_PATH_LENGTH];
+};
+
+static_assert(sizeof(DBCacheHeader) == 0x60);
+
+/**
+ * FNV-1a hash of a buffer.
+ */
+static u32 HashData(const void* data, u32 size)
+{
+    const u8* bytes = static_cast<const u8*>(data);
+    u32 hash = 0x811C9DC5;
+    for (u32 i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 0x01000193;
+    }
+    return hash;
+}
+
+/**
+ * Get the compiled database from a cache file, if it was made for the XML at
+ * the given path and of the given size.
+ */
+static const RiivolutionDB*
+GetCachedDB(const void* data, u32 size, const char* xmlPath, u32 xmlSize)
+{
+    const DBCacheHeader* header = static_cast<const DBCacheHeader*>(data);
+    if (size < sizeof(DBCacheHeader) || header->magic != DB_CACHE_MAGIC ||
+        header->xmlSize != xmlSize ||
+        std::strncmp(header->xmlPath, xmlPath, sizeof(header->xmlPath)) !=
+            0 ||
+        header->dbSize > size - sizeof(DBCacheHeader)) {
+        return nullptr;
+    }
+
+    const RiivolutionDB* db = reinterpret_cast<const RiivolutionDB*>(
+        static_cast<const u8*>(data) + sizeof(DBCacheHeader)
+    );
+    if (!db->IsValid(header->dbSize)) {
+        return nullptr;
+    }
+
+    return db;
+}
+
+/**
+ * Write a compiled database to the cache. Failure only costs a compile on the
+ * next boot, so errors are only logged.
+ */
+static void WriteCachedDB(
+    const char* path, const DBCacheHeader& header, const RiivolutionDB* db
+)
+{
+    static bool s_cacheDirCreated = false;
+
+    IOS::ResourceCtrl<ISFS::ISFSIoctl> fs("/dev/fs");
+    if (fs.GetFd() < 0) {
+        return;
+    }
+
+    alignas(32) ISFS::AttrBlock attr = {};
+    attr.ownerPerm = IOS::Mode::READ_WRITE;
+    attr.groupPerm = IOS::Mode::READ_WRITE;
+    attr.otherPerm = IOS::Mode::READ_WRITE;
+
+    if (!s_cacheDirCreated) {
+        // These fail harmlessly if the directories already exist
+        for (const char* dir : {DB_CACHE_PARENT_DIR, DB_CACHE_DIR}) {
+            std::strcpy(attr.path, dir);
+            fs.Ioctl(
+                ISFS::ISFSIoctl::CREATE_DIR, &attr, sizeof(attr), nullptr, 0
+            );
+        }
+
+        s_cacheDirCreated = true;
+    }
+
+    // Recreate the file so no old data is left past the end
+    std::strcpy(attr.path, path);
+    fs.Ioctl(
+        ISFS::ISFSIoctl::DELETE, attr.path, sizeof(attr.path), nullptr, 0
+    );
+    s32 ret = fs.Ioctl(
+        ISFS::ISFSIoctl::CREATE_FILE, &attr, sizeof(attr), nullptr, 0
+    );
+    if (ret != ISFS::ISFSError::OK) {
+        PRINT(Patcher, WARN, "Failed to create cache file '%s': %d", path, ret);
+        return;
+    }
+
+    IOS::File file(path, IOS::Mode::WRITE);
+    if (!file.IsValid() ||
+        file.Write(&header, sizeof(header)) != sizeof(header) ||
+        file.Write(db, header.dbSize) != static_cast<s32>(header.dbSize)) {
+        PRINT(Patcher, WARN, "Failed to write cache file '%s'", path);
+    }
+}
+
+bool PatchManager::LoadRiivolutionXMLFiles(
+    const char* const* paths, u32 count
+)
+{
+    constexpr u32 MaxBatch = ISFS::EX_READ_FILES_MAX_COUNT;
+    assert(count <= MaxBatch);
+
+    // New units make the patch index out of date, and it's in the way of the
+    // temporary space
+    FreeScratch();
+
+    enum class Source {
+        NONE,
+        // Use the cached database
+        CACHE,
+        // Compile the XML
+        XML,
+        // Use the cached database if the XML hash matches
+        CHECK_XML,
+    };
+
+    Source sources[MaxBatch];
+    char cachePaths[MaxBatch][ISFS::MAX_PATH_LENGTH];
+    const char* readPaths[MaxBatch];
+    void* buffers[MaxBatch] = {};
+    u32 sizes[MaxBatch] = {};
+    s32 results[MaxBatch];
+    s32 xmlSizes[MaxBatch];
+    u32 modified[MaxBatch];
+    s32 cacheSizes[MaxBatch];
+    char* cacheData[MaxBatch] = {};
+    char* xmlData[MaxBatch] = {};
+
+    // Get the size and modified time of each XML, and the size of each cache
+    // file. A zero size buffer only gets the size.
+    s32 ret =
+        IOS::ReadFiles(count, paths, buffers, sizes, xmlSizes, modified);
+    if (ret != ISFS::ISFSError::OK) {
+        PRINT(Patcher, ERROR, "Failed to get XML file sizes: %d", ret);
         return false;
     }
 
-    PatchUnitRiivolution* patchUnit =
-        CreatePatchUnit<PatchUnitRiivolution>(0, xmlFile);
-    assert(patchUnit != nullptr);
+    for (u32 i = 0; i < count; i++) {
+        std::snprintf(
+            cachePaths[i], sizeof(cachePaths[i]), "%s/%08X.rdb", DB_CACHE_DIR,
+            HashData(paths[i], std::strlen(paths[i]))
+        );
+        readPaths[i] = cachePaths[i];
+    }
+
+    ret = IOS::ReadFiles(count, readPaths, buffers, sizes, cacheSizes);
+    if (ret != ISFS::ISFSError::OK) {
+        for (u32 i = 0; i < count; i++) {
+            cacheSizes[i] = ISFS::ISFSError::NOT_FOUND;
+        }
+    }
+
+    // Read every cache file that exists, and every XML that has none
+    u32 readCount = 0;
+    for (u32 i = 0; i < count; i++) {
+        sources[i] = Source::NONE;
+
+        if (xmlSizes[i] < 0) {
+            PRINT(
+                Patcher, ERROR, "Failed to open Riivolution XML file '%s': %d",
+                paths[i], xmlSizes[i]
+            );
+            continue;
+        }
+
+        const bool useCache =
+            cacheSizes[i] > static_cast<s32>(sizeof(DBCacheHeader));
+        u32 size = useCache ? cacheSizes[i] : xmlSizes[i];
+
+        char* data = AllocScratch(size + 1);
+        if (data == nullptr) {
+            PRINT(
+                Patcher, ERROR, "No space to read Riivolution XML file '%s'",
+                paths[i]
+            );
+            continue;
+        }
+
+        sources[i] = useCache ? Source::CACHE : Source::XML;
+        (useCache ? cacheData : xmlData)[i] = data;
+        readPaths[readCount] = useCache ? cachePaths[i] : paths[i];
+        buffers[readCount] = data;
+        sizes[readCount] = size;
+        readCount++;
+    }
+
+    if (readCount != 0) {
+        ret = IOS::ReadFiles(readCount, readPaths, buffers, sizes, results);
+        if (ret != ISFS::ISFSError::OK) {
+            PRINT(Patcher, ERROR, "Failed to read XML files: %d", ret);
+            FreeScratch();
+            return false;
+        }
+    }
+
+    // Check the cache files, and read the XML for any that are out of date
+    u32 xmlReadCount = 0;
+    for (u32 i = 0, j = 0; i < count; i++) {
+        if (sources[i] == Source::NONE) {
+            continue;
+        }
+
+        const u32 read = j++;
+        const s32 result = results[read];
+        if (result != static_cast<s32>(sizes[read])) {
+            PRINT(
+                Patcher, ERROR, "Failed to read '%s': %d", readPaths[read],
+                result
+            );
+            sources[i] = Source::NONE;
+            continue;
+        }
+
+        if (sources[i] != Source::CACHE) {
+            continue;
+        }
+
+        const DBCacheHeader* header =
+            reinterpret_cast<const DBCacheHeader*>(cacheData[i]);
+        if (GetCachedDB(cacheData[i], result, paths[i], xmlSizes[i]) !=
+                nullptr &&
+            header->xmlModified == modified[i]) {
+            continue;
+        }
+
+        // The XML changed or the cache is unusable
+        char* data = AllocScratch(xmlSizes[i] + 1);
+        if (data == nullptr) {
+            PRINT(
+                Patcher, ERROR, "No space to read Riivolution XML file '%s'",
+                paths[i]
+            );
+            sources[i] = Source::NONE;
+            continue;
+        }
+
+        sources[i] = Source::CHECK_XML;
+        xmlData[i] = data;
+        readPaths[xmlReadCount] = paths[i];
+        buffers[xmlReadCount] = data;
+        sizes[xmlReadCount] = xmlSizes[i];
+        xmlReadCount++;
+    }
+
+    if (xmlReadCount != 0) {
+        ret = IOS::ReadFiles(xmlReadCount, readPaths, buffers, sizes, results);
+        if (ret != ISFS::ISFSError::OK) {
+            PRINT(Patcher, ERROR, "Failed to read XML files: %d", ret);
+            FreeScratch();
+            return false;
+        }
+    }
+
+    bool loaded = false;
+    for (u32 i = 0, j = 0; i < count; i++) {
+        if (sources[i] == Source::NONE) {
+            continue;
+        }
+
+        if (sources[i] == Source::CHECK_XML) {
+            const u32 read = j++;
+            if (results[read] != static_cast<s32>(sizes[read])) {
+                PRINT(
+                    Patcher, ERROR,
+                    "Failed to read Riivolution XML file '%s': %d", paths[i],
+                    results[read]
+                );
+                continue;
+            }
+        }
 
-    return patchUnit->IsValid();
+        DBCacheHeader header = {
+            .magic = DB_CACHE_MAGIC,
+            .xmlSize = static_cast<u32>(xmlSizes[i]),
+            .xmlModified = modified[i],
+            .xmlHash = 0,
+            .dbSize = 0,
+            .reserved = {},
+            .xmlPath = {},
+        };
+        const bool cacheable = std::strlen(paths[i]) < sizeof(header.xmlPath);
+        if (cacheable) {
+            std::strcpy(header.xmlPath, paths[i]);
+        }
+
+        if (sources[i] != Source::CACHE) {
+            header.xmlHash = HashData(xmlData[i], xmlSizes[i]);
+        }
+
+        const RiivolutionDB* cachedDB = nullptr;
+        if (sources[i] != Source::XML) {
+            cachedDB = GetCachedDB(
+                cacheData[i], cacheSizes[i], paths[i],
+                static_cast<u32>(xmlSizes[i])
+            );
+        }
+
+        if (sources[i] == Source::CHECK_XML &&
+            (cachedDB == nullptr ||
+             reinterpret_cast<const DBCacheHeader*>(cacheData[i])->xmlHash !=
+                 header.xmlHash)) {
+            cachedDB = nullptr;
+        }
+
+        PatchUnitRiivolution* unit;
+        if (cachedDB != nullptr) {
+            PRINT(
+                Patcher, INFO, "Loaded cached Riivolution XML file '%s'",
+                paths[i]
+            );
+            unit = CreatePatchUnit<PatchUnitRiivolution>(
+                0, cachedDB, s_scratch
+            );
+        } else {
+            PRINT(
+                Patcher, INFO, "Loaded Riivolution XML file '%s'", paths[i]
+            );
+            unit = CreatePatchUnit<PatchUnitRiivolution>(
+                0, xmlData[i], xmlSizes[i], s_scratch
+            );
+        }
+
+        assert(unit != nullptr);
+        if (!unit->IsValid()) {
+            continue;
+        }
+
+        unit->SetDrive(GetMountDrive(paths[i]));
+        loaded = true;
+
+        // Only the modified time changed, or the XML was compiled
+        if (sources[i] != Source::CACHE && cacheable) {
+            header.dbSize = unit->GetDB()->GetSize();
+            WriteCachedDB(cachePaths[i], header, unit->GetDB());
+        }
+    }
+
+    FreeScratch();
+    return loaded;
 }
 
-bool PatchManager::LoadPatchID(const char* patchId)
+bool PatchManager::BuildPatchIndex()
 {
-    PRINT(Patcher, INFO, "Loading patch ID '%s'", patchId);
+    u32 patchCount = 0;
+    for (PatchUnit* patchUnit = s_first; patchUnit != nullptr;
+         patchUnit = patchUnit->m_next) {
+        PatchUnitRiivolution* riivolution =
+            PatchUnitRiivolution::Get(patchUnit);
+        if (riivolution != nullptr && riivolution->IsValid()) {
+            patchCount += riivolution->GetDB()->GetPatchCount();
+        }
+    }
+
+    // Keep the index at most half full
+    u32 indexSize = 1;
+    while (indexSize < patchCount * 2) {
+        indexSize <<= 1;
+    }
+
+    PatchIndexEntry* index = reinterpret_cast<PatchIndexEntry*>(
+        AllocScratch(indexSize * sizeof(PatchIndexEntry))
+    );
+    if (index == nullptr) {
+        PRINT(Patcher, WARN, "No space for the patch ID index");
+        return false;
+    }
+
+    for (u32 i = 0; i < indexSize; i++) {
+        index[i].patch = nullptr;
+    }
 
+    const u32 mask = indexSize - 1;
     for (PatchUnit* patchUnit = s_first; patchUnit != nullptr;
          patchUnit = patchUnit->m_next) {
         PatchUnitRiivolution* riivolution =
             PatchUnitRiivolution::Get(patchUnit);
-        if (riivolution == nullptr) {
+        if (riivolution == nullptr || !riivolution->IsValid()) {
             continue;
         }
 
-        if (!riivolution->HandlePatch(
-                patchId,
-                [riivolution](const PatchUnitRiivolution::PatchNode& node) {
-            return HandlePatchNode(riivolution, node);
+        const RiivolutionDB* db = riivolution->GetDB();
+        const RiivolutionDB::Patch* patches = db->GetPatches();
+        for (u32 i = 0; i < db->GetPatchCount(); i++) {
+            const RiivolutionDB::Patch* patch = &patches[i];
+            const char* id = db->GetString(patch->id);
+
+            // Keep the first patch with an ID
+            u32 slot = patch->hash & mask;
+            for (; index[slot].patch != nullptr; slot = (slot + 1) & mask) {
+                if (index[slot].hash == patch->hash &&
+                    std::strcmp(
+                        index[slot].unit->GetDB()->GetString(
+                            index[slot].patch->id
+                        ),
+                        id
+                    ) == 0) {
+                    break;
+                }
+            }
+
+            if (index[slot].patch == nullptr) {
+                index[slot] = {
+                    .hash = patch->hash,
+                    .unit = riivolution,
+                    .patch = patch,
+                };
+            }
         }
-            )) {
-            return false;
+    }
+
+    s_patchIndex = index;
+    s_patchIndexSize = indexSize;
+    return true;
+}
+
+const RiivolutionDB::Patch*
+PatchManager::FindPatch(const char* patchId, PatchUnitRiivolution** unitOut)
+{
+    if (s_patchIndex == nullptr) {
+        BuildPatchIndex();
+    }
+
+    if (s_patchIndex == nullptr) {
+        // Fall back to searching each unit
+        for (PatchUnit* patchUnit = s_first; patchUnit != nullptr;
+             patchUnit = patchUnit->m_next) {
+            PatchUnitRiivolution* riivolution =
+                PatchUnitRiivolution::Get(patchUnit);
+            if (riivolution == nullptr || !riivolution->IsValid()) {
+                continue;
+            }
+
+            if (auto* patch = riivolution->GetDB()->FindPatch(patchId)) {
+                *unitOut = riivolution;
+                return patch;
+            }
         }
 
-        return true;
+        return nullptr;
+    }
+
+    const u32 hash = RiivolutionDB::HashID(patchId);
+    const u32 mask = s_patchIndexSize - 1;
+    for (u32 slot = hash & mask; s_patchIndex[slot].patch != nullptr;
+         slot = (slot + 1) & mask) {
+        const PatchIndexEntry* entry = &s_patchIndex[slot];
+        if (entry->hash == hash &&
+            std::strcmp(
+                entry->unit->GetDB()->GetString(entry->patch->id), patchId
+            ) == 0) {
+            *unitOut = entry->unit;
+            return entry->patch;
+        }
     }
 
-    PRINT(Patcher, ERROR, "Failed to find patch ID '%s'", patchId);
-    return false;
+    return nullptr;
+}
+
+bool PatchManager::LoadPatchID(const char* patchId)
+{
+    PRINT(Patcher, INFO, "Loading patch ID '%s'", patchId);
+
+    PatchUnitRiivolution* unit;
+    const RiivolutionDB::Patch* patch = FindPatch(patchId, &unit);
+    if (patch == nullptr) {
+        PRINT(Patcher, ERROR, "Failed to find patch ID '%s'", patchId);
+        return false;
+    }
+
+    return unit->HandlePatch(
+        patch, [unit](const PatchUnitRiivolution::PatchNode& node) {
+        return HandlePatchNode(unit, node);
+    }
+    );
 }
 
 bool PatchManager::HandlePatchNode(
-    [[maybe_unused]] PatchUnitRiivolution* unit,
-    const PatchUnitRiivolution::PatchNode& node
+    PatchUnitRiivolution* unit, const PatchUnitRiivolution::PatchNode& node
 )
 {
     if (auto* fileNode = std::get_if<PatchUnitRiivolution::FileNode>(&node)) {
@@ -81,8 +697,185 @@ bool PatchManager::HandlePatchNode(
             return false;
         }
 
+        if (fileNode->external == nullptr) {
+            PRINT(Patcher, ERROR, "File node missing 'external' attribute");
+            return false;
+        }
+
         PRINT(Patcher, INFO, "File node: %s", fileNode->disc);
+        return AddDiscNode(unit, node);
+    }
+
+    if (auto* shiftNode = std::get_if<PatchUnitRiivolution::ShiftNode>(&node)) {
+        if (shiftNode->source == nullptr || shiftNode->destination == nullptr) {
+            PRINT(
+                Patcher, ERROR,
+                "Shift node missing 'source' or 'destination' attribute"
+            );
+            return false;
+        }
+
+        PRINT(
+            Patcher, INFO, "Shift node: %s -> %s", shiftNode->source,
+            shiftNode->destination
+        );
+        return AddDiscNode(unit, node);
+    }
+
+    if (auto* folderNode =
+            std::get_if<PatchUnitRiivolution::FolderNode>(&node)) {
+        return AddFolderPatch(unit, *folderNode);
+    }
+
+    if (auto* memoryNode =
+            std::get_if<PatchUnitRiivolution::MemoryNode>(&node)) {
+        return AddMemoryPatch(*memoryNode);
+    }
+
+    return true;
+}
+
+bool PatchManager::AddDiscNode(
+    PatchUnitRiivolution* unit, const PatchUnitRiivolution::PatchNode& node
+)
+{
+    if (s_discNodeCount == MaxDiscNodes) {
+        PRINT(Patcher, ERROR, "Too many file and shift nodes");
+        return false;
+    }
+
+    DiscNode* discNode = &s_discNodes[s_discNodeCount++];
+    if (auto* fileNode = std::get_if<PatchUnitRiivolution::FileNode>(&node)) {
+        discNode->node = *fileNode;
+    } else {
+        discNode->node = std::get<PatchUnitRiivolution::ShiftNode>(node);
+    }
+    discNode->drive = unit->GetDrive();
+    return true;
+}
+
+bool PatchManager::AddMemoryPatch(
+    const PatchUnitRiivolution::MemoryNode& memoryNode
+)
+{
+    // Skipped rather than failed, so the rest of the patch still applies
+    if (memoryNode.valuefile != nullptr || memoryNode.ocarina) {
+        PRINT(
+            Patcher, WARN, "Unsupported memory node at %08X", memoryNode.offset
+        );
+        return true;
+    }
+
+    if (memoryNode.value == nullptr ||
+        (memoryNode.search && memoryNode.original == nullptr)) {
+        PRINT(Patcher, ERROR, "Memory node missing 'value' or 'original'");
+        return false;
+    }
+
+    if (s_memoryPatchCount == MaxMemoryPatches) {
+        PRINT(Patcher, ERROR, "Too many memory nodes");
+        return false;
+    }
+
+    u8* value = s_memoryData + s_memoryDataSize;
+    const u32 length = MemoryPatcher::DecodeHex(
+        memoryNode.value, value, MaxMemoryData - s_memoryDataSize
+    );
+    if (length == 0) {
+        PRINT(
+            Patcher, ERROR, "Invalid memory node value: %s", memoryNode.value
+        );
+        return false;
+    }
+
+    // A search looks for the original, which can be any length. Otherwise
+    // it's checked before the value is written, so it's the same length.
+    u8* original = nullptr;
+    u32 originalLength = 0;
+    if (memoryNode.original != nullptr) {
+        original = value + length;
+        originalLength = MemoryPatcher::DecodeHex(
+            memoryNode.original, original,
+            MaxMemoryData - s_memoryDataSize - length
+        );
+        if (originalLength == 0 ||
+            (!memoryNode.search && originalLength != length)) {
+            PRINT(
+                Patcher, ERROR, "Invalid memory node original: %s",
+                memoryNode.original
+            );
+            return false;
+        }
+    }
+
+    s_memoryDataSize += length + originalLength;
+    s_memoryPatches[s_memoryPatchCount++] = {
+        .patch =
+            {
+                .address = memoryNode.search
+                               ? nullptr
+                               : reinterpret_cast<u8*>(memoryNode.offset),
+                .value = value,
+                .original = memoryNode.search ? nullptr : original,
+                .length = length,
+                .applied = false,
+            },
+        .search = memoryNode.search,
+        .align = memoryNode.align,
+        .pattern = memoryNode.search ? original : nullptr,
+        .patternLength = memoryNode.search ? originalLength : 0,
+    };
+    return true;
+}
+
+bool PatchManager::AddFolderPatch(
+    PatchUnitRiivolution* unit,
+    const PatchUnitRiivolution::FolderNode& folderNode
+)
+{
+    if (folderNode.disc == nullptr || folderNode.external == nullptr) {
+        PRINT(
+            Patcher, ERROR, "Folder node missing 'disc' or 'external' attribute"
+        );
+        return false;
+    }
+
+    if (s_folderPatchCount == MaxFolderPatches) {
+        PRINT(Patcher, ERROR, "Too many folder nodes");
+        return false;
+    }
+
+    EmuDITypes::FolderPatch* folder = &s_folderPatches[s_folderPatchCount];
+    folder->flags = 0;
+    if (folderNode.recursive) {
+        folder->flags |= EmuDITypes::FOLDER_RECURSIVE;
+    }
+    if (folderNode.resize) {
+        folder->flags |= EmuDITypes::FOLDER_RESIZE;
+    }
+    if (folderNode.create) {
+        folder->flags |= EmuDITypes::FOLDER_CREATE;
+    }
+
+    // The external path is on the device the XML was loaded from
+    const char* separator = folderNode.external[0] == '/' ? "" : "/";
+    if (std::snprintf(
+            folder->discPath, sizeof(folder->discPath), "%s", folderNode.disc
+        ) >= static_cast<s32>(sizeof(folder->discPath)) ||
+        std::snprintf(
+            folder->externalPath, sizeof(folder->externalPath), "%u:%s%s",
+            unit->GetDrive(), separator, folderNode.external
+        ) >= static_cast<s32>(sizeof(folder->externalPath))) {
+        PRINT(
+            Patcher, ERROR, "Folder node path too long: %s", folderNode.disc
+        );
+        return false;
     }
 
+    PRINT(
+        Patcher, INFO, "Folder node: %s -> %s", folder->discPath,
+        folder->externalPath
+    );
+    s_folderPatchCount++;
     return true;
 }
\ No newline at end of file
@@ -1,9 +1,12 @@
 #pragma once
 
+#include "MemoryPatcher.hpp"
 #include "PatchUnit.hpp"
 #include "PatchUnitRiivolution.hpp"
+#include <EmuDITypes.hpp>
 #include <new>
 #include <type_traits>
+#include <variant>
 
 class PatchManager
 {
@@ -29,19 +32,140 @@ public:
         return new (patchUnit) T(args...);
     }
 
+    /**
+     * Reserve temporary space at the end of the patch list area, below any
+     * reserved earlier. Patch units can't grow into it.
+     * @returns The space, or nullptr if there's not enough left.
+     */
+    static char* AllocScratch(u32 size);
+
+    /**
+     * Release all temporary space.
+     */
+    static void FreeScratch();
+
     /**
      * Load one or multiple Riivolution XML files.
      * @param path Path to the XML file or directory containing XML files.
      */
     static bool LoadRiivolutionXML(const char* path);
 
+    /**
+     * Load the XML files in a directory listing.
+     * @param names Names from ISFS_ReadDir.
+     */
+    static bool LoadRiivolutionXMLDir(
+        const char* path, const char (*names)[13], u32 count
+    );
+
+    /**
+     * Load a batch of Riivolution XML files, using the compiled databases
+     * cached on the SD card where they're still up to date.
+     * @param count At most ISFS::EX_READ_FILES_MAX_COUNT.
+     */
+    static bool LoadRiivolutionXMLFiles(const char* const* paths, u32 count);
+
+    /**
+     * Index the patch IDs of every loaded Riivolution unit. Built on the first
+     * lookup after the patch units change.
+     * @returns False if there's no space for the index.
+     */
+    static bool BuildPatchIndex();
+
+    /**
+     * Find a patch in any loaded Riivolution unit. If more than one unit has
+     * the ID, the first one loaded wins.
+     */
+    static const RiivolutionDB::Patch*
+    FindPatch(const char* patchId, PatchUnitRiivolution** unitOut);
+
     static bool LoadPatchID(const char* patchId);
 
     static bool HandlePatchNode(
         PatchUnitRiivolution* unit, const PatchUnitRiivolution::PatchNode& node
     );
 
+    /**
+     * Add a file or shift node to the disc nodes, for the apploader to apply
+     * to the game's FST.
+     */
+    static bool AddDiscNode(
+        PatchUnitRiivolution* unit, const PatchUnitRiivolution::PatchNode& node
+    );
+
+    /**
+     * Get the name of the mount point of a drive, like "sd".
+     */
+    static const char* GetMountName(u32 drive);
+
+    /**
+     * Decode a memory node into the memory patches, for the apploader to apply
+     * to the game's DOL.
+     */
+    static bool
+    AddMemoryPatch(const PatchUnitRiivolution::MemoryNode& memoryNode);
+
+    /**
+     * Add a folder node to the folder patches, for the apploader to expand
+     * against the game's FST.
+     */
+    static bool AddFolderPatch(
+        PatchUnitRiivolution* unit,
+        const PatchUnitRiivolution::FolderNode& folderNode
+    );
+
 public:
     static PatchUnit* s_first;
     static PatchUnit* s_last;
+    // Start of the temporary space, which grows down from the end of the area
+    static u8* s_scratch;
+
+    struct PatchIndexEntry {
+        u32 hash;
+        PatchUnitRiivolution* unit;
+        const RiivolutionDB::Patch* patch;
+    };
+
+    // Open addressed, kept in the temporary space. The size is a power of two.
+    static PatchIndexEntry* s_patchIndex;
+    static u32 s_patchIndexSize;
+
+    struct DiscNode {
+        std::variant<
+            PatchUnitRiivolution::FileNode, PatchUnitRiivolution::ShiftNode>
+            node;
+        // Drive of the external path
+        u32 drive;
+    };
+
+    static constexpr u32 MaxDiscNodes = 256;
+
+    // File and shift nodes of the loaded patches, in document order
+    static DiscNode s_discNodes[MaxDiscNodes];
+    static u32 s_discNodeCount;
+
+    static constexpr u32 MaxMemoryPatches = 256;
+    static constexpr u32 MaxMemoryData = 0x4000;
+
+    struct MemoryPatch {
+        MemoryPatcher::Patch patch;
+        // Patch where the pattern is found instead of at the address
+        bool search;
+        u32 align;
+        const u8* pattern;
+        u32 patternLength;
+    };
+
+    // Memory nodes of the loaded patches, in document order. The value,
+    // original and pattern of each point into s_memoryData.
+    static MemoryPatch s_memoryPatches[MaxMemoryPatches];
+    static u32 s_memoryPatchCount;
+    static u8 s_memoryData[MaxMemoryData];
+    static u32 s_memoryDataSize;
+
+    static constexpr u32 MaxFolderPatches = 32;
+
+    // Folder nodes of the loaded patches, in document order
+    static EmuDITypes::FolderPatch s_folderPatches[MaxFolderPatches];
+    static u32 s_folderPatchCount;
 };
@@ -73,6 +73,19 @@ protected:
         return data;
     }
 
+    /**
+     * Give back the end of the data, after ExpandData reserved more than was
+     * needed. Only valid on the last unit in the list.
+     */
+    void ShrinkData(u32 size)
+    {
+        assert(size <= GetDataSize());
+
+        m_next = reinterpret_cast<PatchUnit*>(GetData() + AlignUp(size, 4));
+        m_next->m_type = Type::DISABLED;
+        m_next->m_next = nullptr;
+    }
+
     PatchUnit* m_next;
     DiskID m_diskId;
     Type m_type = Type::GENERIC;
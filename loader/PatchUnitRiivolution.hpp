@@ -1,8 +1,7 @@
 #pragma once
 
 #include "PatchUnit.hpp"
-#include <IOS.hpp>
-#include <functional>
+#include "RiivolutionDB.hpp"
 #include <variant>
 
 class PatchUnitRiivolution : public PatchUnit
@@ -17,14 +16,29 @@ public:
         return static_cast<PatchUnitRiivolution*>(patchUnit);
     }
 
-    PatchUnitRiivolution(DiskID diskId, const char* xml, s32 size);
+    /**
+     * Compile a Riivolution XML into the unit. The XML is parsed in place and
+     * isn't needed after this returns.
+     * @param xml The XML text, with space for a terminator at xml[size].
+     * @param limit End of the space the unit can use.
+     */
+    PatchUnitRiivolution(
+        DiskID diskId, char* xml, u32 size, const void* limit
+    );
 
-    PatchUnitRiivolution(DiskID diskId, IOS::File& file);
+    /**
+     * Copy an already compiled database into the unit.
+     * @param limit End of the space the unit can use.
+     */
+    PatchUnitRiivolution(
+        DiskID diskId, const RiivolutionDB* db, const void* limit
+    );
 
-    const char* GetXML() const
+    const RiivolutionDB* GetDB() const
     {
-        return reinterpret_cast<const char*>(GetData()) + sizeof(*this) -
-               sizeof(PatchUnit);
+        return reinterpret_cast<const RiivolutionDB*>(
+            GetData() + sizeof(*this) - sizeof(PatchUnit)
+        );
     }
 
     bool IsValid() const
@@ -32,6 +46,20 @@ public:
         return m_valid;
     }
 
+    /**
+     * Get the drive of the device the XML was loaded from. The external paths
+     * of its patches are on this device.
+     */
+    u32 GetDrive() const
+    {
+        return m_drive;
+    }
+
+    void SetDrive(u32 drive)
+    {
+        m_drive = drive;
+    }
+
     bool IsGameID(const char* gameId) const;
 
     bool IsRegion(char region) const;
@@ -84,13 +112,53 @@ public:
     using PatchNode = std::variant<
         FileNode, FolderNode, ShiftNode, SavegameNode, DLCNode, MemoryNode>;
 
-    bool HandlePatch(
-        const char* patchId, std::function<bool(const PatchNode&)> callback
-    );
+    /**
+     * Call a visitor with each node of a patch, in document order.
+     * @param visitor Called as bool(const PatchNode&). Returning false stops
+     * the walk.
+     * @returns False if the visitor stopped the walk.
+     */
+    template <typename TVisitor>
+    bool HandlePatch(const RiivolutionDB::Patch* patch, TVisitor&& visitor)
+    {
+        const RiivolutionDB* db = GetDB();
+        const RiivolutionDB::Node* nodes = db->GetNodes(patch);
+        for (u32 i = 0; i < patch->nodeCount; i++) {
+            if (!visitor(MakePatchNode(db, nodes[i]))) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    /**
+     * Call a visitor with each node of the patch with the given ID.
+     * @returns False if the patch isn't in this unit or the visitor stopped
+     * the walk.
+     */
+    template <typename TVisitor>
+    bool HandlePatch(const char* patchId, TVisitor&& visitor)
+    {
+        if (!m_valid) {
+            return false;
+        }
+
+        const RiivolutionDB::Patch* patch = GetDB()->FindPatch(patchId);
+        if (patch == nullptr) {
+            return false;
+        }
+
+        return HandlePatch(patch, visitor);
+    }
+
+    static PatchNode
+    MakePatchNode(const RiivolutionDB* db, const RiivolutionDB::Node& node);
 
 private:
-    void Init();
+    u32 GetFreeSpace(const void* limit);
 
     char m_gameId[4];
     bool m_valid = false;
+    u8 m_drive = 0;
 };
\ No newline at end of file
@@ -0,0 +1,495 @@
+// RiivolutionDB.cpp - Compiled Riivolution patch database
+//   Written by mkwcat
+
+#include "RiivolutionDB.hpp"
+#include <Log.hpp>
+#include <Util.h>
+#include <XML/rapidxml.hpp>
+#include <cassert>
+#include <cstring>
+
+static constexpr u16 NO_PATCH = 0xFFFF;
+
+// Open addressed table used to intern strings while compiling. Holds string
+// table offsets plus one, so zero is an empty slot.
+static constexpr u32 INTERN_TABLE_SIZE = 4096;
+static u32 s_internTable[INTERN_TABLE_SIZE];
+
+static constexpr struct {
+    const char* name;
+    RiivolutionDB::NodeType type;
+} NODE_NAMES[] = {
+    {"file", RiivolutionDB::NodeType::FILE},
+    {"folder", RiivolutionDB::NodeType::FOLDER},
+    {"shift", RiivolutionDB::NodeType::SHIFT},
+    {"savegame", RiivolutionDB::NodeType::SAVEGAME},
+    {"dlc", RiivolutionDB::NodeType::DLC},
+    {"memory", RiivolutionDB::NodeType::MEMORY},
+};
+
+struct CompileContext {
+    char* strings;
+    u32 stringSize;
+    u32 stringMaxSize;
+    u32 internCount;
+    bool overflow;
+};
+
+/**
+ * FNV-1a hash of a string.
+ */
+static u32 HashString(const char* str)
+{
+    u32 hash = 0x811C9DC5;
+    for (; *str != '\0'; str++) {
+        hash = (hash ^ static_cast<u8>(*str)) * 0x01000193;
+    }
+    return hash;
+}
+
+static bool ProcessBool(const char* value)
+{
+    assert(value != nullptr);
+
+    return not std::strcmp(value, "true") or not std::strcmp(value, "yes");
+}
+
+static u32 ProcessInt(u32 defaultv, const char* value)
+{
+    assert(value != nullptr);
+
+    u32 result = 0;
+
+    if (value[0] == '0' and value[1] == 'x') {
+        // Process hex
+        for (u32 i = 2; value[i] != '\0'; i++) {
+            if (value[i] >= '0' and value[i] <= '9') {
+                result = (result << 4) | (value[i] - '0');
+            } else if (value[i] >= 'A' and value[i] <= 'F') {
+                result = (result << 4) | (value[i] - 'A' + 10);
+            } else if (value[i] >= 'a' and value[i] <= 'f') {
+                result = (result << 4) | (value[i] - 'a' + 10);
+            } else {
+                result = defaultv;
+                break;
+            }
+        }
+    } else {
+        // Process decimal
+        for (u32 i = 0; value[i] != '\0'; i++) {
+            if (value[i] >= '0' and value[i] <= '9') {
+                result = (result * 10) + (value[i] - '0');
+            } else {
+                result = defaultv;
+                break;
+            }
+        }
+    }
+
+    return result;
+}
+
+static bool GetNodeType(const char* name, RiivolutionDB::NodeType* type)
+{
+    for (const auto& nodeName : NODE_NAMES) {
+        if (std::strcmp(name, nodeName.name) == 0) {
+            *type = nodeName.type;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Add a string to the string table, reusing an identical string if one was
+ * already added.
+ */
+static u32 AddString(CompileContext* ctx, const char* str)
+{
+    const u32 mask = INTERN_TABLE_SIZE - 1;
+    u32 slot = HashString(str) & mask;
+
+    // The table is never filled past 3/4, so this always ends on a match or
+    // an empty slot
+    for (; s_internTable[slot] != 0; slot = (slot + 1) & mask) {
+        u32 offset = s_internTable[slot] - 1;
+        if (std::strcmp(ctx->strings + offset, str) == 0) {
+            return offset;
+        }
+    }
+
+    u32 len = std::strlen(str) + 1;
+    if (len > ctx->stringMaxSize - ctx->stringSize) {
+        ctx->overflow = true;
+        return RiivolutionDB::NO_STRING;
+    }
+
+    u32 offset = ctx->stringSize;
+    std::memcpy(ctx->strings + offset, str, len);
+    ctx->stringSize += len;
+
+    if (ctx->internCount < INTERN_TABLE_SIZE / 4 * 3) {
+        s_internTable[slot] = offset + 1;
+        ctx->internCount++;
+    }
+
+    return offset;
+}
+
+static u32 GetString(
+    CompileContext* ctx, const rapidxml::xml_node<char>* node, const char* name
+)
+{
+    auto* attr = node->first_attribute(name);
+    if (attr == nullptr) {
+        return RiivolutionDB::NO_STRING;
+    }
+
+    return AddString(ctx, attr->value());
+}
+
+static u32 GetInt(
+    const rapidxml::xml_node<char>* node, const char* name, u32 defaultv
+)
+{
+    auto* attr = node->first_attribute(name);
+    if (attr == nullptr) {
+        return defaultv;
+    }
+
+    return ProcessInt(defaultv, attr->value());
+}
+
+static u8 GetFlag(
+    const rapidxml::xml_node<char>* node, const char* name, u8 flag
+)
+{
+    auto* attr = node->first_attribute(name);
+    if (attr == nullptr || !ProcessBool(attr->value())) {
+        return 0;
+    }
+
+    return flag;
+}
+
+static void CompileNode(
+    CompileContext* ctx, const rapidxml::xml_node<char>* child,
+    RiivolutionDB::NodeType type, RiivolutionDB::Node* node
+)
+{
+    std::memset(node, 0, sizeof(*node));
+    node->type = type;
+
+    switch (type) {
+    case RiivolutionDB::NodeType::FILE:
+        node->flags = GetFlag(child, "resize", RiivolutionDB::FLAG_RESIZE) |
+                      GetFlag(child, "create", RiivolutionDB::FLAG_CREATE);
+        node->file.disc = GetString(ctx, child, "disc");
+        node->file.external = GetString(ctx, child, "external");
+        node->file.offset = GetInt(child, "offset", 0);
+        node->file.fileoffset = GetInt(child, "fileoffset", 0);
+        node->file.length = GetInt(child, "length", 0);
+        break;
+
+    case RiivolutionDB::NodeType::FOLDER:
+        node->flags =
+            GetFlag(child, "create", RiivolutionDB::FLAG_CREATE) |
+            GetFlag(child, "resize", RiivolutionDB::FLAG_RESIZE) |
+            GetFlag(child, "recursive", RiivolutionDB::FLAG_RECURSIVE);
+        node->folder.disc = GetString(ctx, child, "disc");
+        node->folder.external = GetString(ctx, child, "external");
+        node->folder.length = GetInt(child, "length", 0);
+        break;
+
+    case RiivolutionDB::NodeType::SHIFT:
+        node->shift.source = GetString(ctx, child, "source");
+        node->shift.destination = GetString(ctx, child, "destination");
+        break;
+
+    case RiivolutionDB::NodeType::SAVEGAME:
+        node->flags = GetFlag(child, "clone", RiivolutionDB::FLAG_CLONE);
+        node->savegame.external = GetString(ctx, child, "external");
+        break;
+
+    case RiivolutionDB::NodeType::DLC:
+        node->dlc.external = GetString(ctx, child, "external");
+        break;
+
+    case RiivolutionDB::NodeType::MEMORY:
+        node->flags = GetFlag(child, "search", RiivolutionDB::FLAG_SEARCH) |
+                      GetFlag(child, "ocarina", RiivolutionDB::FLAG_OCARINA);
+        node->memory.valuefile = GetString(ctx, child, "valuefile");
+        node->memory.value = GetString(ctx, child, "value");
+        node->memory.original = GetString(ctx, child, "original");
+        node->memory.offset = GetInt(child, "offset", 0);
+        node->memory.align = GetInt(child, "align", 1);
+        break;
+    }
+}
+
+u32 RiivolutionDB::Compile(
+    const rapidxml::xml_node<char>* root, void* out, u32 maxSize
+)
+{
+    assert(IsAligned(out, 4));
+
+    // Count the patches and nodes to lay out the fixed size sections
+    u32 patchCount = 0;
+    u32 nodeCount = 0;
+    for (auto* patch = root->first_node("patch"); patch != nullptr;
+         patch = patch->next_sibling("patch")) {
+        if (patch->first_attribute("id") == nullptr) {
+            continue;
+        }
+
+        patchCount++;
+
+        for (auto* child = patch->first_node(); child != nullptr;
+             child = child->next_sibling()) {
+            NodeType type;
+            if (child->type() == rapidxml::node_element &&
+                GetNodeType(child->name(), &type)) {
+                nodeCount++;
+            }
+        }
+    }
+
+    if (patchCount >= NO_PATCH) {
+        PRINT(Patcher, ERROR, "Too many patches in Riivolution XML");
+        return 0;
+    }
+
+    // Keep the index at most half full
+    u32 indexSize = 1;
+    while (indexSize < patchCount * 2) {
+        indexSize <<= 1;
+    }
+
+    const u32 patchOffset = sizeof(RiivolutionDB);
+    const u32 indexOffset = patchOffset + patchCount * sizeof(Patch);
+    const u32 nodeOffset =
+        AlignUp(indexOffset + indexSize * sizeof(u16), sizeof(u32));
+    const u32 stringOffset = nodeOffset + nodeCount * sizeof(Node);
+
+    if (stringOffset > maxSize) {
+        PRINT(Patcher, ERROR, "Not enough space to compile Riivolution XML");
+        return 0;
+    }
+
+    u8* base = static_cast<u8*>(out);
+    Patch* patches = reinterpret_cast<Patch*>(base + patchOffset);
+    u16* index = reinterpret_cast<u16*>(base + indexOffset);
+    Node* nodes = reinterpret_cast<Node*>(base + nodeOffset);
+
+    for (u32 i = 0; i < indexSize; i++) {
+        index[i] = NO_PATCH;
+    }
+
+    CompileContext ctx = {
+        .strings = reinterpret_cast<char*>(base + stringOffset),
+        .stringSize = 0,
+        .stringMaxSize = maxSize - stringOffset,
+        .internCount = 0,
+        .overflow = false,
+    };
+    std::memset(s_internTable, 0, sizeof(s_internTable));
+
+    u32 patchIndex = 0;
+    u32 nodeIndex = 0;
+    for (auto* patch = root->first_node("patch"); patch != nullptr;
+         patch = patch->next_sibling("patch")) {
+        auto* id = patch->first_attribute("id");
+        if (id == nullptr) {
+            PRINT(Patcher, WARN, "Patch node missing 'id' attribute");
+            continue;
+        }
+
+        Patch* entry = &patches[patchIndex];
+        entry->hash = HashString(id->value());
+        entry->id = AddString(&ctx, id->value());
+        entry->firstNode = nodeIndex;
+
+        for (auto* child = patch->first_node(); child != nullptr;
+             child = child->next_sibling()) {
+            if (child->type() != rapidxml::node_element) {
+                continue;
+            }
+
+            NodeType type;
+            if (!GetNodeType(child->name(), &type)) {
+                PRINT(Patcher, WARN, "Unknown patch node: %s", child->name());
+                continue;
+            }
+
+            CompileNode(&ctx, child, type, &nodes[nodeIndex++]);
+        }
+
+        entry->nodeCount = nodeIndex - entry->firstNode;
+
+        if (ctx.overflow) {
+            break;
+        }
+
+        // Index the patch. The first patch with an ID wins, as it did when
+        // searching the document.
+        u32 slot = entry->hash & (indexSize - 1);
+        for (; index[slot] != NO_PATCH; slot = (slot + 1) & (indexSize - 1)) {
+            const Patch* other = &patches[index[slot]];
+            if (other->hash == entry->hash &&
+                std::strcmp(ctx.strings + other->id, id->value()) == 0) {
+                break;
+            }
+        }
+
+        if (index[slot] == NO_PATCH) {
+            index[slot] = patchIndex;
+        }
+
+        patchIndex++;
+    }
+
+    if (ctx.overflow) {
+        PRINT(Patcher, ERROR, "Not enough space to compile Riivolution XML");
+        return 0;
+    }
+
+    assert(patchIndex == patchCount);
+    assert(nodeIndex == nodeCount);
+
+    RiivolutionDB* db = reinterpret_cast<RiivolutionDB*>(out);
+    db->m_magic = MAGIC;
+    db->m_size = stringOffset + AlignUp(ctx.stringSize, sizeof(u32));
+    db->m_patchCount = patchCount;
+    db->m_patchOffset = patchOffset;
+    db->m_indexSize = indexSize;
+    db->m_indexOffset = indexOffset;
+    db->m_nodeCount = nodeCount;
+    db->m_nodeOffset = nodeOffset;
+    db->m_stringOffset = stringOffset;
+    db->m_stringSize = ctx.stringSize;
+
+    return db->m_size;
+}
+
+u32 RiivolutionDB::HashID(const char* id)
+{
+    return HashString(id);
+}
+
+/**
+ * Check the header of a database. This checks that every section is in
+ * bounds, not each offset inside the nodes.
+ */
+bool RiivolutionDB::IsValid(u32 size) const
+{
+    if (size < sizeof(RiivolutionDB) || m_magic != MAGIC || m_size > size ||
+        m_indexSize == 0 || (m_indexSize & (m_indexSize - 1)) != 0 ||
+        m_patchCount >= NO_PATCH) {
+        return false;
+    }
+
+    if (m_patchOffset < sizeof(RiivolutionDB) ||
+        m_patchOffset + m_patchCount * sizeof(Patch) > m_indexOffset ||
+        m_indexOffset + m_indexSize * sizeof(u16) > m_nodeOffset ||
+        m_nodeOffset + m_nodeCount * sizeof(Node) > m_stringOffset ||
+        m_stringOffset + m_stringSize > m_size ||
+        !IsAligned(m_patchOffset | m_indexOffset | m_nodeOffset, 4)) {
+        return false;
+    }
+
+    if (m_stringSize != 0 &&
+        GetBase()[m_stringOffset + m_stringSize - 1] != '\0') {
+        return false;
+    }
+
+    const Patch* patches =
+        reinterpret_cast<const Patch*>(GetBase() + m_patchOffset);
+    for (u32 i = 0; i < m_patchCount; i++) {
+        if (patches[i].id >= m_stringSize ||
+            patches[i].firstNode > m_nodeCount ||
+            patches[i].nodeCount > m_nodeCount - patches[i].firstNode) {
+            return false;
+        }
+    }
+
+    const u16* index = reinterpret_cast<const u16*>(GetBase() + m_indexOffset);
+    for (u32 i = 0; i < m_indexSize; i++) {
+        if (index[i] != NO_PATCH && index[i] >= m_patchCount) {
+            return false;
+        }
+    }
+
+    auto isString = [this](u32 offset) {
+        return offset == NO_STRING || offset < m_stringSize;
+    };
+
+    const Node* nodes = reinterpret_cast<const Node*>(GetBase() + m_nodeOffset);
+    for (u32 i = 0; i < m_nodeCount; i++) {
+        const Node& node = nodes[i];
+        bool valid;
+        switch (node.type) {
+        case NodeType::FILE:
+            valid = isString(node.file.disc) && isString(node.file.external);
+            break;
+
+        case NodeType::FOLDER:
+            valid =
+                isString(node.folder.disc) && isString(node.folder.external);
+            break;
+
+        case NodeType::SHIFT:
+            valid = isString(node.shift.source) &&
+                    isString(node.shift.destination);
+            break;
+
+        case NodeType::SAVEGAME:
+            valid = isString(node.savegame.external);
+            break;
+
+        case NodeType::DLC:
+            valid = isString(node.dlc.external);
+            break;
+
+        case NodeType::MEMORY:
+            valid = isString(node.memory.valuefile) &&
+                    isString(node.memory.value) &&
+                    isString(node.memory.original);
+            break;
+
+        default:
+            valid = false;
+            break;
+        }
+
+        if (!valid) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+const RiivolutionDB::Patch* RiivolutionDB::FindPatch(const char* id) const
+{
+    const u32 hash = HashString(id);
+    const u32 mask = m_indexSize - 1;
+    const Patch* patches = GetPatches();
+    const u16* index = reinterpret_cast<const u16*>(GetBase() + m_indexOffset);
+
+    for (u32 i = 0, slot = hash & mask; i < m_indexSize;
+         i++, slot = (slot + 1) & mask) {
+        if (index[slot] == NO_PATCH) {
+            return nullptr;
+        }
+
+        // Only compare the ID on a full hash match
+        const Patch* patch = &patches[index[slot]];
+        if (patch->hash == hash &&
+            std::strcmp(GetString(patch->id), id) == 0) {
+            return patch;
+        }
+    }
+
+    return nullptr;
+}
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <Types.h>
+
+namespace rapidxml
+{
+template <class Ch>
+class xml_node;
+}
+
+// Compiled form of a Riivolution XML. Everything past the header is addressed
+// by an offset from the start of the database, so it can be moved or written
+// out and loaded back as is. The layout is:
+//   RiivolutionDB header
+//   Patch[patchCount]
+//   u16 index[indexSize], open addressed by the patch ID hash
+//   Node[nodeCount], each patch's nodes stored together in document order
+//   Interned NUL-terminated strings
+class RiivolutionDB
+{
+public:
+    static constexpr u32 MAGIC = 0x52444231; // RDB1
+    static constexpr u32 NO_STRING = 0xFFFFFFFF;
+
+    enum class NodeType : u8 {
+        FILE,
+        FOLDER,
+        SHIFT,
+        SAVEGAME,
+        DLC,
+        MEMORY,
+    };
+
+    enum NodeFlag : u8 {
+        FLAG_RESIZE = 1 << 0,
+        FLAG_CREATE = 1 << 1,
+        FLAG_RECURSIVE = 1 << 2,
+        FLAG_CLONE = 1 << 3,
+        FLAG_SEARCH = 1 << 4,
+        FLAG_OCARINA = 1 << 5,
+    };
+
+    // Strings are offsets into the string table, or NO_STRING if the
+    // attribute was missing. Missing numbers hold their default value.
+    struct Node {
+        NodeType type;
+        u8 flags;
+        u16 reserved;
+
+        union {
+            struct {
+                u32 disc;
+                u32 external;
+                u32 offset;
+                u32 fileoffset;
+                u32 length;
+            } file;
+
+            struct {
+                u32 disc;
+                u32 external;
+                u32 length;
+            } folder;
+
+            struct {
+                u32 source;
+                u32 destination;
+            } shift;
+
+            struct {
+                u32 external;
+            } savegame;
+
+            struct {
+                u32 external;
+            } dlc;
+
+            struct {
+                u32 valuefile;
+                u32 value;
+                u32 original;
+                u32 offset;
+                u32 align;
+            } memory;
+        };
+    };
+
+    static_assert(sizeof(Node) == 0x18);
+
+    struct Patch {
+        u32 hash;
+        u32 id;
+        u32 firstNode;
+        u32 nodeCount;
+    };
+
+    /**
+     * Compile a parsed Riivolution XML document.
+     * @param root The root element of the document.
+     * @param out Where to write the database. Must be 4 byte aligned.
+     * @param maxSize Space available at out.
+     * @returns The size of the database, or 0 on error.
+     */
+    static u32 Compile(
+        const rapidxml::xml_node<char>* root, void* out, u32 maxSize
+    );
+
+    /**
+     * Hash a patch ID the way the index does.
+     */
+    static u32 HashID(const char* id);
+
+    /**
+     * Check the header, patches, index and nodes of a database, so a cached
+     * copy read back from the disk can be used without further checks.
+     */
+    bool IsValid(u32 size) const;
+
+    u32 GetSize() const
+    {
+        return m_size;
+    }
+
+    u32 GetPatchCount() const
+    {
+        return m_patchCount;
+    }
+
+    const Patch* GetPatches() const
+    {
+        return reinterpret_cast<const Patch*>(GetBase() + m_patchOffset);
+    }
+
+    /**
+     * Find a patch by its ID.
+     * @returns The patch, or nullptr if there is no patch with the ID.
+     */
+    const Patch* FindPatch(const char* id) const;
+
+    const Node* GetNodes(const Patch* patch) const
+    {
+        return reinterpret_cast<const Node*>(GetBase() + m_nodeOffset) +
+               patch->firstNode;
+    }
+
+    /**
+     * Get a string by its offset, or nullptr for NO_STRING.
+     */
+    const char* GetString(u32 offset) const
+    {
+        if (offset == NO_STRING) {
+            return nullptr;
+        }
+
+        return reinterpret_cast<const char*>(GetBase()) + m_stringOffset +
+               offset;
+    }
+
+private:
+    const u8* GetBase() const
+    {
+        return reinterpret_cast<const u8*>(this);
+    }
+
+    u32 m_magic;
+    u32 m_size;
+    u32 m_patchCount;
+    u32 m_patchOffset;
+    // Power of two
+    u32 m_indexSize;
+    u32 m_indexOffset;
+    u32 m_nodeCount;
+    u32 m_nodeOffset;
+    u32 m_stringOffset;
+    u32 m_stringSize;
+};
@@ -5,6 +5,7 @@
 #include <IOS.hpp>
 #include <Log.hpp>
 #include <SHA.hpp>
+#include <cstddef>
 #include <optional>
 
 /**
@@ -187,8 +188,8 @@ static void RMDispatchCommand(
  */
 void StarlingIOS::RMHandleCommands()
 {
-    DeviceStarlingTypes::CommandData* data =
-        reinterpret_cast<DeviceStarlingTypes::CommandData*>( //
+    DeviceStarlingTypes::CommandRing* ring =
+        reinterpret_cast<DeviceStarlingTypes::CommandRing*>( //
             COMMAND_DATA_ADDRESS
         );
 
@@ -196,22 +197,52 @@ void StarlingIOS::RMHandleCommands()
     s_commandContext.diskId = DeviceStarlingTypes::MAX_DISK_COUNT;
 
     while (true) {
-        s32 result = s_rm.Ioctl(
-            DeviceStarlingTypes::Ioctl::RECEIVE_COMMAND, nullptr, 0, data,
-            COMMAND_DATA_MAXLEN
+        // Only IOS writes writeIndex, and readIndex is flushed after every
+        // write here, so both header lines can be invalidated
+        CPUCache::DCInvalidate(
+            ring, offsetof(DeviceStarlingTypes::CommandRing, entries)
         );
-
-        if (result < 0) {
-            PRINT(
-                System, ERROR, "Received error from command hook: %d", result
+        u32 readIndex = ring->readIndex;
+        u32 writeIndex = ring->writeIndex;
+
+        if (readIndex == writeIndex) {
+            // IOS replies once the next command is pushed
+            s32 result = s_rm.Ioctl(
+                DeviceStarlingTypes::Ioctl::WAIT_COMMAND, nullptr, 0, nullptr,
+                0
             );
-            break;
+
+            if (result < 0) {
+                PRINT(
+                    System, ERROR, "Received error from command hook: %d",
+                    result
+                );
+                break;
+            }
+
+            if (result == s32(DeviceStarlingTypes::Command::CLOSE_REPLY)) {
+                break;
+            }
+
+            continue;
+        }
+
+        // Handle everything pushed so far before waiting again
+        bool done = false;
+        for (; readIndex != writeIndex && !done; readIndex++) {
+            DeviceStarlingTypes::CommandEntry* entry = &ring->entries
+                [readIndex % DeviceStarlingTypes::CommandRing::ENTRY_COUNT];
+            CPUCache::DCInvalidate(entry, sizeof(*entry));
+
+            RMDispatchCommand(entry->command, &entry->data);
+            done = entry->command == DeviceStarlingTypes::Command::DONE;
         }
 
-        auto command = static_cast<DeviceStarlingTypes::Command>(result);
-        RMDispatchCommand(command, data);
+        // Release the entries back to IOS
+        ring->readIndex = readIndex;
+        CPUCache::DCFlush(&ring->readIndex, sizeof(u32));
 
-        if (command == DeviceStarlingTypes::Command::DONE) {
+        if (done) {
             break;
         }
     }
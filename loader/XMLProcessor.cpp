@@ -2,8 +2,6 @@
 //   Written by mkwcat
 
 #include "XMLProcessor.hpp"
-#include "PatchUnit.hpp"
-#include "PatchUnitRiivolution.hpp"
 #include <Log.hpp>
 #include <XML/rapidxml.hpp>
 #include <csetjmp>
@@ -11,31 +9,10 @@
 
 static rapidxml::xml_document s_doc;
 
-XMLProcessor* XMLProcessor::Get(PatchUnit* patchUnit)
-{
-    static XMLProcessor s_processor;
-
-    if (s_processor.m_patchUnit == patchUnit) {
-        return &s_processor;
-    }
-
-    s_processor.~XMLProcessor();
-    return new (&s_processor)
-        XMLProcessor(patchUnit, PatchUnitRiivolution::Get(patchUnit)->GetXML());
-}
-
-XMLProcessor::XMLProcessor()
-  : m_patchUnit(nullptr)
-  , m_doc(s_doc)
-  , m_valid(false)
-{
-}
-
 static std::jmp_buf s_errorHandler;
 
-XMLProcessor::XMLProcessor(PatchUnit* patchUnit, const char* xml)
-  : m_patchUnit(patchUnit)
-  , m_doc(s_doc)
+XMLProcessor::XMLProcessor(char* xml)
+  : m_doc(s_doc)
   , m_valid(false)
 {
     if (setjmp(s_errorHandler)) {
@@ -44,7 +21,7 @@ XMLProcessor::XMLProcessor(PatchUnit* patchUnit, const char* xml)
 
     new (&m_doc) rapidxml::xml_document<char>();
 
-    m_doc.parse<0>(const_cast<char*>(xml));
+    m_doc.parse<0>(xml);
 
     if (m_doc.first_node() == nullptr) {
         return;
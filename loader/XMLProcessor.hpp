@@ -1,7 +1,5 @@
 #pragma once
 
-class PatchUnit;
-
 namespace rapidxml
 {
 template<class Ch>
@@ -11,11 +9,11 @@ class xml_document;
 class XMLProcessor
 {
 public:
-    static XMLProcessor* Get(PatchUnit* patchUnit);
-
-    XMLProcessor();
-
-    XMLProcessor(PatchUnit* patchUnit, const char* xml);
+    /**
+     * Parse an XML document in place. The document is only valid until the
+     * next XMLProcessor is constructed.
+     */
+    XMLProcessor(char* xml);
 
     ~XMLProcessor();
 
@@ -32,7 +30,6 @@ public:
     }
 
 private:
-    PatchUnit* m_patchUnit;
     rapidxml::xml_document<char>& m_doc;
     bool m_valid;
 };
\ No newline at end of file
@@ -0,0 +1,133 @@
+import struct
+
+
+# Legacy frame, as written by lz4 -l. Every block is independent and holds up
+# to 8 MiB, so a loader archive is always a single block.
+LZ4_LEGACY_MAGIC = 0x184c2102
+LZ4_LEGACY_BLOCK_SIZE = 0x800000
+
+LZ4_MIN_MATCH = 0x4
+LZ4_MAX_OFFSET = 0xffff
+# The last match must start this far before the end of the block
+LZ4_MF_LIMIT = 0xc
+# And end this far before it
+LZ4_LAST_LITERALS = 0x5
+LZ4_MAX_CHAIN = 0x40
+
+
+def unpack_lz4_block(in_data, in_offset, in_end, out_data):
+    out_start = len(out_data)
+    while in_offset < in_end:
+        token = in_data[in_offset]
+        in_offset += 0x1
+        literal_size = token >> 4
+        if literal_size == 0xf:
+            while True:
+                val = in_data[in_offset]
+                in_offset += 0x1
+                literal_size += val
+                if val != 0xff:
+                    break
+        out_data += in_data[in_offset:in_offset + literal_size]
+        in_offset += literal_size
+        if in_offset >= in_end:
+            break
+        ref_offset = struct.unpack_from('<H', in_data, in_offset)[0]
+        in_offset += 0x2
+        ref_size = (token & 0xf) + LZ4_MIN_MATCH
+        if ref_size == 0xf + LZ4_MIN_MATCH:
+            while True:
+                val = in_data[in_offset]
+                in_offset += 0x1
+                ref_size += val
+                if val != 0xff:
+                    break
+        assert(0 < ref_offset <= len(out_data) - out_start)
+        for _ in range(ref_size):
+            out_data.append(out_data[-ref_offset])
+    assert(in_offset == in_end)
+
+def unpack_lz4(in_data):
+    assert(struct.unpack_from('<I', in_data, 0x0)[0] == LZ4_LEGACY_MAGIC)
+    in_offset = 0x4
+    out_data = bytearray()
+    while in_offset < len(in_data):
+        block_size = struct.unpack_from('<I', in_data, in_offset)[0]
+        in_offset += 0x4
+        unpack_lz4_block(in_data, in_offset, in_offset + block_size, out_data)
+        in_offset += block_size
+    return out_data
+
+def pack_lz4_size(val):
+    out_data = bytearray()
+    while val >= 0xff:
+        out_data.append(0xff)
+        val -= 0xff
+    out_data.append(val)
+    return out_data
+
+def pack_lz4_sequence(out_data, literals, ref_offset, ref_size):
+    literal_size = len(literals)
+    token = min(literal_size, 0xf) << 4
+    if ref_offset is not None:
+        token |= min(ref_size - LZ4_MIN_MATCH, 0xf)
+    out_data.append(token)
+    if literal_size >= 0xf:
+        out_data += pack_lz4_size(literal_size - 0xf)
+    out_data += literals
+    if ref_offset is not None:
+        out_data += struct.pack('<H', ref_offset)
+        if ref_size - LZ4_MIN_MATCH >= 0xf:
+            out_data += pack_lz4_size(ref_size - LZ4_MIN_MATCH - 0xf)
+
+def pack_lz4_block(in_data):
+    in_size = len(in_data)
+    match_limit = in_size - LZ4_MF_LIMIT
+    ref_end = in_size - LZ4_LAST_LITERALS
+    out_data = bytearray()
+
+    patterns = {}
+    in_offset = 0x0
+    literal_offset = 0x0
+    while in_offset < match_limit:
+        pattern = in_data[in_offset:in_offset + LZ4_MIN_MATCH]
+        ref_offsets = patterns.setdefault(pattern, [])
+        best_ref_size = 0x0
+        for ref_offset in reversed(ref_offsets[-LZ4_MAX_CHAIN:]):
+            if in_offset - ref_offset > LZ4_MAX_OFFSET:
+                break
+            ref_size = LZ4_MIN_MATCH
+            while in_offset + ref_size < ref_end and \
+                  in_data[ref_offset + ref_size] == in_data[in_offset + ref_size]:
+                ref_size += 0x1
+            if ref_size > best_ref_size:
+                best_ref_size = ref_size
+                best_ref_offset = ref_offset
+        ref_offsets.append(in_offset)
+        if best_ref_size < LZ4_MIN_MATCH or in_offset + best_ref_size > ref_end:
+            in_offset += 0x1
+            continue
+        pack_lz4_sequence(
+            out_data,
+            in_data[literal_offset:in_offset],
+            in_offset - best_ref_offset,
+            best_ref_size,
+        )
+        next_in_offset = in_offset + best_ref_size
+        in_offset += 0x1
+        while in_offset < min(next_in_offset, match_limit):
+            pattern = in_data[in_offset:in_offset + LZ4_MIN_MATCH]
+            patterns.setdefault(pattern, []).append(in_offset)
+            in_offset += 0x1
+        in_offset = next_in_offset
+        literal_offset = in_offset
+    pack_lz4_sequence(out_data, in_data[literal_offset:], None, None)
+    return out_data
+
+def pack_lz4(in_data):
+    out_data = bytearray(struct.pack('<I', LZ4_LEGACY_MAGIC))
+    for offset in range(0x0, max(len(in_data), 0x1), LZ4_LEGACY_BLOCK_SIZE):
+        block = pack_lz4_block(in_data[offset:offset + LZ4_LEGACY_BLOCK_SIZE])
+        out_data += struct.pack('<I', len(block))
+        out_data += block
+    return bytes(out_data)
@@ -12,6 +12,7 @@ from bmg import unpack_bmg, pack_bmg
 from brctr import unpack_brctr, pack_brctr
 from brlan import unpack_brlan, pack_brlan
 from brlyt import unpack_brlyt, pack_brlyt
+from lz4 import unpack_lz4, pack_lz4
 from u8 import unpack_u8, pack_u8
 from yaz import unpack_yaz, pack_yaz
 
@@ -67,7 +68,7 @@ def decode_u8(in_path, out_path, retained, renamed):
         in_data = in_file.read()
     magic = in_data[0:4]
     ext = in_path.split(os.extsep)[-1]
-    if ext != 'lzma':
+    if ext != 'lzma' and ext != 'lz4':
         expected_magic = {
             'arc': b'U\xaa8-',
             'szs': b'Yaz0',
@@ -80,13 +81,16 @@ def decode_u8(in_path, out_path, retained, renamed):
         in_data = unpack_yaz(in_data)
     elif ext == 'lzma':
         in_data = lzma.decompress(in_data)
+    elif ext == 'lz4':
+        in_data = unpack_lz4(in_data)
     root = unpack_u8(in_data)
     if out_path is None:
         out_path = in_path + '.d'
     decode_u8_node(out_path, root, retained, renamed)
 
 def decode(in_path, out_path, retained, renamed):
-    if in_path.endswith('.arc') or in_path.endswith('.szs') or in_path.endswith('.arc.lzma'):
+    if in_path.endswith('.arc') or in_path.endswith('.szs') or in_path.endswith('.arc.lzma') or \
+       in_path.endswith('.arc.lz4'):
         decode_u8(in_path, out_path, retained, renamed)
         return
     ext = in_path.split(os.extsep)[-1]
@@ -156,13 +160,16 @@ def encode_u8(in_path, out_path, retained, renamed):
         out_data = pack_yaz(out_data)
     elif ext == 'lzma':
         out_data = lzma.compress(out_data, lzma.FORMAT_ALONE)
+    elif ext == 'lz4':
+        out_data = pack_lz4(out_data)
     if out_path is None:
         out_path = os.path.splitext(in_path)[0]
     with open(out_path, 'wb') as out_file:
         out_file.write(out_data)
 
 def encode(in_path, out_path, retained, renamed):
-    if in_path.endswith('.arc.d') or in_path.endswith('.szs.d') or in_path.endswith('.arc.lzma.d'):
+    if in_path.endswith('.arc.d') or in_path.endswith('.szs.d') or in_path.endswith('.arc.lzma.d') or \
+       in_path.endswith('.arc.lz4.d'):
         encode_u8(in_path, out_path, retained, renamed)
         return
     ext = in_path.split(os.extsep)[-2]